@@ -0,0 +1,261 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 25, 2026, 3:45 PM
+ *
+ * @ingroup CKPT
+ */
+
+/********************************* Includes **********************************/
+#include "CKPT_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Bytes in a trailer */
+#define CKPT_TRAILER 12
+
+/** @brief Offset of the trailer within the last block of a slot */
+#define CKPT_TRAILER_OFFSET (512 - CKPT_TRAILER)
+
+/*
+ * A slot holds the len bytes of the snapshot from its first byte on, and the
+ * trailer in the last 12 bytes of its last block. Layout of a trailer,
+ * little-endian:
+ *   0 'C', 'K'
+ *   2 sequence number. The snapshot with sequence number n is in slot n % 2
+ *   6 bytes in the snapshot
+ *   8 CRC16 of the snapshot
+ *   10 CRC16 of bytes 0 to 9
+ */
+
+/************************ Private Function Prototypes ************************/
+static unsigned char CKPT_ReadTrailer(
+    CKPT_Area_t* area,
+    unsigned char slot,
+    unsigned long* seq,
+    unsigned short* crc
+);
+static unsigned char CKPT_Stream(
+    CKPT_Area_t* area,
+    unsigned char slot,
+    unsigned char* state,
+    unsigned short crc
+);
+
+/***************************** Public Functions ******************************/
+unsigned char CKPT_Open(
+    CKPT_Area_t* area,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned short len
+)
+{
+    unsigned short slotBlocks;
+    unsigned long seq;
+    unsigned short crc;
+
+    slotBlocks = (unsigned short)(
+        ((unsigned long)len + CKPT_TRAILER + 511) / 512
+    );
+    if(numBlocks < 2UL * slotBlocks){
+        return 0;
+    }
+
+    area->card = card;
+    area->startBlock = startBlock;
+    area->seq = 0;
+    area->len = len;
+    area->slotBlocks = slotBlocks;
+
+    // Saves go to the slot after the latest snapshot's, so it has to be
+    // known even if nothing is restored. A save that was interrupted leaves
+    // the older trailer in its slot, so the newest trailer is always that of
+    // a complete snapshot
+    for(unsigned char i = 0; i < 2; i++){
+        if(CKPT_ReadTrailer(area, i, &seq, &crc) && (seq > area->seq)){
+            area->seq = seq;
+        }
+    }
+    return 1;
+}
+
+unsigned char CKPT_Save(CKPT_Area_t* area, const unsigned char* state){
+    unsigned char trailer[CKPT_TRAILER];
+    unsigned long seq = area->seq + 1;
+    unsigned short off = 0;
+    unsigned short chunk;
+    unsigned short crc = 0;
+    SD_IOVec_t iov[3];
+
+    SD_MBW_Start(
+        area->card,
+        area->startBlock + (seq % 2) * area->slotBlocks,
+        area->slotBlocks
+    );
+
+    for(unsigned short b = 0; b < area->slotBlocks; b++){
+        chunk = (area->len - off > 512) ? 512 : area->len - off;
+        for(unsigned short i = 0; i < chunk; i++){
+            crc = SD_CRC16(crc, state[off + i]);
+        }
+        iov[0].base = state + off;
+        iov[0].len = chunk;
+        off += chunk;
+
+        if(b != area->slotBlocks - 1){
+            if(!SD_MBW_SendV(area->card, iov, 1)){
+                SD_MBW_Stop(area->card);
+                return 0;
+            }
+            continue;
+        }
+
+        // The trailer goes out with the last block, after all of the data
+        trailer[0] = 'C';
+        trailer[1] = 'K';
+        SD_Store16(&trailer[2], (unsigned short)seq);
+        SD_Store16(&trailer[4], (unsigned short)(seq >> 16));
+        SD_Store16(&trailer[6], area->len);
+        SD_Store16(&trailer[8], crc);
+        crc = 0;
+        for(unsigned char i = 0; i < 10; i++){
+            crc = SD_CRC16(crc, trailer[i]);
+        }
+        SD_Store16(&trailer[10], crc);
+
+        iov[1].base = NULL;
+        iov[1].len = CKPT_TRAILER_OFFSET - chunk;
+        iov[2].base = trailer;
+        iov[2].len = CKPT_TRAILER;
+        if(!SD_MBW_SendV(area->card, iov, 3)){
+            SD_MBW_Stop(area->card);
+            return 0;
+        }
+    }
+
+    if(!SD_MBW_Stop(area->card)){
+        return 0;
+    }
+    area->seq = seq;
+    return 1;
+}
+
+unsigned char CKPT_Restore(CKPT_Area_t* area, unsigned char* state){
+    unsigned long seq[2];
+    unsigned short crc[2];
+    unsigned char valid[2];
+    unsigned char slot;
+
+    for(unsigned char i = 0; i < 2; i++){
+        valid[i] = CKPT_ReadTrailer(area, i, &seq[i], &crc[i]);
+    }
+
+    // Newest slot first, then the other one if its data is bad
+    slot = (valid[1] && (!valid[0] || (seq[1] > seq[0]))) ? 1 : 0;
+    for(unsigned char i = 0; i < 2; i++){
+        if(valid[slot] && CKPT_Stream(area, slot, state, crc[slot])){
+            area->seq = seq[slot];
+            return 1;
+        }
+        slot ^= 1;
+    }
+
+    area->seq = 0;
+    return 0;
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Reads the trailer of a slot, without a 512 byte buffer
+ * @param area Pointer to the slots
+ * @param slot Slot
+ * @param seq Set to the sequence number of the snapshot in the slot
+ * @param crc Set to the CRC16 of the snapshot in the slot
+ * @return 1 if the trailer is valid and for a snapshot of this size in this
+ *         slot, 0 otherwise
+ */
+static unsigned char CKPT_ReadTrailer(
+    CKPT_Area_t* area,
+    unsigned char slot,
+    unsigned long* seq,
+    unsigned short* crc
+)
+{
+    unsigned char trailer[CKPT_TRAILER];
+    unsigned short c = 0;
+    SD_IOVec_t iov[2];
+
+    iov[0].base = NULL;
+    iov[0].len = CKPT_TRAILER_OFFSET;
+    iov[1].base = trailer;
+    iov[1].len = CKPT_TRAILER;
+    if(!SD_SingleBlockReadV(
+            area->card,
+            area->startBlock + (slot + 1UL) * area->slotBlocks - 1,
+            iov,
+            2
+        )
+    )
+    {
+        return 0;
+    }
+
+    for(unsigned char i = 0; i < 10; i++){
+        c = SD_CRC16(c, trailer[i]);
+    }
+    if((trailer[0] != 'C') || (trailer[1] != 'K') ||
+       (c != SD_Load16(&trailer[10])) ||
+       (SD_Load16(&trailer[6]) != area->len)){
+        return 0;
+    }
+
+    *seq = (unsigned long)SD_Load16(&trailer[2]) |
+           ((unsigned long)SD_Load16(&trailer[4]) << 16);
+    *crc = SD_Load16(&trailer[8]);
+    return (*seq % 2) == slot;
+}
+
+/**
+ * @brief Streams the snapshot in a slot into the state with one multiple
+ *        block read, and checks it against its CRC
+ * @param area Pointer to the slots
+ * @param slot Slot
+ * @param state Pointer to the array that will store the len bytes of state
+ * @param crc CRC16 of the snapshot, from the trailer
+ * @return 1 if successful, 0 if the card couldn't be read or the CRC failed
+ */
+static unsigned char CKPT_Stream(
+    CKPT_Area_t* area,
+    unsigned char slot,
+    unsigned char* state,
+    unsigned short crc
+)
+{
+    unsigned short off = 0;
+    unsigned short chunk;
+    unsigned short c = 0;
+    SD_IOVec_t iov[1];
+
+    if(!SD_MBR_Start(area->card, area->startBlock + slot * area->slotBlocks)){
+        return 0;
+    }
+
+    // The rest of the last block, including the trailer, is discarded
+    for(unsigned short b = 0; b < area->slotBlocks; b++){
+        chunk = (area->len - off > 512) ? 512 : area->len - off;
+        iov[0].base = state + off;
+        iov[0].len = chunk;
+        if(!SD_MBR_ReceiveV(area->card, iov, 1)){
+            SD_MBR_Stop(area->card);
+            return 0;
+        }
+        for(unsigned short i = 0; i < chunk; i++){
+            c = SD_CRC16(c, state[off + i]);
+        }
+        off += chunk;
+    }
+
+    SD_MBR_Stop(area->card);
+    return c == crc;
+}
\ No newline at end of file
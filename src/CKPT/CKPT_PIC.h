@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 25, 2026, 3:45 PM
+ *
+ * @defgroup CKPT
+ * @brief A/B checkpoints of application state kept in RAM. Each snapshot is
+ *        written to the older of two slots with one pre-erased multiple block
+ *        write, straight from the state, ending with a trailer holding a
+ *        sequence number and CRCs. Restoring reads the two trailers and
+ *        streams the newest valid slot back into the state with one multiple
+ *        block read. A power failure during a checkpoint leaves the slot's
+ *        old trailer in place, since the trailer is written last, and the
+ *        data no longer matches that trailer's CRC, so the previous snapshot
+ *        is restored
+ * @{
+ */
+
+#ifndef CKPT_PIC_H
+#define CKPT_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Types ************************************/
+/** @brief A pair of checkpoint slots */
+typedef struct{
+    SDCard_t* card;            /**< Card holding the slots */
+    unsigned long startBlock;  /**< First block of slot 0. Slot 1 follows */
+    unsigned long seq;         /**< Sequence number of the latest snapshot, or
+                                *   0 if there is none */
+    unsigned short len;        /**< Bytes in a snapshot */
+    unsigned short slotBlocks; /**< Blocks in each slot */
+}CKPT_Area_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Sets up the slots for snapshots of a given size, and reads the two
+ *        trailers to find the slot of the latest snapshot
+ * @pre The card has been initialized using initSD
+ * @param area Pointer to the slots
+ * @param card Pointer to the card
+ * @param startBlock First block of the region
+ * @param numBlocks Blocks in the region. Each slot needs enough blocks for
+ *        len + 12 bytes
+ * @param len Bytes in a snapshot
+ * @return 1 if successful, 0 if the region is too small
+ */
+unsigned char CKPT_Open(
+    CKPT_Area_t* area,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned short len
+);
+
+/**
+ * @brief Writes a snapshot of the state to the slot not holding the latest
+ *        one, with a single multiple block write
+ * @param area Pointer to the slots
+ * @param state Pointer to the len bytes of state
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char CKPT_Save(CKPT_Area_t* area, const unsigned char* state);
+
+/**
+ * @brief Restores the newest valid snapshot into the state. The trailers of
+ *        both slots are read, then the newest slot is streamed with a single
+ *        multiple block read. If its data fails the CRC, the other slot is
+ *        tried
+ * @pre The card has been initialized using initSD
+ * @param area Pointer to the slots
+ * @param state Pointer to the array that will store the len bytes of state
+ * @return 1 if successful, 0 if neither slot holds a valid snapshot, in which
+ *         case the state may have been partly overwritten
+ */
+unsigned char CKPT_Restore(CKPT_Area_t* area, unsigned char* state);
+
+/**
+ * @}
+ */
+
+#endif	/* CKPT_PIC_H */
\ No newline at end of file
@@ -0,0 +1,421 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 23, 2026, 3:40 PM
+ *
+ * @ingroup CLOG
+ */
+
+/********************************* Includes **********************************/
+#include "CLOG_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Bytes at the start of each sector taken by the sector header */
+#define CLOG_HEADER 8
+
+/** @brief Sequence number reported for sectors that don't belong to the log */
+#define CLOG_NONE 0xFFFFFFFFUL
+
+/*
+ * Layout of the sector header, little-endian:
+ *   0 'C', 'L'
+ *   2 sequence number. Sector n of the ring holds sequence numbers n,
+ *     n + numBlocks, n + 2 * numBlocks, ...
+ *   6 CRC16 of bytes 0 to 5 followed by the payload
+ */
+
+/************************ Private Function Prototypes ************************/
+static unsigned short CLOG_SectorCRC(
+    const unsigned char* hdr,
+    const unsigned char* data
+);
+static unsigned long CLOG_Check(
+    const CLOG_Log_t* log,
+    const unsigned char* hdr,
+    unsigned long idx
+);
+static unsigned char CLOG_Peek(
+    CLOG_Log_t* log,
+    unsigned long idx,
+    unsigned long* seq
+);
+static void CLOG_Forget(CLOG_Log_t* log, unsigned char numChunks);
+static unsigned char CLOG_Begin(CLOG_Log_t* log);
+
+/***************************** Public Functions ******************************/
+unsigned char CLOG_Open(
+    CLOG_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks
+)
+{
+    unsigned long chunk = card->auBlocks;
+    unsigned long base = 0;
+    unsigned long first;
+    unsigned long seq;
+    unsigned long lo;
+    unsigned long hi;
+    unsigned long mid;
+    unsigned long idx[4];
+
+    if(chunk == 0){
+        chunk = CLOG_DEFAULT_CHUNK_BLOCKS;
+    }
+    numBlocks -= numBlocks % chunk;
+    if(numBlocks < 2 * chunk){
+        return 0;
+    }
+
+    log->card = card;
+    log->startBlock = startBlock;
+    log->numBlocks = numBlocks;
+    log->chunkBlocks = chunk;
+    log->streaming = 0;
+    log->reading = 0;
+    log->erase.status = ERASE_STATUS_IDLE;
+
+    // Sector 0's chunk is erased ahead of the head once the head enters the
+    // last chunk, in which case the lap being written starts there instead
+    if(!CLOG_Peek(log, 0, &first)){
+        return 0;
+    }
+    if(first == CLOG_NONE){
+        base = numBlocks - chunk;
+        if(!CLOG_Peek(log, base, &first)){
+            return 0;
+        }
+    }
+
+    if(first != CLOG_NONE){
+        // Sectors written in the same lap as the base form a prefix of the
+        // rest of the ring. Past the head are erased sectors, then those of
+        // the last lap
+        lo = base + 1;
+        hi = numBlocks;
+        while(lo < hi){
+            mid = lo + (hi - lo) / 2;
+            if(!CLOG_Peek(log, mid, &seq)){
+                return 0;
+            }
+            if(seq == first + (mid - base)){
+                lo = mid + 1;
+            }
+            else{
+                hi = mid;
+            }
+        }
+        log->nextSeq = first + (lo - base);
+        log->head = (lo == numBlocks) ? 0 : lo;
+    }
+    else{
+        // Both the first and the last chunk are erased, so either the head
+        // is at the start of the last chunk or nothing has been written yet
+        if(!CLOG_Peek(log, base - 1, &seq)){
+            return 0;
+        }
+        log->nextSeq = (seq != CLOG_NONE) ? seq + 1 : 0;
+        log->head = (seq != CLOG_NONE) ? base : 0;
+    }
+
+    // The tail is the first sector of the log after the head: the head itself
+    // if its chunk hasn't been erased yet, otherwise the start of one of the
+    // next two chunks, or sector 0 if the ring hasn't wrapped around
+    idx[0] = log->head;
+    idx[1] = (log->head / chunk + 1) * chunk;
+    if(idx[1] == numBlocks){
+        idx[1] = 0;
+    }
+    idx[2] = idx[1] + chunk;
+    if(idx[2] == numBlocks){
+        idx[2] = 0;
+    }
+    idx[3] = 0;
+    log->tailSeq = log->nextSeq;
+    for(unsigned char i = 0; i < 4; i++){
+        if(!CLOG_Peek(log, idx[i], &seq)){
+            return 0;
+        }
+        if((seq != CLOG_NONE) && (seq < log->nextSeq)){
+            log->tailSeq = seq;
+            break;
+        }
+    }
+
+    CLOG_ReadStart(log, 0);
+    return 1;
+}
+
+unsigned char CLOG_Write(CLOG_Log_t* log, const unsigned char* data){
+    unsigned char hdr[CLOG_HEADER];
+    SD_IOVec_t iov[2];
+
+    CLOG_ReadStop(log);
+    if(!log->streaming && !CLOG_Begin(log)){
+        return 0;
+    }
+
+    hdr[0] = 'C';
+    hdr[1] = 'L';
+    SD_Store32(&hdr[2], log->nextSeq);
+    SD_Store16(&hdr[6], CLOG_SectorCRC(hdr, data));
+    iov[0].base = hdr;
+    iov[0].len = CLOG_HEADER;
+    iov[1].base = data;
+    iov[1].len = CLOG_PAYLOAD_BYTES;
+    if(!SD_MBW_SendV(log->card, iov, 2)){
+        // The card ended the multiple block write when it rejected the
+        // sector. The next write reopens it at the same sector
+        log->streaming = 0;
+        return 0;
+    }
+
+    log->nextSeq++;
+    log->head++;
+    if(log->head == log->numBlocks){
+        log->head = 0;
+    }
+
+    // Each multiple block write covers the rest of one chunk
+    if((log->head % log->chunkBlocks) == 0){
+        return CLOG_Flush(log);
+    }
+    return 1;
+}
+
+unsigned char CLOG_Service(CLOG_Log_t* log){
+    if(log->erase.status != ERASE_STATUS_BUSY){
+        return 1;
+    }
+
+    // An erase command that was already issued only has to be polled, which
+    // can wait until the log leaves the card alone. Issuing the next one
+    // needs the bus to itself
+    if(log->erase.waiting && (log->streaming || log->reading)){
+        return 1;
+    }
+    CLOG_ReadStop(log);
+    if(!CLOG_Flush(log)){
+        return 0;
+    }
+
+    return (ERASE_Service(&log->erase) != ERASE_STATUS_ERROR) ? 1 : 0;
+}
+
+unsigned char CLOG_Flush(CLOG_Log_t* log){
+    if(!log->streaming){
+        return 1;
+    }
+    log->streaming = 0;
+    return SD_MBW_Stop(log->card);
+}
+
+void CLOG_ReadStart(CLOG_Log_t* log, unsigned long seq){
+    CLOG_ReadStop(log);
+    if(seq < log->tailSeq){
+        seq = log->tailSeq;
+    }
+    log->readSeq = seq;
+    log->readIdx = seq % log->numBlocks;
+}
+
+unsigned char CLOG_ReadNext(
+    CLOG_Log_t* log,
+    unsigned char* data,
+    unsigned long* seq
+)
+{
+    unsigned char hdr[CLOG_HEADER];
+    unsigned char valid;
+    SD_IOVec_t iov[2];
+
+    do{
+        if(log->readSeq < log->tailSeq){
+            CLOG_ReadStart(log, log->tailSeq);
+        }
+        if(log->readSeq >= log->nextSeq){
+            return 0;
+        }
+
+        if(!log->reading){
+            if(!CLOG_Flush(log) ||
+               !SD_MBR_Start(log->card, log->startBlock + log->readIdx)){
+                return 0;
+            }
+            log->reading = 1;
+        }
+
+        iov[0].base = hdr;
+        iov[0].len = CLOG_HEADER;
+        iov[1].base = data;
+        iov[1].len = CLOG_PAYLOAD_BYTES;
+        SD_MBR_ReceiveV(log->card, iov, 2);
+
+        // A sector that isn't the one expected, e.g. because a reboot cut
+        // off the erase ahead of the head, or whose payload fails the CRC,
+        // e.g. because a power failure cut off its write, is skipped. The
+        // reader picks up again at the next valid sector
+        valid = ((CLOG_Check(log, hdr, log->readIdx) == log->readSeq) &&
+                 (CLOG_SectorCRC(hdr, data) == SD_Load16(&hdr[6]))) ? 1 : 0;
+        *seq = log->readSeq;
+        log->readSeq++;
+        log->readIdx++;
+        if(log->readIdx == log->numBlocks){
+            CLOG_ReadStop(log);
+            log->readIdx = 0;
+        }
+    }while(!valid);
+
+    return 1;
+}
+
+void CLOG_ReadStop(CLOG_Log_t* log){
+    if(log->reading){
+        SD_MBR_Stop(log->card);
+        log->reading = 0;
+    }
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Computes the CRC16 of a sector, leaving out the CRC itself
+ * @param hdr Pointer to the CLOG_HEADER byte header
+ * @param data Pointer to the CLOG_PAYLOAD_BYTES byte payload
+ * @return The CRC16
+ */
+static unsigned short CLOG_SectorCRC(
+    const unsigned char* hdr,
+    const unsigned char* data
+)
+{
+    unsigned short crc = 0;
+
+    for(unsigned char i = 0; i < 6; i++){
+        crc = SD_CRC16(crc, hdr[i]);
+    }
+    for(unsigned short i = 0; i < CLOG_PAYLOAD_BYTES; i++){
+        crc = SD_CRC16(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+ * @brief Checks a sector header. The CRC covers the payload as well, so it is
+ *        only checked once the whole sector has been read
+ * @param log Pointer to the log
+ * @param hdr Pointer to the header
+ * @param idx Index of the sector in the ring
+ * @return The sequence number of the sector, or CLOG_NONE if the sector isn't
+ *         part of the log (e.g. it was erased)
+ */
+static unsigned long CLOG_Check(
+    const CLOG_Log_t* log,
+    const unsigned char* hdr,
+    unsigned long idx
+)
+{
+    unsigned long seq = SD_Load32(&hdr[2]);
+
+    if((hdr[0] != 'C') || (hdr[1] != 'L')){
+        return CLOG_NONE;
+    }
+    return ((seq % log->numBlocks) == idx) ? seq : CLOG_NONE;
+}
+
+/**
+ * @brief Reads the header of a sector, discarding the rest of it
+ * @param log Pointer to the log
+ * @param idx Index of the sector in the ring
+ * @param seq Set to the sequence number of the sector, or CLOG_NONE if it
+ *        isn't part of the log
+ * @return 1 if successful, 0 if the sector couldn't be read
+ */
+static unsigned char CLOG_Peek(
+    CLOG_Log_t* log,
+    unsigned long idx,
+    unsigned long* seq
+)
+{
+    unsigned char hdr[CLOG_HEADER];
+    SD_IOVec_t iov;
+
+    iov.base = hdr;
+    iov.len = CLOG_HEADER;
+    if(!SD_SingleBlockReadV(log->card, log->startBlock + idx, &iov, 1)){
+        return 0;
+    }
+    *seq = CLOG_Check(log, hdr, idx);
+    return 1;
+}
+
+/**
+ * @brief Moves the tail past the sectors that are lost when chunks ahead of
+ *        the head are erased
+ * @pre The head is at the start of a chunk
+ * @param log Pointer to the log
+ * @param numChunks Number of chunks erased, starting with the head's
+ */
+static void CLOG_Forget(CLOG_Log_t* log, unsigned char numChunks){
+    unsigned long lost = log->nextSeq + numChunks * log->chunkBlocks;
+
+    if(lost > log->numBlocks){
+        lost -= log->numBlocks;
+        if(log->tailSeq < lost){
+            log->tailSeq = lost;
+        }
+    }
+}
+
+/**
+ * @brief Opens a multiple block write from the head to the end of its chunk.
+ *        If the head is at the start of a chunk, the chunk has to be erased
+ *        first. That is normally already done by CLOG_Service, and otherwise
+ *        done here. The erase of the next chunk is then set up for
+ *        CLOG_Service, and the tail moves past the sectors that were in both
+ * @param log Pointer to the log
+ * @return 1 if successful, 0 if the erase failed
+ */
+static unsigned char CLOG_Begin(CLOG_Log_t* log){
+    SDCard_t* card = log->card;
+    ERASE_Job_t* job = &log->erase;
+    unsigned long end = (log->head / log->chunkBlocks + 1) * log->chunkBlocks;
+    unsigned long next = (end == log->numBlocks) ? 0 : end;
+
+    if((log->head % log->chunkBlocks) == 0){
+        if(((job->status != ERASE_STATUS_BUSY) &&
+            (job->status != ERASE_STATUS_DONE)) ||
+           (job->lastBlock != log->startBlock + end - 1)){
+            CLOG_Forget(log, 1);
+            if(!ERASE_Start(
+                    job,
+                    card,
+                    log->startBlock + log->head,
+                    log->startBlock + end - 1,
+                    ERASE_MODE_ERASE
+                )
+            )
+            {
+                return 0;
+            }
+        }
+
+        // Only waits if the head caught up with the erase
+        if(ERASE_Run(job) != ERASE_STATUS_DONE){
+            return 0;
+        }
+
+        CLOG_Forget(log, 2);
+        ERASE_Start(
+            job,
+            card,
+            log->startBlock + next,
+            log->startBlock + next + log->chunkBlocks - 1,
+            ERASE_MODE_ERASE
+        );
+    }
+
+    SD_MBW_Start(card, log->startBlock + log->head, end - log->head);
+    log->streaming = 1;
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 23, 2026, 3:40 PM
+ *
+ * @defgroup CLOG
+ * @brief Circular log over a fixed range of blocks, for loggers that only
+ *        need to keep the most recent data. The range is split into chunks
+ *        of one allocation unit (AU) each, and the log wraps around by
+ *        erasing the chunk after the one being written, in the background,
+ *        so every block is erased and written once per lap. Each sector
+ *        starts with an 8 byte header holding a sequence number that keeps
+ *        counting across laps, which lets the head and tail be recovered
+ *        after a reset with a binary search over the headers, read without a
+ *        512 byte buffer. The header's CRC16 also covers the payload. The
+ *        retained window is streamed back in order with multiple block reads
+ *        (CMD18), which also works while the log is being written
+ * @{
+ */
+
+#ifndef CLOG_PIC_H
+#define CLOG_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+#include "../ERASE/ERASE_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Erase chunk used when the card does not report its AU size */
+#ifndef CLOG_DEFAULT_CHUNK_BLOCKS
+#define CLOG_DEFAULT_CHUNK_BLOCKS 128UL
+#endif
+
+/** @brief Bytes of data carried by each sector, after its header */
+#define CLOG_PAYLOAD_BYTES 504
+
+/********************************** Types ************************************/
+/** @brief A circular log */
+typedef struct{
+    SDCard_t* card;            /**< Card holding the log */
+    unsigned long startBlock;  /**< First block of the range */
+    unsigned long numBlocks;   /**< Blocks in the ring, a whole number of
+                                *   chunks */
+    unsigned long chunkBlocks; /**< Blocks erased at a time */
+    unsigned long head;        /**< Index of the next sector to write */
+    unsigned long nextSeq;     /**< Sequence number of the next sector */
+    unsigned long tailSeq;     /**< Sequence number of the oldest sector that
+                                *   is still retained */
+    unsigned long readIdx;     /**< Index of the next sector to read */
+    unsigned long readSeq;     /**< Sequence number of the next sector to
+                                *   read */
+    ERASE_Job_t erase;         /**< Erase of the chunk after the head's */
+    unsigned char streaming;   /**< 1 while a multiple block write is open */
+    unsigned char reading;     /**< 1 while a multiple block read is open */
+}CLOG_Log_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Opens the circular log in a range of blocks, recovering its head and
+ *        tail from the sector headers. A range that holds no log yet is
+ *        opened as an empty log. Writing carries on where it left off, so
+ *        wear stays even across resets
+ * @pre The card has been initialized using initSD
+ * @param log Pointer to the log
+ * @param card Pointer to the card
+ * @param startBlock First block of the range. Should be on an AU boundary
+ * @param numBlocks Blocks in the range. Rounded down to a whole number of
+ *        chunks, of which there must be at least 2. Since the chunk after
+ *        the head's is erased ahead of time, between one and two chunks'
+ *        worth of sectors are not retained
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char CLOG_Open(
+    CLOG_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks
+);
+
+/**
+ * @brief Writes the next sector of the log. When the head enters a new chunk,
+ *        it waits for CLOG_Service to finish erasing the chunk, or erases it
+ *        itself if CLOG_Service hasn't been called. The erase of the next
+ *        chunk is then set up, and the oldest sectors are lost with it
+ * @param log Pointer to the log
+ * @param data Pointer to the CLOG_PAYLOAD_BYTES bytes to be written
+ * @return 1 if successful, 0 otherwise. If the card rejected the sector, the
+ *         next write sends the sector again in a new multiple block write
+ */
+unsigned char CLOG_Write(CLOG_Log_t* log, const unsigned char* data);
+
+/**
+ * @brief Advances the background erase of the chunk after the head's,
+ *        without waiting for the card. Call this while the application is
+ *        idle. If the next erase command has to be issued, the open multiple
+ *        block write or read is stopped first, and the next CLOG_Write or
+ *        CLOG_ReadNext reopens it. Until the card finishes erasing, accesses
+ *        to the card wait for it
+ * @pre The SPI module has been started using sd_start
+ * @param log Pointer to the log
+ * @return 1 if successful, 0 if the write couldn't be stopped or the card
+ *         rejected the erase
+ */
+unsigned char CLOG_Service(CLOG_Log_t* log);
+
+/**
+ * @brief Stops the multiple block write, if one is open, so that the card
+ *        commits every sector written so far. Writing resumes with a new one
+ * @param log Pointer to the log
+ * @return 1 if successful, 0 otherwise (see SD_MBW_Stop)
+ */
+unsigned char CLOG_Flush(CLOG_Log_t* log);
+
+/**
+ * @brief Positions the log's reader
+ * @param log Pointer to the log
+ * @param seq Sequence number of the first sector to read. Sectors older than
+ *        the tail are skipped, so 0 reads the whole retained window
+ */
+void CLOG_ReadStart(CLOG_Log_t* log, unsigned long seq);
+
+/**
+ * @brief Reads the next sector of the log. Consecutive reads are served from
+ *        a single multiple block read, which is restarted at the start of the
+ *        range when it wraps around, or after a write. If writes have
+ *        overtaken the reader, it skips ahead to the tail
+ * @param log Pointer to the log
+ * @param data Pointer to the array that will store the CLOG_PAYLOAD_BYTES
+ *        bytes of the sector
+ * @param seq Set to the sequence number of the sector
+ * @return 1 if a sector was read, 0 at the head of the log or if the sector
+ *         couldn't be read. Sectors that aren't part of the log, e.g. because
+ *         a reboot cut off an erase, and sectors whose payload fails the CRC,
+ *         e.g. because a power failure cut off their write, are skipped
+ */
+unsigned char CLOG_ReadNext(
+    CLOG_Log_t* log,
+    unsigned char* data,
+    unsigned long* seq
+);
+
+/**
+ * @brief Stops the multiple block read, if one is open
+ * @param log Pointer to the log
+ */
+void CLOG_ReadStop(CLOG_Log_t* log);
+
+/**
+ * @}
+ */
+
+#endif	/* CLOG_PIC_H */
\ No newline at end of file
@@ -0,0 +1,200 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 18, 2026, 2:15 PM
+ *
+ * @ingroup ERASE
+ */
+
+/********************************* Includes **********************************/
+#include "ERASE_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Blocks overwritten with zeros per call to ERASE_Service */
+#define ERASE_FILL_BLOCKS \
+    ((ERASE_MAX_CHUNK_MS >= ERASE_BLOCK_WRITE_MS) ? \
+     (ERASE_MAX_CHUNK_MS / ERASE_BLOCK_WRITE_MS) : 1UL)
+
+/************************ Private Function Prototypes ************************/
+static unsigned char ERASE_ChunkDone(ERASE_Job_t* job);
+
+/***************************** Public Functions ******************************/
+unsigned char ERASE_Start(
+    ERASE_Job_t* job,
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock,
+    erase_mode_e mode
+)
+{
+    unsigned long budget;
+    unsigned long numAUs;
+
+    if(firstBlock > lastBlock){
+        return 0;
+    }
+
+    job->card = card;
+    job->nextBlock = firstBlock;
+    job->lastBlock = lastBlock;
+    job->chunkEnd = firstBlock;
+    job->mode = mode;
+    job->polls = 0;
+    job->waiting = 0;
+
+    // Chunks are aligned to allocation units, which is where the card erases
+    // most efficiently. Cards that can't erase single blocks need at least
+    // erase group alignment
+    job->unitBlocks = card->auBlocks;
+    if(job->unitBlocks < card->eraseGroup){
+        job->unitBlocks = card->eraseGroup;
+    }
+    if(job->unitBlocks == 0){
+        job->unitBlocks = 1;
+    }
+
+    // The time taken to erase n AUs is
+    //      ERASE_TIMEOUT / ERASE_SIZE * n + ERASE_OFFSET seconds
+    // so the number of AUs that fit into the time budget is
+    //      (budget - ERASE_OFFSET) * ERASE_SIZE / ERASE_TIMEOUT.
+    // If the card doesn't specify these, erase one unit at a time
+    job->chunkUnits = 1;
+    if((card->eraseSize != 0) && (card->eraseTimeout != 0) &&
+       (card->auBlocks != 0)){
+        budget = card->eraseOffset * 1000UL;
+        if(budget < ERASE_MAX_CHUNK_MS){
+            budget = ERASE_MAX_CHUNK_MS - budget;
+            numAUs = (budget * card->eraseSize) /
+                        (card->eraseTimeout * 1000UL);
+            job->chunkUnits = numAUs / (job->unitBlocks / card->auBlocks);
+            if(job->chunkUnits == 0){
+                job->chunkUnits = 1;
+            }
+        }
+    }
+
+    job->status = ERASE_STATUS_BUSY;
+
+    return 1;
+}
+
+erase_status_e ERASE_Service(ERASE_Job_t* job){
+    unsigned long offset;
+    unsigned long numUnits;
+    unsigned char partial;
+    unsigned char success;
+    SD_FillGen_t zeros = {0};
+
+    if(job->status != ERASE_STATUS_BUSY){
+        return job->status;
+    }
+
+    // Check whether the card has finished the chunk that is in progress
+    if(job->waiting){
+        if(SD_IsBusy(job->card)){
+            // A card that stays busy that long has stopped responding
+            if(++job->polls >= ERASE_BUSY_POLLS){
+                job->waiting = 0;
+                job->status = ERASE_STATUS_ERROR;
+            }
+            return job->status;
+        }
+        job->waiting = 0;
+        if(ERASE_ChunkDone(job)){
+            return job->status;
+        }
+    }
+
+    // Plan the next chunk. An unaligned start is brought up to the next unit
+    // boundary first, then as many whole units as the time budget allows are
+    // erased, and finally whatever is left over at the end of the range
+    offset = job->nextBlock % job->unitBlocks;
+    numUnits = (job->lastBlock - job->nextBlock + 1) / job->unitBlocks;
+    if(offset != 0){
+        job->chunkEnd = job->nextBlock + (job->unitBlocks - offset) - 1;
+        partial = 1;
+    }
+    else if(numUnits == 0){
+        job->chunkEnd = job->lastBlock;
+        partial = 1;
+    }
+    else{
+        if(numUnits > job->chunkUnits){
+            numUnits = job->chunkUnits;
+        }
+        job->chunkEnd = job->nextBlock + numUnits * job->unitBlocks - 1;
+        partial = 0;
+    }
+    if(job->chunkEnd > job->lastBlock){
+        job->chunkEnd = job->lastBlock;
+    }
+
+    if(partial && (job->card->eraseGroup > 1)){
+        // Erasing part of an erase group would take the rest of the group
+        // with it, so overwrite these blocks instead. The fill waits for the
+        // card to program every block, so it is split across calls
+        if(job->chunkEnd - job->nextBlock + 1 > ERASE_FILL_BLOCKS){
+            job->chunkEnd = job->nextBlock + ERASE_FILL_BLOCKS - 1;
+        }
+        zeros.type = SD_FILL_CONSTANT;
+        if(!SD_FillBlocks(
+                job->card,
+                job->nextBlock,
+                job->chunkEnd - job->nextBlock + 1,
+                &zeros
+            ))
+        {
+            job->status = ERASE_STATUS_ERROR;
+            return job->status;
+        }
+        ERASE_ChunkDone(job);
+        return job->status;
+    }
+
+    if(job->mode == ERASE_MODE_DISCARD){
+        success = SD_DiscardBlocks(job->card, job->nextBlock, job->chunkEnd);
+    }
+    else{
+        success = SD_EraseBlocks(job->card, job->nextBlock, job->chunkEnd);
+    }
+    if(!success){
+        job->status = ERASE_STATUS_ERROR;
+        return job->status;
+    }
+
+    job->polls = 0;
+    job->waiting = 1;
+
+    return ERASE_STATUS_BUSY;
+}
+
+erase_status_e ERASE_Run(ERASE_Job_t* job){
+    while(ERASE_Service(job) == ERASE_STATUS_BUSY){
+        continue;
+    }
+    return job->status;
+}
+
+unsigned long ERASE_BlocksRemaining(const ERASE_Job_t* job){
+    if(job->status == ERASE_STATUS_DONE){
+        return 0;
+    }
+    return job->lastBlock - job->nextBlock + 1;
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Records that the chunk in progress has been erased
+ * @param job Pointer to the job
+ * @return 1 if that was the last chunk of the job, 0 otherwise
+ */
+static unsigned char ERASE_ChunkDone(ERASE_Job_t* job){
+    if(job->chunkEnd == job->lastBlock){
+        job->nextBlock = job->lastBlock;
+        job->status = ERASE_STATUS_DONE;
+        return 1;
+    }
+    job->nextBlock = job->chunkEnd + 1;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 18, 2026, 2:15 PM
+ *
+ * @defgroup ERASE
+ * @brief Erase engine for large block ranges. Ranges are split into chunks
+ *        that are aligned to the card's allocation units (AUs), and sized so
+ *        that each erase command finishes within ERASE_MAX_CHUNK_MS according
+ *        to the card's ERASE_SIZE, ERASE_TIMEOUT and ERASE_OFFSET. Jobs are
+ *        advanced by polling, so the application can keep running while the
+ *        card erases
+ * @{
+ */
+
+#ifndef ERASE_PIC_H
+#define ERASE_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Longest time a single erase command is allowed to take, in ms */
+#ifndef ERASE_MAX_CHUNK_MS
+#define ERASE_MAX_CHUNK_MS 1000UL
+#endif
+
+/** @brief Longest time a card may take to program a block, in ms. SDHC and
+ *         SDXC cards have to finish within 250 ms */
+#ifndef ERASE_BLOCK_WRITE_MS
+#define ERASE_BLOCK_WRITE_MS 250UL
+#endif
+
+/** @brief Times the card may be found busy with one erase command before the
+ *         job fails. Each call to ERASE_Service polls the card once, so this
+ *         has to cover well over ERASE_MAX_CHUNK_MS at the SPI clock in use */
+#ifndef ERASE_BUSY_POLLS
+#define ERASE_BUSY_POLLS 1000000UL
+#endif
+
+/********************************** Types ************************************/
+/** @brief What to do with the blocks in the range */
+typedef enum{
+    ERASE_MODE_ERASE = 0,  /**< Erase the blocks                          */
+    ERASE_MODE_DISCARD = 1 /**< Discard the blocks (erase if unsupported) */
+}erase_mode_e;
+
+/** @brief Erase job status */
+typedef enum{
+    ERASE_STATUS_IDLE = 0,    /**< Never started                           */
+    ERASE_STATUS_BUSY = 1,    /**< In progress                             */
+    ERASE_STATUS_DONE = 2,    /**< Every block in the range has been erased */
+    ERASE_STATUS_ERROR = 3    /**< The card rejected an erase command or
+                               *   stayed busy for ERASE_BUSY_POLLS polls  */
+}erase_status_e;
+
+/** @brief State of an erase job */
+typedef struct{
+    SDCard_t* card;             /**< The card being erased */
+    unsigned long nextBlock;    /**< First block not yet erased */
+    unsigned long lastBlock;    /**< Last block of the range */
+    unsigned long chunkEnd;     /**< Last block of the chunk being erased */
+    unsigned long unitBlocks;   /**< Alignment unit (AU or erase group) */
+    unsigned long chunkUnits;   /**< Maximum number of units per command */
+    erase_mode_e mode;          /**< Erase or discard */
+    erase_status_e status;      /**< Job status */
+    unsigned long polls;        /**< Times the card was found busy with the
+                                 *   chunk */
+    unsigned char waiting;      /**< 1 while the card erases a chunk */
+}ERASE_Job_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Prepares an erase job for the blocks between firstBlock and
+ *        lastBlock, inclusive. No commands are sent until ERASE_Service is
+ *        called
+ * @param job Pointer to the job to be prepared
+ * @param card Pointer to the card to be erased
+ * @param firstBlock Address of the first block to be erased
+ * @param lastBlock Address of the last block to be erased
+ * @param mode Whether to erase or discard the blocks
+ * @return 1 if the job was prepared, 0 if the range is invalid
+ */
+unsigned char ERASE_Start(
+    ERASE_Job_t* job,
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock,
+    erase_mode_e mode
+);
+
+/**
+ * @brief Advances an erase job without waiting for the card. If the card is
+ *        still erasing the previous chunk, this returns immediately.
+ *        Otherwise, the erase command for the next chunk is issued. Partial
+ *        erase groups at the ends of the range on cards that can't erase
+ *        single blocks are overwritten with zeros instead, since erasing them
+ *        would also erase blocks outside of the range. Only as many blocks
+ *        as can be programmed within ERASE_MAX_CHUNK_MS are overwritten per
+ *        call. The job fails if the card is still erasing a chunk after
+ *        ERASE_BUSY_POLLS calls
+ * @pre The SPI module has been started using sd_start
+ * @param job Pointer to the job
+ * @return The job status
+ */
+erase_status_e ERASE_Service(ERASE_Job_t* job);
+
+/**
+ * @brief Calls ERASE_Service until the job is either done or has failed
+ * @pre The SPI module has been started using sd_start
+ * @param job Pointer to the job
+ * @return ERASE_STATUS_DONE or ERASE_STATUS_ERROR
+ */
+erase_status_e ERASE_Run(ERASE_Job_t* job);
+
+/**
+ * @brief Gets the number of blocks of a job that have not been erased yet
+ * @param job Pointer to the job
+ * @return The number of blocks left, including the chunk being erased
+ */
+unsigned long ERASE_BlocksRemaining(const ERASE_Job_t* job);
+
+/**
+ * @}
+ */
+
+#endif	/* ERASE_PIC_H */
\ No newline at end of file
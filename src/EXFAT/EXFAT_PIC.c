@@ -0,0 +1,1764 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 22, 2026, 9:30 AM
+ *
+ * @ingroup EXFAT
+ */
+
+/********************************* Includes **********************************/
+#include <string.h>
+#include "EXFAT_PIC.h"
+#include "../WINDOW/WINDOW_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Size of a directory entry, in bytes */
+#define EXFAT_ENTRY_SIZE 32
+
+/** @brief Directory entries per sector */
+#define EXFAT_ENTRIES_PER_SECTOR (512 / EXFAT_ENTRY_SIZE)
+
+/** @brief Characters of a name held by each file name entry */
+#define EXFAT_NAME_CHARS 15
+
+/** @brief FAT entry marking the end of a cluster chain */
+#define EXFAT_EOC 0xFFFFFFFFUL
+
+/** @brief Directory entry types */
+#define EXFAT_TYPE_END    0x00 /**< End of the directory */
+#define EXFAT_TYPE_BITMAP 0x81 /**< Allocation bitmap    */
+#define EXFAT_TYPE_UPCASE 0x82 /**< Upcase table         */
+#define EXFAT_TYPE_FILE   0x85 /**< File                 */
+#define EXFAT_TYPE_STREAM 0xC0 /**< Stream extension     */
+#define EXFAT_TYPE_NAME   0xC1 /**< File name            */
+
+/** @brief Bit of the entry type that is set when the entry is in use */
+#define EXFAT_IN_USE 0x80
+
+/** @brief Stream extension flags */
+#define EXFAT_ALLOC_POSSIBLE 0x01 /**< The file may have clusters       */
+#define EXFAT_NO_FAT_CHAIN   0x02 /**< The clusters are consecutive and
+                                   *   not recorded in the FAT          */
+
+/** @brief Volume flags in the boot sector */
+#define EXFAT_ACTIVE_FAT   0x0001 /**< The second FAT and bitmap are used */
+#define EXFAT_VOLUME_DIRTY 0x0002 /**< The volume may be inconsistent     */
+
+/** @brief Checks whether a cluster number refers to the cluster heap */
+#define exfat_valid(vol, c) (((c) >= 2) && ((c) - 2 < (vol)->numClusters))
+
+/************************ Private Function Prototypes ************************/
+static unsigned char EXFAT_IsBootSector(void);
+static unsigned char EXFAT_MountAt(
+    EXFAT_Volume_t* vol,
+    unsigned long volStart
+);
+static unsigned char EXFAT_LoadUpcase(
+    EXFAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long length
+);
+static unsigned long EXFAT_ClusterToSector(
+    const EXFAT_Volume_t* vol,
+    unsigned long cluster
+);
+static unsigned long EXFAT_ClustersFor(
+    const EXFAT_Volume_t* vol,
+    unsigned long numBytes
+);
+static unsigned char EXFAT_GetEntry(
+    EXFAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long* value
+);
+static unsigned char EXFAT_SetEntry(
+    EXFAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long value
+);
+static unsigned char EXFAT_IsFree(
+    EXFAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned char* isFree
+);
+static unsigned char EXFAT_SetBits(
+    EXFAT_Volume_t* vol,
+    unsigned long first,
+    unsigned long n,
+    unsigned char used
+);
+static unsigned long EXFAT_FindRun(EXFAT_Volume_t* vol, unsigned long n);
+static unsigned char EXFAT_MarkDirty(EXFAT_Volume_t* vol);
+static unsigned char EXFAT_ClusterAt(
+    EXFAT_File_t* file,
+    unsigned long idx,
+    unsigned long* cluster
+);
+static unsigned char EXFAT_Extend(EXFAT_File_t* file, unsigned long n);
+static unsigned char EXFAT_Trim(EXFAT_File_t* file);
+static unsigned char EXFAT_DataRead(
+    EXFAT_Volume_t* vol,
+    unsigned long sector,
+    unsigned long numSectors,
+    unsigned char* buf
+);
+static unsigned char EXFAT_DataWrite(
+    EXFAT_Volume_t* vol,
+    unsigned long sector,
+    unsigned long numSectors,
+    const unsigned char* buf
+);
+static unsigned long EXFAT_RunLeft(EXFAT_File_t* file);
+static unsigned char EXFAT_SyncEntry(EXFAT_File_t* file);
+static void EXFAT_DirStart(
+    EXFAT_Volume_t* vol,
+    EXFAT_Dir_t* dir,
+    unsigned long cluster,
+    unsigned long numClusters
+);
+static unsigned char* EXFAT_DirEntry(EXFAT_Dir_t* dir);
+static unsigned char EXFAT_DirNext(EXFAT_Dir_t* dir, unsigned char extend);
+static unsigned char EXFAT_ParseName(
+    const char** path,
+    const char** name,
+    unsigned char* len
+);
+static unsigned short EXFAT_NameHash(
+    const EXFAT_Volume_t* vol,
+    const char* name,
+    unsigned char len
+);
+static unsigned char EXFAT_MatchSet(
+    EXFAT_Dir_t* dir,
+    const char* name,
+    unsigned char len,
+    unsigned short hash
+);
+static unsigned char EXFAT_Search(
+    EXFAT_Volume_t* vol,
+    EXFAT_Dir_t* dir,
+    unsigned long dirCluster,
+    unsigned long dirClusters,
+    const char* name,
+    unsigned char len
+);
+static unsigned char EXFAT_Create(
+    EXFAT_Volume_t* vol,
+    EXFAT_Dir_t* dir,
+    unsigned long dirCluster,
+    unsigned long dirClusters,
+    const char* name,
+    unsigned char len
+);
+static unsigned char EXFAT_SealSet(const EXFAT_Dir_t* set);
+
+/***************************** Public Functions ******************************/
+unsigned char EXFAT_Mount(EXFAT_Volume_t* vol, SDCard_t* card){
+    unsigned long starts[4];
+    unsigned char* p;
+
+    // The window may hold a sector of a previous mount of this volume
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+    WINDOW_Reset();
+
+    vol->card = card;
+    if(!WINDOW_Load(vol, card, 0) ||
+       (SD_Load16(&window.data[510]) != 0xAA55)){
+        return 0;
+    }
+
+    // Superfloppy: the volume starts at sector 0
+    if(EXFAT_IsBootSector()){
+        return EXFAT_MountAt(vol, 0);
+    }
+
+    // Otherwise, sector 0 is an MBR. Type 0x07 is shared with NTFS, so each
+    // candidate's boot sector is checked. Mounting reuses the window
+    for(unsigned char i = 0; i < 4; i++){
+        p = &window.data[446 + 16 * i];
+        starts[i] = (p[4] == 0x07) ? SD_Load32(&p[8]) : 0;
+    }
+    for(unsigned char i = 0; i < 4; i++){
+        if((starts[i] != 0) && EXFAT_MountAt(vol, starts[i])){
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+unsigned char EXFAT_MountPartition(
+    EXFAT_Volume_t* vol,
+    SDCard_t* card,
+    unsigned long startBlock
+)
+{
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+    WINDOW_Reset();
+    vol->card = card;
+
+    return EXFAT_MountAt(vol, startBlock);
+}
+
+unsigned char EXFAT_Unmount(EXFAT_Volume_t* vol){
+    unsigned short flags;
+
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+
+    // Only clear the dirty flag if it was clean before this driver wrote
+    if(vol->dirty == 1){
+        if(!WINDOW_Load(vol, vol->card, vol->volStart)){
+            return 0;
+        }
+        flags = SD_Load16(&window.data[106]);
+        SD_Store16(&window.data[106], flags & ~EXFAT_VOLUME_DIRTY);
+        window.dirty = 1;
+        if(!WINDOW_Flush()){
+            return 0;
+        }
+        vol->dirty = 0;
+    }
+
+    WINDOW_Reset();
+
+    return 1;
+}
+
+unsigned char EXFAT_Open(
+    EXFAT_Volume_t* vol,
+    EXFAT_File_t* file,
+    const char* path,
+    exfat_mode_e mode
+)
+{
+    EXFAT_Dir_t dir;
+    const char* name;
+    unsigned char len;
+    unsigned char found;
+    unsigned char flags;
+    unsigned long dirCluster = vol->rootCluster;
+    unsigned long dirClusters = 0;
+    unsigned long dataLength;
+    unsigned char* p;
+
+    // Resolve the path one directory at a time
+    while(1){
+        if(!EXFAT_ParseName(&path, &name, &len)){
+            return 0;
+        }
+        found = EXFAT_Search(vol, &dir, dirCluster, dirClusters, name, len);
+        if(*path == '\0'){
+            break;
+        }
+        if(!found){
+            return 0;
+        }
+
+        p = EXFAT_DirEntry(&dir);
+        if((p == NULL) || !(SD_Load16(&p[4]) & EXFAT_ATTR_DIRECTORY)){
+            return 0;
+        }
+        if(!EXFAT_DirNext(&dir, 0)){
+            return 0;
+        }
+        p = EXFAT_DirEntry(&dir);
+        if((p == NULL) || (p[0] != EXFAT_TYPE_STREAM)){
+            return 0;
+        }
+        dirCluster = SD_Load32(&p[20]);
+        dirClusters = (p[1] & EXFAT_NO_FAT_CHAIN) ?
+                      EXFAT_ClustersFor(vol, SD_Load32(&p[24])) : 0;
+    }
+
+    if(!found){
+        if(mode == EXFAT_MODE_READ){
+            return 0;
+        }
+        if(!EXFAT_Create(vol, &dir, dirCluster, dirClusters, name, len)){
+            return 0;
+        }
+    }
+
+    // File entry
+    file->entrySet = dir;
+    p = EXFAT_DirEntry(&dir);
+    if((p == NULL) || (SD_Load16(&p[4]) & EXFAT_ATTR_DIRECTORY)){
+        return 0;
+    }
+    if((mode == EXFAT_MODE_APPEND) &&
+       (SD_Load16(&p[4]) & EXFAT_ATTR_READ_ONLY)){
+        return 0;
+    }
+
+    // Stream extension. Files of 4 GB or more aren't supported
+    if(!EXFAT_DirNext(&dir, 0)){
+        return 0;
+    }
+    p = EXFAT_DirEntry(&dir);
+    if((p == NULL) || (p[0] != EXFAT_TYPE_STREAM) ||
+       (SD_Load32(&p[12]) != 0) || (SD_Load32(&p[28]) != 0)){
+        return 0;
+    }
+    flags = p[1];
+    file->size = SD_Load32(&p[8]);
+    dataLength = SD_Load32(&p[24]);
+    if(!(flags & EXFAT_ALLOC_POSSIBLE) || (dataLength == 0)){
+        file->firstCluster = 0;
+        file->numClusters = 0;
+        file->contig = 0;
+    }
+    else{
+        file->firstCluster = SD_Load32(&p[20]);
+        file->numClusters = EXFAT_ClustersFor(vol, dataLength);
+        file->contig = (flags & EXFAT_NO_FAT_CHAIN) ? 1 : 0;
+    }
+
+    file->vol = vol;
+    file->mode = mode;
+    file->openClusters = file->numClusters;
+    file->pos = (mode == EXFAT_MODE_APPEND) ? file->size : 0;
+    file->cluster = file->firstCluster;
+    file->clusterIdx = 0;
+    file->dirty = 0;
+    file->streaming = 0;
+
+    return 1;
+}
+
+unsigned short EXFAT_Read(
+    EXFAT_File_t* file,
+    unsigned char* buf,
+    unsigned short len
+)
+{
+    EXFAT_Volume_t* vol = file->vol;
+    unsigned short done = 0;
+    unsigned short offset;
+    unsigned short chunk;
+    unsigned long sector;
+    unsigned long numSectors;
+    unsigned long cluster;
+
+    if(file->streaming){
+        return 0;
+    }
+
+    while((done < len) && (file->pos < file->size)){
+        if(!EXFAT_ClusterAt(
+                file,
+                file->pos >> (vol->clusterShift + 9),
+                &cluster
+            )
+        )
+        {
+            break;
+        }
+        sector = EXFAT_ClusterToSector(vol, cluster) +
+                 ((file->pos >> 9) & ((1UL << vol->clusterShift) - 1));
+        offset = (unsigned short)(file->pos % 512);
+
+        if((offset == 0) && (len - done >= 512) &&
+           (file->size - file->pos >= 512)){
+            // Whole sectors go straight into buf
+            numSectors = (unsigned long)(len - done) / 512;
+            if(numSectors > (file->size - file->pos) / 512){
+                numSectors = (file->size - file->pos) / 512;
+            }
+            if(numSectors > EXFAT_RunLeft(file)){
+                numSectors = EXFAT_RunLeft(file);
+            }
+            if(!EXFAT_DataRead(vol, sector, numSectors, &buf[done])){
+                break;
+            }
+            chunk = (unsigned short)(numSectors * 512);
+        }
+        else{
+            chunk = 512 - offset;
+            if(chunk > len - done){
+                chunk = len - done;
+            }
+            if(chunk > file->size - file->pos){
+                chunk = (unsigned short)(file->size - file->pos);
+            }
+            if(!WINDOW_Load(vol, vol->card, sector)){
+                break;
+            }
+            memcpy(&buf[done], &window.data[offset], chunk);
+        }
+
+        done += chunk;
+        file->pos += chunk;
+    }
+
+    return done;
+}
+
+unsigned char EXFAT_Seek(EXFAT_File_t* file, unsigned long pos){
+    if((file->mode != EXFAT_MODE_READ) || (pos > file->size)){
+        return 0;
+    }
+    file->pos = pos;
+
+    return 1;
+}
+
+unsigned char EXFAT_Write(
+    EXFAT_File_t* file,
+    const unsigned char* buf,
+    unsigned short len
+)
+{
+    EXFAT_Volume_t* vol = file->vol;
+    unsigned short offset;
+    unsigned short chunk;
+    unsigned long sector;
+    unsigned long numSectors;
+    unsigned long cluster;
+
+    if((file->mode != EXFAT_MODE_APPEND) || file->streaming ||
+       (len > 0xFFFFFFFFUL - file->size)){
+        return 0;
+    }
+
+    file->pos = file->size;
+    while(len > 0){
+        // Allocate the next cluster when the previous one is full
+        if((file->pos >> (vol->clusterShift + 9)) >= file->numClusters){
+            if(!EXFAT_Extend(file, 1)){
+                return 0;
+            }
+        }
+        if(!EXFAT_ClusterAt(
+                file,
+                file->pos >> (vol->clusterShift + 9),
+                &cluster
+            )
+        )
+        {
+            return 0;
+        }
+        sector = EXFAT_ClusterToSector(vol, cluster) +
+                 ((file->pos >> 9) & ((1UL << vol->clusterShift) - 1));
+        offset = (unsigned short)(file->pos % 512);
+
+        if((offset == 0) && (len >= 512)){
+            // Whole sectors go straight to the card. In a contiguous file,
+            // this covers every allocated cluster left in one go
+            numSectors = len / 512;
+            if(numSectors > EXFAT_RunLeft(file)){
+                numSectors = EXFAT_RunLeft(file);
+            }
+            if(!EXFAT_DataWrite(vol, sector, numSectors, buf)){
+                return 0;
+            }
+            chunk = (unsigned short)(numSectors * 512);
+        }
+        else{
+            chunk = 512 - offset;
+            if(chunk > len){
+                chunk = len;
+            }
+
+            // Nothing past the end of the file needs to be kept
+            if(offset == 0){
+                if(!WINDOW_Flush()){
+                    return 0;
+                }
+                WINDOW_Claim(vol, vol->card, sector);
+            }
+            else if(!WINDOW_Load(vol, vol->card, sector)){
+                return 0;
+            }
+            memcpy(&window.data[offset], buf, chunk);
+            window.dirty = 1;
+        }
+
+        buf += chunk;
+        len -= chunk;
+        file->pos += chunk;
+        file->size = file->pos;
+        file->dirty = 1;
+    }
+
+    return 1;
+}
+
+unsigned char EXFAT_Reserve(EXFAT_File_t* file, unsigned long numBytes){
+    EXFAT_Volume_t* vol = file->vol;
+    unsigned long needed;
+
+    if((file->mode != EXFAT_MODE_APPEND) || file->streaming ||
+       (numBytes > 0xFFFFFFFFUL - file->size)){
+        return 0;
+    }
+
+    // The allocation has to be expressible as a 32-bit data length
+    needed = EXFAT_ClustersFor(vol, file->size + numBytes);
+    if(needed > (0xFFFFFFFFUL >> (vol->clusterShift + 9))){
+        return 0;
+    }
+    if(needed <= file->numClusters){
+        return 1;
+    }
+
+    return EXFAT_Extend(file, needed - file->numClusters);
+}
+
+unsigned char EXFAT_StreamStart(EXFAT_File_t* file){
+    EXFAT_Volume_t* vol = file->vol;
+    unsigned long sectorIdx = file->size / 512;
+    unsigned long numSectors = file->numClusters << vol->clusterShift;
+    unsigned long sector;
+
+    if((file->mode != EXFAT_MODE_APPEND) || !file->contig ||
+       file->streaming || (file->size % 512 != 0) ||
+       (sectorIdx >= numSectors)){
+        return 0;
+    }
+
+    // The stream holds the card until it is stopped, so pending metadata
+    // has to reach the card first
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+    sector = EXFAT_ClusterToSector(vol, file->firstCluster) + sectorIdx;
+    WINDOW_Drop(vol, sector, numSectors - sectorIdx);
+
+    SD_MBW_Start(vol->card, sector, numSectors - sectorIdx);
+    file->pos = file->size;
+    file->streaming = 1;
+
+    return 1;
+}
+
+unsigned char EXFAT_StreamSend(EXFAT_File_t* file, unsigned char* arrWrite){
+    if(!file->streaming){
+        return 0;
+    }
+    if(file->pos / 512 >= (file->numClusters << file->vol->clusterShift)){
+        return 0;
+    }
+
+    if(!SD_MBW_Send(file->vol->card, arrWrite)){
+        return 0;
+    }
+    file->pos += 512;
+    file->size = file->pos;
+    file->dirty = 1;
+
+    return 1;
+}
+
+unsigned char EXFAT_StreamStop(EXFAT_File_t* file){
+    if(!file->streaming){
+        return 1;
+    }
+    file->streaming = 0;
+
+    return SD_MBW_Stop(file->vol->card);
+}
+
+unsigned char EXFAT_Sync(EXFAT_File_t* file){
+    SDCard_t* card = file->vol->card;
+    SDWriteState_t savedWrite;
+    unsigned char success;
+
+    if(!file->streaming){
+        return EXFAT_SyncEntry(file);
+    }
+
+    // Park the stream at a block boundary. The directory update uses single
+    // block transfers, which would otherwise overwrite the bookkeeping the
+    // multiple block write resumes from
+    SD_MBW_Suspend(card);
+    savedWrite = card->write;
+    success = EXFAT_SyncEntry(file);
+    card->write = savedWrite;
+    SD_MBW_Resume(card);
+
+    return success;
+}
+
+unsigned char EXFAT_Close(EXFAT_File_t* file){
+    unsigned char success = EXFAT_StreamStop(file);
+
+    if((file->mode == EXFAT_MODE_APPEND) && !EXFAT_Trim(file)){
+        success = 0;
+    }
+    if(!EXFAT_Sync(file)){
+        success = 0;
+    }
+
+    return success;
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Checks whether the window holds an exFAT boot sector with 512 byte
+ *        sectors
+ * @return 1 if so, 0 otherwise
+ */
+static unsigned char EXFAT_IsBootSector(void){
+    return (memcmp(&window.data[3], "EXFAT   ", 8) == 0) &&
+           (window.data[108] == 9) &&
+           (window.data[109] <= 16) &&
+           ((window.data[110] == 1) || (window.data[110] == 2));
+}
+
+/**
+ * @brief Reads a volume's boot sector and works out its layout, then finds
+ *        the allocation bitmap and upcase table in the root directory
+ * @param vol Pointer to the volume
+ * @param volStart Sector of the boot sector
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_MountAt(
+    EXFAT_Volume_t* vol,
+    unsigned long volStart
+)
+{
+    EXFAT_Dir_t dir;
+    unsigned short flags;
+    unsigned long bitmapCluster = 0;
+    unsigned long bitmapLength = 0;
+    unsigned long upcaseCluster = 0;
+    unsigned long upcaseLength = 0;
+    unsigned long next;
+    unsigned char* p;
+
+    if(!WINDOW_Load(vol, vol->card, volStart) || !EXFAT_IsBootSector()){
+        return 0;
+    }
+
+    flags = SD_Load16(&window.data[106]);
+    vol->volStart = volStart;
+    vol->fatStart = volStart + SD_Load32(&window.data[80]);
+    if((flags & EXFAT_ACTIVE_FAT) && (window.data[110] == 2)){
+        vol->fatStart += SD_Load32(&window.data[84]);
+    }
+    vol->heapStart = volStart + SD_Load32(&window.data[88]);
+    vol->numClusters = SD_Load32(&window.data[92]);
+    vol->rootCluster = SD_Load32(&window.data[96]);
+    vol->clusterShift = window.data[109];
+    vol->freeHint = 2;
+    vol->dirty = (flags & EXFAT_VOLUME_DIRTY) ? 2 : 0;
+
+    // The allocation bitmap to use is the one that goes with the active FAT
+    EXFAT_DirStart(vol, &dir, vol->rootCluster, 0);
+    while(1){
+        p = EXFAT_DirEntry(&dir);
+        if(p == NULL){
+            return 0;
+        }
+        if(p[0] == EXFAT_TYPE_END){
+            break;
+        }
+        if((p[0] == EXFAT_TYPE_BITMAP) &&
+           ((p[1] & 0x01) == (flags & EXFAT_ACTIVE_FAT))){
+            bitmapCluster = SD_Load32(&p[20]);
+            bitmapLength = SD_Load32(&p[24]);
+        }
+        else if(p[0] == EXFAT_TYPE_UPCASE){
+            upcaseCluster = SD_Load32(&p[20]);
+            upcaseLength = SD_Load32(&p[24]);
+        }
+        if(!EXFAT_DirNext(&dir, 0)){
+            break;
+        }
+    }
+    if(!exfat_valid(vol, bitmapCluster) || !exfat_valid(vol, upcaseCluster) ||
+       (bitmapLength < (vol->numClusters + 7) / 8)){
+        return 0;
+    }
+
+    // Bits are looked up by offset from the start of the bitmap, which is
+    // only possible if its clusters are consecutive. Formatters always lay
+    // it out that way
+    for(unsigned long i = 1; i < EXFAT_ClustersFor(vol, bitmapLength); i++){
+        if(!EXFAT_GetEntry(vol, bitmapCluster + i - 1, &next) ||
+           (next != bitmapCluster + i)){
+            return 0;
+        }
+    }
+    vol->bitmapStart = EXFAT_ClusterToSector(vol, bitmapCluster);
+
+    return EXFAT_LoadUpcase(vol, upcaseCluster, upcaseLength);
+}
+
+/**
+ * @brief Reads the upper case of each ASCII character from the upcase table.
+ *        The table may be compressed: 0xFFFF followed by a count stands for
+ *        that many characters that are their own upper case. The ASCII
+ *        mappings always fit in the table's first sector
+ * @param vol Pointer to the volume
+ * @param cluster First cluster of the upcase table
+ * @param length Size of the upcase table, in bytes
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_LoadUpcase(
+    EXFAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long length
+)
+{
+    unsigned short code = 0;
+    unsigned short i = 0;
+    unsigned short value;
+
+    for(unsigned char c = 0; c < 128; c++){
+        vol->upcase[c] = c;
+    }
+    if(!WINDOW_Load(vol, vol->card, EXFAT_ClusterToSector(vol, cluster))){
+        return 0;
+    }
+
+    while((code < 128) && (i + 2U <= 512) && (i + 2UL <= length)){
+        value = SD_Load16(&window.data[i]);
+        i += 2;
+        if(value == 0xFFFF){
+            if((i + 2U > 512) || (i + 2UL > length)){
+                break;
+            }
+            code += SD_Load16(&window.data[i]);
+            i += 2;
+        }
+        else{
+            // Characters that map outside ASCII are compared as they are
+            vol->upcase[code] = (value < 128) ?
+                                (unsigned char)value : (unsigned char)code;
+            code++;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Works out where a cluster starts
+ * @param vol Pointer to the volume
+ * @param cluster Cluster number
+ * @return The first sector of the cluster
+ */
+static unsigned long EXFAT_ClusterToSector(
+    const EXFAT_Volume_t* vol,
+    unsigned long cluster
+)
+{
+    return vol->heapStart + ((cluster - 2) << vol->clusterShift);
+}
+
+/**
+ * @brief Works out how many clusters are needed to hold some bytes
+ * @param vol Pointer to the volume
+ * @param numBytes Number of bytes
+ * @return The number of clusters
+ */
+static unsigned long EXFAT_ClustersFor(
+    const EXFAT_Volume_t* vol,
+    unsigned long numBytes
+)
+{
+    unsigned char shift = vol->clusterShift + 9;
+    unsigned long n = numBytes >> shift;
+
+    if(numBytes & ((1UL << shift) - 1)){
+        n++;
+    }
+
+    return n;
+}
+
+/**
+ * @brief Reads a FAT entry
+ * @param vol Pointer to the volume
+ * @param cluster Cluster whose entry is to be read
+ * @param value Set to the entry's value
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_GetEntry(
+    EXFAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long* value
+)
+{
+    if(!WINDOW_Load(vol, vol->card, vol->fatStart + (cluster >> 7))){
+        return 0;
+    }
+    *value = SD_Load32(&window.data[(unsigned short)(cluster & 127) * 4]);
+
+    return 1;
+}
+
+/**
+ * @brief Writes a FAT entry
+ * @param vol Pointer to the volume
+ * @param cluster Cluster whose entry is to be written
+ * @param value Value to write
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_SetEntry(
+    EXFAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long value
+)
+{
+    if(!WINDOW_Load(vol, vol->card, vol->fatStart + (cluster >> 7))){
+        return 0;
+    }
+    SD_Store32(&window.data[(unsigned short)(cluster & 127) * 4], value);
+    window.dirty = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Checks the allocation bitmap to see whether a cluster is free
+ * @param vol Pointer to the volume
+ * @param cluster Cluster to check
+ * @param isFree Set to 1 if the cluster is free, 0 otherwise
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_IsFree(
+    EXFAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned char* isFree
+)
+{
+    unsigned long bit = cluster - 2;
+
+    if(!WINDOW_Load(vol, vol->card, vol->bitmapStart + (bit >> 12))){
+        return 0;
+    }
+    *isFree = (window.data[(bit >> 3) & 511] & (1U << (bit & 7))) ? 0 : 1;
+
+    return 1;
+}
+
+/**
+ * @brief Marks a run of clusters as used or free in the allocation bitmap
+ * @param vol Pointer to the volume
+ * @param first First cluster of the run
+ * @param n Number of clusters in the run
+ * @param used 1 to mark the clusters as used, 0 to mark them as free
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_SetBits(
+    EXFAT_Volume_t* vol,
+    unsigned long first,
+    unsigned long n,
+    unsigned char used
+)
+{
+    unsigned long bit;
+    unsigned char* p;
+
+    for(unsigned long i = 0; i < n; i++){
+        bit = first + i - 2;
+        if(!WINDOW_Load(vol, vol->card, vol->bitmapStart + (bit >> 12))){
+            return 0;
+        }
+        p = &window.data[(bit >> 3) & 511];
+        if(used){
+            *p |= (unsigned char)(1U << (bit & 7));
+        }
+        else{
+            *p &= (unsigned char)~(1U << (bit & 7));
+        }
+        window.dirty = 1;
+    }
+
+    if(used){
+        if((vol->freeHint >= first) && (vol->freeHint - first < n)){
+            vol->freeHint = first + n;
+        }
+    }
+    else if(first < vol->freeHint){
+        vol->freeHint = first;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Looks for a run of free clusters in the allocation bitmap, starting
+ *        at the free hint and wrapping around once. Bytes with every bit set
+ *        are skipped whole
+ * @param vol Pointer to the volume
+ * @param n Number of consecutive free clusters needed
+ * @return The first cluster of the run, or 0 if there is none
+ */
+static unsigned long EXFAT_FindRun(EXFAT_Volume_t* vol, unsigned long n){
+    unsigned long cluster = vol->freeHint;
+    unsigned long start = 0;
+    unsigned long run = 0;
+    unsigned long bit;
+    unsigned char byte;
+
+    if(!exfat_valid(vol, cluster)){
+        cluster = 2;
+    }
+
+    for(unsigned long checked = 0; checked < vol->numClusters;){
+        // Runs can't wrap around the end of the cluster heap
+        if(!exfat_valid(vol, cluster)){
+            cluster = 2;
+            run = 0;
+        }
+
+        bit = cluster - 2;
+        if(!WINDOW_Load(vol, vol->card, vol->bitmapStart + (bit >> 12))){
+            return 0;
+        }
+        byte = window.data[(bit >> 3) & 511];
+        if((byte == 0xFF) && ((bit & 7) == 0)){
+            run = 0;
+            cluster += 8;
+            checked += 8;
+            continue;
+        }
+
+        if(byte & (1U << (bit & 7))){
+            run = 0;
+        }
+        else{
+            if(run == 0){
+                start = cluster;
+            }
+            run++;
+            if(run == n){
+                return start;
+            }
+        }
+        cluster++;
+        checked++;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Sets the volume dirty flag in the boot sector before the first
+ *        change to the volume's metadata, so that a PC checks the volume if
+ *        power is lost before it is unmounted. The percentage of the volume
+ *        in use is set to unknown, as it isn't kept up to date
+ * @param vol Pointer to the volume
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_MarkDirty(EXFAT_Volume_t* vol){
+    unsigned short flags;
+
+    if(vol->dirty != 0){
+        return 1;
+    }
+
+    // Neither field is covered by the boot region checksum
+    if(!WINDOW_Load(vol, vol->card, vol->volStart)){
+        return 0;
+    }
+    flags = SD_Load16(&window.data[106]);
+    SD_Store16(&window.data[106], flags | EXFAT_VOLUME_DIRTY);
+    window.data[112] = 0xFF;
+    window.dirty = 1;
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+    vol->dirty = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Finds one of a file's clusters. Contiguous files are a direct
+ *        lookup; otherwise the chain is followed from the cluster last looked
+ *        up, or from the start if that is further along
+ * @param file Pointer to the file
+ * @param idx Index of the cluster within the file
+ * @param cluster Set to the cluster number
+ * @return 1 if successful, 0 if the file doesn't have that many clusters or
+ *         an error occurred
+ */
+static unsigned char EXFAT_ClusterAt(
+    EXFAT_File_t* file,
+    unsigned long idx,
+    unsigned long* cluster
+)
+{
+    unsigned long next;
+
+    if(idx >= file->numClusters){
+        return 0;
+    }
+    if(file->contig){
+        *cluster = file->firstCluster + idx;
+        return 1;
+    }
+
+    if((idx < file->clusterIdx) || !exfat_valid(file->vol, file->cluster)){
+        file->cluster = file->firstCluster;
+        file->clusterIdx = 0;
+    }
+    while(file->clusterIdx < idx){
+        if(!EXFAT_GetEntry(file->vol, file->cluster, &next) ||
+           !exfat_valid(file->vol, next)){
+            return 0;
+        }
+        file->cluster = next;
+        file->clusterIdx++;
+    }
+    *cluster = file->cluster;
+
+    return 1;
+}
+
+/**
+ * @brief Allocates clusters to the end of a file. An empty file gets a run of
+ *        free clusters if there is one that is long enough. A contiguous file
+ *        is grown in place while the cluster after its end is free; once it
+ *        can't be, its clusters are chained in the FAT so that it can
+ *        continue elsewhere
+ * @param file Pointer to the file
+ * @param n Number of clusters to add
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_Extend(EXFAT_File_t* file, unsigned long n){
+    EXFAT_Volume_t* vol = file->vol;
+    unsigned long first;
+    unsigned long count = n;
+    unsigned long last;
+    unsigned long next;
+    unsigned char isFree;
+
+    if(!EXFAT_MarkDirty(vol)){
+        return 0;
+    }
+
+    if(file->numClusters == 0){
+        first = EXFAT_FindRun(vol, count);
+        if(first == 0){
+            count = 1;
+            first = EXFAT_FindRun(vol, count);
+            if(first == 0){
+                return 0;
+            }
+        }
+        if(!EXFAT_SetBits(vol, first, count, 1)){
+            return 0;
+        }
+        file->firstCluster = first;
+        file->numClusters = count;
+        file->cluster = first;
+        file->clusterIdx = 0;
+        file->contig = 1;
+        file->dirty = 1;
+        n -= count;
+    }
+
+    while(n > 0){
+        if(!EXFAT_ClusterAt(file, file->numClusters - 1, &last)){
+            return 0;
+        }
+
+        // Grow in place, leaving the FAT alone
+        next = last + 1;
+        if(file->contig && exfat_valid(vol, next)){
+            if(!EXFAT_IsFree(vol, next, &isFree)){
+                return 0;
+            }
+            if(isFree){
+                if(!EXFAT_SetBits(vol, next, 1, 1)){
+                    return 0;
+                }
+                file->numClusters++;
+                file->dirty = 1;
+                n--;
+                continue;
+            }
+        }
+
+        next = EXFAT_FindRun(vol, 1);
+        if(next == 0){
+            return 0;
+        }
+        if(file->contig){
+            // The clusters so far have to be recorded in the FAT first
+            for(unsigned long i = 0; i + 1 < file->numClusters; i++){
+                if(!EXFAT_SetEntry(
+                        vol,
+                        file->firstCluster + i,
+                        file->firstCluster + i + 1
+                    )
+                )
+                {
+                    return 0;
+                }
+            }
+            file->contig = 0;
+        }
+        if(!EXFAT_SetEntry(vol, last, next) ||
+           !EXFAT_SetEntry(vol, next, EXFAT_EOC) ||
+           !EXFAT_SetBits(vol, next, 1, 1)){
+            return 0;
+        }
+        file->numClusters++;
+        file->dirty = 1;
+        n--;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Frees the clusters past the end of a file's data that were reserved
+ *        since the file was opened
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_Trim(EXFAT_File_t* file){
+    EXFAT_Volume_t* vol = file->vol;
+    unsigned long keep = EXFAT_ClustersFor(vol, file->size);
+    unsigned long cluster;
+    unsigned long next;
+
+    // Space past the valid data length that the file already had is
+    // legitimately preallocated, so only this session's reservation goes
+    if(keep < file->openClusters){
+        keep = file->openClusters;
+    }
+    if(keep >= file->numClusters){
+        return 1;
+    }
+    if(!EXFAT_MarkDirty(vol)){
+        return 0;
+    }
+
+    if(file->contig){
+        if(!EXFAT_SetBits(
+                vol,
+                file->firstCluster + keep,
+                file->numClusters - keep,
+                0
+            )
+        )
+        {
+            return 0;
+        }
+    }
+    else{
+        // End the chain at the last cluster that is kept, then free the rest
+        if(keep == 0){
+            next = file->firstCluster;
+        }
+        else{
+            if(!EXFAT_ClusterAt(file, keep - 1, &cluster) ||
+               !EXFAT_GetEntry(vol, cluster, &next) ||
+               !EXFAT_SetEntry(vol, cluster, EXFAT_EOC)){
+                return 0;
+            }
+        }
+        for(unsigned long i = keep; i < file->numClusters; i++){
+            cluster = next;
+            if(!exfat_valid(vol, cluster) ||
+               !EXFAT_GetEntry(vol, cluster, &next) ||
+               !EXFAT_SetBits(vol, cluster, 1, 0)){
+                return 0;
+            }
+        }
+    }
+
+    file->numClusters = keep;
+    if(keep == 0){
+        file->firstCluster = 0;
+        file->contig = 0;
+    }
+    file->cluster = file->firstCluster;
+    file->clusterIdx = 0;
+    file->dirty = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Reads sectors of file data straight into a buffer, using a multiple
+ *        block read if there are several
+ * @param vol Pointer to the volume
+ * @param sector First sector to read
+ * @param numSectors Number of sectors to read
+ * @param buf Pointer to the array that will store the data
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_DataRead(
+    EXFAT_Volume_t* vol,
+    unsigned long sector,
+    unsigned long numSectors,
+    unsigned char* buf
+)
+{
+    // A modified copy of one of the sectors in the window is newer than the
+    // one on the card
+    if(window.dirty && WINDOW_Holds(vol, sector, numSectors)){
+        if(!WINDOW_Flush()){
+            return 0;
+        }
+    }
+
+    if(numSectors == 1){
+        return SD_SingleBlockRead(vol->card, sector, buf);
+    }
+
+    if(!SD_MBR_Start(vol->card, sector)){
+        return 0;
+    }
+    while(numSectors > 0){
+        SD_MBR_Receive(vol->card, buf);
+        buf += 512;
+        numSectors--;
+    }
+    SD_MBR_Stop(vol->card);
+
+    return 1;
+}
+
+/**
+ * @brief Writes sectors of file data straight from a buffer, using a
+ *        multiple block write if there are several
+ * @param vol Pointer to the volume
+ * @param sector First sector to write
+ * @param numSectors Number of sectors to write
+ * @param buf Pointer to the data
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_DataWrite(
+    EXFAT_Volume_t* vol,
+    unsigned long sector,
+    unsigned long numSectors,
+    const unsigned char* buf
+)
+{
+    unsigned char success = 1;
+
+    WINDOW_Drop(vol, sector, numSectors);
+
+    if(numSectors == 1){
+        return SD_SingleBlockWrite(vol->card, sector, (unsigned char*)buf);
+    }
+
+    SD_MBW_Start(vol->card, sector, numSectors);
+    while(numSectors > 0){
+        if(!SD_MBW_Send(vol->card, (unsigned char*)buf)){
+            success = 0;
+            break;
+        }
+        buf += 512;
+        numSectors--;
+    }
+    if(!SD_MBW_Stop(vol->card)){
+        success = 0;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Works out how many of the file's sectors follow on from the one at
+ *        the current position without a break on the card, counting that one
+ * @param file Pointer to the file
+ * @return The number of sectors
+ */
+static unsigned long EXFAT_RunLeft(EXFAT_File_t* file){
+    unsigned long spc = 1UL << file->vol->clusterShift;
+    unsigned long sectorIdx = file->pos >> 9;
+
+    if(file->contig){
+        return file->numClusters * spc - sectorIdx;
+    }
+
+    return spc - (sectorIdx & (spc - 1));
+}
+
+/**
+ * @brief Writes the file's size and clusters to its stream extension entry,
+ *        then updates the entry set's checksum. The data length decides how
+ *        many clusters belong to the file, so while clusters are reserved
+ *        past the data it covers all of them, and only the valid data length
+ *        gives the size
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_SyncEntry(EXFAT_File_t* file){
+    EXFAT_Volume_t* vol = file->vol;
+    EXFAT_Dir_t dir = file->entrySet;
+    unsigned long dataLength = file->size;
+    unsigned char* p;
+
+    if(file->dirty){
+        if(!EXFAT_MarkDirty(vol)){
+            return 0;
+        }
+        if(file->numClusters != EXFAT_ClustersFor(vol, file->size)){
+            dataLength = file->numClusters << (vol->clusterShift + 9);
+        }
+
+        // File entry: attributes and modification time
+        p = EXFAT_DirEntry(&dir);
+        if(p == NULL){
+            return 0;
+        }
+        SD_Store16(&p[4], SD_Load16(&p[4]) | EXFAT_ATTR_ARCHIVE);
+        SD_Store32(&p[12], EXFAT_TIMESTAMP);
+        SD_Store32(&p[16], EXFAT_TIMESTAMP);
+        p[21] = 0;
+        window.dirty = 1;
+
+        // Stream extension: where the data is and how long it is
+        if(!EXFAT_DirNext(&dir, 0)){
+            return 0;
+        }
+        p = EXFAT_DirEntry(&dir);
+        if((p == NULL) || (p[0] != EXFAT_TYPE_STREAM)){
+            return 0;
+        }
+        p[1] = EXFAT_ALLOC_POSSIBLE;
+        if(file->contig){
+            p[1] |= EXFAT_NO_FAT_CHAIN;
+        }
+        SD_Store32(&p[8], file->size);
+        SD_Store32(&p[12], 0);
+        SD_Store32(&p[20], file->firstCluster);
+        SD_Store32(&p[24], dataLength);
+        SD_Store32(&p[28], 0);
+        window.dirty = 1;
+
+        if(!EXFAT_SealSet(&file->entrySet)){
+            return 0;
+        }
+        file->dirty = 0;
+    }
+
+    return WINDOW_Flush();
+}
+
+/**
+ * @brief Starts traversing a directory
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state
+ * @param cluster First cluster of the directory
+ * @param numClusters Clusters in the directory if it is contiguous, or 0 if
+ *        its clusters are chained in the FAT
+ */
+static void EXFAT_DirStart(
+    EXFAT_Volume_t* vol,
+    EXFAT_Dir_t* dir,
+    unsigned long cluster,
+    unsigned long numClusters
+)
+{
+    dir->vol = vol;
+    dir->cluster = cluster;
+    dir->clusterIdx = 0;
+    dir->numClusters = numClusters;
+    dir->sector = EXFAT_ClusterToSector(vol, cluster);
+    dir->entry = 0;
+}
+
+/**
+ * @brief Loads the sector holding the current directory entry
+ * @param dir Pointer to the traversal state
+ * @return Pointer to the entry in the window, or NULL if an error occurred
+ */
+static unsigned char* EXFAT_DirEntry(EXFAT_Dir_t* dir){
+    if(!WINDOW_Load(dir->vol, dir->vol->card, dir->sector)){
+        return NULL;
+    }
+
+    return &window.data[(unsigned short)dir->entry * EXFAT_ENTRY_SIZE];
+}
+
+/**
+ * @brief Moves on to the next directory entry. A directory whose clusters are
+ *        chained in the FAT can be extended by a zeroed cluster when its end
+ *        is reached. Only the root directory may be extended this way, since
+ *        other directories also record their size in their parent
+ * @param dir Pointer to the traversal state
+ * @param extend 1 to extend the directory if needed, 0 otherwise
+ * @return 1 if successful, 0 at the end of the directory or if an error
+ *         occurred
+ */
+static unsigned char EXFAT_DirNext(EXFAT_Dir_t* dir, unsigned char extend){
+    EXFAT_Volume_t* vol = dir->vol;
+    SD_FillGen_t zeros;
+    unsigned long next;
+
+    dir->entry++;
+    if(dir->entry < EXFAT_ENTRIES_PER_SECTOR){
+        return 1;
+    }
+    dir->entry = 0;
+    dir->sector++;
+    if(((dir->sector - vol->heapStart) & ((1UL << vol->clusterShift) - 1))
+       != 0){
+        return 1;
+    }
+
+    if(dir->numClusters != 0){
+        if(dir->clusterIdx + 1 >= dir->numClusters){
+            return 0;
+        }
+        next = dir->cluster + 1;
+    }
+    else{
+        if(!EXFAT_GetEntry(vol, dir->cluster, &next)){
+            return 0;
+        }
+        if(!exfat_valid(vol, next)){
+            if(!extend){
+                return 0;
+            }
+
+            next = EXFAT_FindRun(vol, 1);
+            if((next == 0) || !EXFAT_MarkDirty(vol) ||
+               !EXFAT_SetBits(vol, next, 1, 1) ||
+               !EXFAT_SetEntry(vol, next, EXFAT_EOC) ||
+               !EXFAT_SetEntry(vol, dir->cluster, next) ||
+               !WINDOW_Flush()){
+                return 0;
+            }
+
+            // Unused entries have to read as zero
+            WINDOW_Drop(
+                vol,
+                EXFAT_ClusterToSector(vol, next),
+                1UL << vol->clusterShift
+            );
+            zeros.type = SD_FILL_CONSTANT;
+            zeros.value = 0x00;
+            if(!SD_FillBlocks(
+                    vol->card,
+                    EXFAT_ClusterToSector(vol, next),
+                    1UL << vol->clusterShift,
+                    &zeros
+                )
+            )
+            {
+                return 0;
+            }
+        }
+    }
+
+    dir->cluster = next;
+    dir->clusterIdx++;
+    dir->sector = EXFAT_ClusterToSector(vol, next);
+
+    return 1;
+}
+
+/**
+ * @brief Extracts the next component of a path
+ * @param path Pointer to the path. Advanced past the component and any
+ *        slashes that follow it
+ * @param name Set to point to the component
+ * @param len Set to the length of the component
+ * @return 1 if successful, 0 if the component is empty, too long or not a
+ *         valid ASCII name
+ */
+static unsigned char EXFAT_ParseName(
+    const char** path,
+    const char** name,
+    unsigned char* len
+)
+{
+    const char* s = *path;
+    unsigned short n = 0;
+    char c;
+
+    while(*s == '/'){
+        s++;
+    }
+    *name = s;
+    while((*s != '/') && (*s != '\0')){
+        c = *s++;
+        if((c < ' ') || (c > '~') ||
+           (strchr("\"*:<>?\\|", c) != NULL)){
+            return 0;
+        }
+        n++;
+    }
+    if((n == 0) || (n > 255)){
+        return 0;
+    }
+    *len = (unsigned char)n;
+
+    while(*s == '/'){
+        s++;
+    }
+    *path = s;
+
+    return 1;
+}
+
+/**
+ * @brief Computes the hash of a name that is kept in its stream extension
+ *        entry, over the upper case of each UTF-16 character
+ * @param vol Pointer to the volume
+ * @param name Pointer to the name
+ * @param len Length of the name
+ * @return The hash
+ */
+static unsigned short EXFAT_NameHash(
+    const EXFAT_Volume_t* vol,
+    const char* name,
+    unsigned char len
+)
+{
+    unsigned short hash = 0;
+
+    for(unsigned char i = 0; i < len; i++){
+        // Low byte, then the high byte, which is always 0 for ASCII
+        hash = (unsigned short)(((hash & 1) ? 0x8000 : 0) + (hash >> 1) +
+                                vol->upcase[(unsigned char)name[i]]);
+        hash = (unsigned short)(((hash & 1) ? 0x8000 : 0) + (hash >> 1));
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Checks whether the entry set at a file entry holds a name. The name
+ *        length and hash in the stream extension rule out most sets before
+ *        any file name entries are read
+ * @param dir Pointer to the traversal state, on the file entry. Moved along
+ * @param name Pointer to the name
+ * @param len Length of the name
+ * @param hash Hash of the name
+ * @return 1 if the name matches, 0 otherwise
+ */
+static unsigned char EXFAT_MatchSet(
+    EXFAT_Dir_t* dir,
+    const char* name,
+    unsigned char len,
+    unsigned short hash
+)
+{
+    const unsigned char* upcase = dir->vol->upcase;
+    unsigned char i = 0;
+    unsigned short c;
+    unsigned char* p;
+
+    if(!EXFAT_DirNext(dir, 0)){
+        return 0;
+    }
+    p = EXFAT_DirEntry(dir);
+    if((p == NULL) || (p[0] != EXFAT_TYPE_STREAM) || (p[3] != len) ||
+       (SD_Load16(&p[4]) != hash)){
+        return 0;
+    }
+
+    while(i < len){
+        if(!EXFAT_DirNext(dir, 0)){
+            return 0;
+        }
+        p = EXFAT_DirEntry(dir);
+        if((p == NULL) || (p[0] != EXFAT_TYPE_NAME)){
+            return 0;
+        }
+        for(unsigned char j = 0; (j < EXFAT_NAME_CHARS) && (i < len); j++){
+            c = SD_Load16(&p[2 + 2 * j]);
+            if((c >= 128) ||
+               (upcase[c] != upcase[(unsigned char)name[i]])){
+                return 0;
+            }
+            i++;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Looks for a name in a directory
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state. Left on the file entry if found
+ * @param dirCluster First cluster of the directory
+ * @param dirClusters Clusters in the directory if it is contiguous, or 0
+ * @param name Pointer to the name
+ * @param len Length of the name
+ * @return 1 if found, 0 otherwise
+ */
+static unsigned char EXFAT_Search(
+    EXFAT_Volume_t* vol,
+    EXFAT_Dir_t* dir,
+    unsigned long dirCluster,
+    unsigned long dirClusters,
+    const char* name,
+    unsigned char len
+)
+{
+    unsigned short hash = EXFAT_NameHash(vol, name, len);
+    EXFAT_Dir_t set;
+    unsigned char* p;
+
+    EXFAT_DirStart(vol, dir, dirCluster, dirClusters);
+    while(1){
+        p = EXFAT_DirEntry(dir);
+        if((p == NULL) || (p[0] == EXFAT_TYPE_END)){
+            return 0;
+        }
+        if(p[0] == EXFAT_TYPE_FILE){
+            set = *dir;
+            if(EXFAT_MatchSet(&set, name, len, hash)){
+                return 1;
+            }
+        }
+        if(!EXFAT_DirNext(dir, 0)){
+            return 0;
+        }
+    }
+}
+
+/**
+ * @brief Creates the entry set of an empty file in the first run of unused
+ *        entries that is long enough for it
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state. Left on the new file entry
+ * @param dirCluster First cluster of the directory
+ * @param dirClusters Clusters in the directory if it is contiguous, or 0
+ * @param name Pointer to the name
+ * @param len Length of the name
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_Create(
+    EXFAT_Volume_t* vol,
+    EXFAT_Dir_t* dir,
+    unsigned long dirCluster,
+    unsigned long dirClusters,
+    const char* name,
+    unsigned char len
+)
+{
+    unsigned char needed = 2 + (len + EXFAT_NAME_CHARS - 1) / EXFAT_NAME_CHARS;
+    unsigned char extend = (dirCluster == vol->rootCluster) ? 1 : 0;
+    unsigned char run = 0;
+    unsigned char i = 0;
+    EXFAT_Dir_t start;
+    unsigned char* p;
+
+    if(!EXFAT_MarkDirty(vol)){
+        return 0;
+    }
+
+    // Find the entries
+    EXFAT_DirStart(vol, dir, dirCluster, dirClusters);
+    start = *dir;
+    while(1){
+        p = EXFAT_DirEntry(dir);
+        if(p == NULL){
+            return 0;
+        }
+        if(p[0] & EXFAT_IN_USE){
+            run = 0;
+        }
+        else{
+            if(run == 0){
+                start = *dir;
+            }
+            run++;
+            if(run == needed){
+                break;
+            }
+        }
+        if(!EXFAT_DirNext(dir, extend)){
+            return 0;
+        }
+    }
+
+    // Fill them in
+    *dir = start;
+    for(unsigned char k = 0; k < needed; k++){
+        if((k != 0) && !EXFAT_DirNext(dir, 0)){
+            return 0;
+        }
+        p = EXFAT_DirEntry(dir);
+        if(p == NULL){
+            return 0;
+        }
+        memset(p, 0, EXFAT_ENTRY_SIZE);
+        if(k == 0){
+            p[0] = EXFAT_TYPE_FILE;
+            p[1] = needed - 1;
+            SD_Store16(&p[4], EXFAT_ATTR_ARCHIVE);
+            SD_Store32(&p[8], EXFAT_TIMESTAMP);
+            SD_Store32(&p[12], EXFAT_TIMESTAMP);
+            SD_Store32(&p[16], EXFAT_TIMESTAMP);
+        }
+        else if(k == 1){
+            p[0] = EXFAT_TYPE_STREAM;
+            p[1] = EXFAT_ALLOC_POSSIBLE;
+            p[3] = len;
+            SD_Store16(&p[4], EXFAT_NameHash(vol, name, len));
+        }
+        else{
+            p[0] = EXFAT_TYPE_NAME;
+            for(unsigned char j = 0; (j < EXFAT_NAME_CHARS) && (i < len); j++){
+                SD_Store16(&p[2 + 2 * j], (unsigned char)name[i++]);
+            }
+        }
+        window.dirty = 1;
+    }
+
+    *dir = start;
+
+    return EXFAT_SealSet(&start);
+}
+
+/**
+ * @brief Computes the checksum of an entry set and stores it in its file
+ *        entry. The set may span sectors, which are loaded in turn
+ * @param set Pointer to the position of the set's file entry
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char EXFAT_SealSet(const EXFAT_Dir_t* set){
+    EXFAT_Dir_t dir = *set;
+    unsigned short sum = 0;
+    unsigned char count;
+    unsigned char* p;
+
+    p = EXFAT_DirEntry(&dir);
+    if(p == NULL){
+        return 0;
+    }
+    count = p[1];
+
+    for(unsigned char k = 0; k <= count; k++){
+        if((k != 0) && !EXFAT_DirNext(&dir, 0)){
+            return 0;
+        }
+        p = EXFAT_DirEntry(&dir);
+        if(p == NULL){
+            return 0;
+        }
+        for(unsigned char j = 0; j < EXFAT_ENTRY_SIZE; j++){
+            // The checksum field itself is left out
+            if((k == 0) && ((j == 2) || (j == 3))){
+                continue;
+            }
+            sum = (unsigned short)(((sum & 1) ? 0x8000 : 0) + (sum >> 1) +
+                                   p[j]);
+        }
+    }
+
+    dir = *set;
+    p = EXFAT_DirEntry(&dir);
+    if(p == NULL){
+        return 0;
+    }
+    SD_Store16(&p[2], sum);
+    window.dirty = 1;
+
+    return 1;
+}
\ No newline at end of file
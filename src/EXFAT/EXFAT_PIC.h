@@ -0,0 +1,259 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 22, 2026, 9:30 AM
+ *
+ * @defgroup EXFAT
+ * @brief exFAT file system for SDXC cards, which come formatted as exFAT, so
+ *        that files can be read and appended to without reformatting the
+ *        card. Free clusters are tracked in the allocation bitmap, names are
+ *        matched through the volume's upcase table, and files are kept
+ *        contiguous ("NoFatChain") for as long as possible, in which case
+ *        the FAT is never touched: appending to such a file only sets bits in
+ *        the bitmap as clusters are added, and whole sectors are written with
+ *        multiple block writes (CMD25). Like the FAT module, all metadata goes
+ *        through the shared 512 byte sector window. Names are limited to ASCII,
+ *        files to 4 GB, and directories cannot be created
+ * @{
+ */
+
+#ifndef EXFAT_PIC_H
+#define EXFAT_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/**
+ * @brief Timestamp of files that are created or modified (DOS date in the
+ *        upper 16 bits, DOS time in the lower 16 bits)
+ */
+#ifndef EXFAT_TIMESTAMP
+#define EXFAT_TIMESTAMP \
+    ((((2017UL - 1980UL) << 9) | (7UL << 5) | 21UL) << 16)
+#endif
+
+/** @brief File attribute: read only */
+#define EXFAT_ATTR_READ_ONLY 0x0001
+/** @brief File attribute: hidden */
+#define EXFAT_ATTR_HIDDEN    0x0002
+/** @brief File attribute: system */
+#define EXFAT_ATTR_SYSTEM    0x0004
+/** @brief File attribute: directory */
+#define EXFAT_ATTR_DIRECTORY 0x0010
+/** @brief File attribute: archive */
+#define EXFAT_ATTR_ARCHIVE   0x0020
+
+/********************************** Types ************************************/
+/** @brief Ways in which a file can be opened */
+typedef enum{
+    EXFAT_MODE_READ = 0,  /**< Read, starting at the beginning              */
+    EXFAT_MODE_APPEND = 1 /**< Append to the end, creating the file if needed */
+}exfat_mode_e;
+
+/** @brief A mounted exFAT volume */
+typedef struct{
+    SDCard_t* card;             /**< Card holding the volume */
+    unsigned long volStart;     /**< Sector of the boot sector */
+    unsigned long fatStart;     /**< First sector of the active FAT */
+    unsigned long heapStart;    /**< First sector of the cluster heap */
+    unsigned long numClusters;  /**< Clusters in the cluster heap */
+    unsigned long rootCluster;  /**< First cluster of the root directory */
+    unsigned long bitmapStart;  /**< First sector of the allocation bitmap */
+    unsigned long freeHint;     /**< Cluster to start looking for free ones */
+    unsigned char clusterShift; /**< log2 of the sectors per cluster */
+    unsigned char dirty;        /**< 1 once this driver has set the volume
+                                 *   dirty flag, 2 if it was already set */
+    unsigned char upcase[128];  /**< Upper case of each ASCII character, as
+                                 *   given by the volume's upcase table */
+}EXFAT_Volume_t;
+
+/** @brief Position in a directory */
+typedef struct{
+    EXFAT_Volume_t* vol;       /**< Volume the directory is on */
+    unsigned long cluster;     /**< Current cluster */
+    unsigned long clusterIdx;  /**< Index of the current cluster */
+    unsigned long numClusters; /**< Clusters in a contiguous directory, or 0
+                                *   if its clusters are chained in the FAT */
+    unsigned long sector;      /**< Current sector */
+    unsigned char entry;       /**< Entry within the current sector */
+}EXFAT_Dir_t;
+
+/** @brief An open file */
+typedef struct{
+    EXFAT_Volume_t* vol;        /**< Volume the file is on */
+    EXFAT_Dir_t entrySet;       /**< Position of the file's directory entry */
+    unsigned long firstCluster; /**< First cluster, or 0 if none */
+    unsigned long numClusters;  /**< Clusters allocated to the file */
+    unsigned long openClusters; /**< Clusters allocated when the file was
+                                 *   opened, which closing never frees */
+    unsigned long size;         /**< Bytes of data (valid data length) */
+    unsigned long pos;          /**< Current position */
+    unsigned long cluster;      /**< Cluster last looked up */
+    unsigned long clusterIdx;   /**< Index of that cluster within the file */
+    exfat_mode_e mode;          /**< Mode the file was opened in */
+    unsigned char contig;       /**< 1 if the clusters are consecutive and not
+                                 *   recorded in the FAT (NoFatChain) */
+    unsigned char dirty;        /**< 1 if the directory entry is out of date */
+    unsigned char streaming;    /**< 1 while a stream is open */
+}EXFAT_File_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Mounts an exFAT volume, which may start at sector 0 or be the first
+ *        exFAT partition listed in an MBR
+ * @pre The card has been initialized using initSD
+ * @param vol Pointer to the volume
+ * @param card Pointer to the card
+ * @return 1 if successful, 0 if no exFAT volume with 512 byte sectors was
+ *         found
+ */
+unsigned char EXFAT_Mount(EXFAT_Volume_t* vol, SDCard_t* card);
+
+/**
+ * @brief Mounts the exFAT volume that starts at a given block, e.g. a
+ *        partition found using the PART module
+ * @pre The card has been initialized using initSD
+ * @param vol Pointer to the volume
+ * @param card Pointer to the card
+ * @param startBlock Block holding the volume's boot sector
+ * @return 1 if successful, 0 if there is no supported volume there
+ */
+unsigned char EXFAT_MountPartition(
+    EXFAT_Volume_t* vol,
+    SDCard_t* card,
+    unsigned long startBlock
+);
+
+/**
+ * @brief Writes back any metadata still in the window and clears the volume
+ *        dirty flag, if this driver set it
+ * @pre Every file on the volume has been closed
+ * @param vol Pointer to the volume
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char EXFAT_Unmount(EXFAT_Volume_t* vol);
+
+/**
+ * @brief Opens a file
+ * @param vol Pointer to the volume
+ * @param file Pointer to the file
+ * @param path Path of the file, e.g. "LOGS/run 1.bin". Case insensitive
+ * @param mode EXFAT_MODE_READ or EXFAT_MODE_APPEND. In append mode, a file
+ *        that doesn't exist is created. New entries can only be added to
+ *        full directories if they are the root directory
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char EXFAT_Open(
+    EXFAT_Volume_t* vol,
+    EXFAT_File_t* file,
+    const char* path,
+    exfat_mode_e mode
+);
+
+/**
+ * @brief Reads from a file at the current position. Whole sectors are read
+ *        directly into buf
+ * @param file Pointer to the file
+ * @param buf Pointer to the array that will store the data
+ * @param len Number of bytes to read
+ * @return The number of bytes read, which is less than len at the end of the
+ *         file or if an error occurred
+ */
+unsigned short EXFAT_Read(
+    EXFAT_File_t* file,
+    unsigned char* buf,
+    unsigned short len
+);
+
+/**
+ * @brief Moves the position of a file opened for reading
+ * @param file Pointer to the file
+ * @param pos New position, no further than the end of the file
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char EXFAT_Seek(EXFAT_File_t* file, unsigned long pos);
+
+/**
+ * @brief Appends to a file. Clusters are taken from the bitmap as needed;
+ *        while the cluster after the file's last one is free, the file stays
+ *        contiguous and the FAT isn't touched. Whole sectors are written
+ *        directly from buf, with a multiple block write when there are several
+ * @param file Pointer to the file, opened in append mode
+ * @param buf Pointer to the bytes to be written
+ * @param len Number of bytes to write
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char EXFAT_Write(
+    EXFAT_File_t* file,
+    const unsigned char* buf,
+    unsigned short len
+);
+
+/**
+ * @brief Allocates clusters for data that is yet to be appended, so that
+ *        they can be streamed (see EXFAT_StreamStart). An empty file gets a
+ *        free run of clusters that is long enough if there is one; otherwise
+ *        the file is grown in place where possible. Clusters that are still
+ *        unused when the file is closed are freed
+ * @param file Pointer to the file, opened in append mode
+ * @param numBytes Number of bytes to make room for past the end of the file
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char EXFAT_Reserve(EXFAT_File_t* file, unsigned long numBytes);
+
+/**
+ * @brief Opens a single multiple block write (CMD25) covering the rest of the
+ *        file's allocated clusters. Sectors are then sent at raw speed using
+ *        EXFAT_StreamSend; neither the bitmap nor the directory is touched
+ *        until EXFAT_Sync or EXFAT_Close
+ * @pre Space was reserved using EXFAT_Reserve and the file is contiguous. No
+ *      other file on the card is accessed until the stream is stopped, except
+ *      through EXFAT_Sync on this file
+ * @param file Pointer to the file. Its size must be a multiple of 512
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char EXFAT_StreamStart(EXFAT_File_t* file);
+
+/**
+ * @brief Sends the next sector of a stream, growing the file
+ * @pre The stream was opened using EXFAT_StreamStart
+ * @param file Pointer to the file
+ * @param arrWrite Pointer to the 512 bytes to be written
+ * @return 1 if successful, 0 if the card rejected the sector or the reserved
+ *         space is used up
+ */
+unsigned char EXFAT_StreamSend(EXFAT_File_t* file, unsigned char* arrWrite);
+
+/**
+ * @brief Stops a stream
+ * @pre The stream was opened using EXFAT_StreamStart
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise (see SD_MBW_Stop)
+ */
+unsigned char EXFAT_StreamStop(EXFAT_File_t* file);
+
+/**
+ * @brief Writes the file's size and clusters to its directory entry. Reserved
+ *        clusters are recorded as allocated, past the valid data length, so
+ *        the volume stays consistent if power is lost
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char EXFAT_Sync(EXFAT_File_t* file);
+
+/**
+ * @brief Closes a file. For a file opened in append mode, clusters reserved
+ *        since it was opened that weren't used are freed. Clusters the file
+ *        already had past its data (e.g. preallocated by a PC) are kept
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char EXFAT_Close(EXFAT_File_t* file);
+
+/**
+ * @}
+ */
+
+#endif	/* EXFAT_PIC_H */
\ No newline at end of file
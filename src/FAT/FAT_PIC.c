@@ -0,0 +1,2440 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 21, 2026, 10:00 AM
+ *
+ * @ingroup FAT
+ */
+
+/********************************* Includes **********************************/
+#include <string.h>
+#include "FAT_PIC.h"
+#include "../WINDOW/WINDOW_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Marks a FAT sector number as unset */
+#define FAT_NO_SECTOR 0xFFFFFFFFUL
+
+/** @brief Size of a directory entry, in bytes */
+#define FAT_ENTRY_SIZE 32
+
+/** @brief Directory entries per sector */
+#define FAT_ENTRIES_PER_SECTOR (512 / FAT_ENTRY_SIZE)
+
+/** @brief Attribute combination marking a long file name entry */
+#define FAT_ATTR_LFN 0x0F
+
+/** @brief First byte of a deleted directory entry */
+#define FAT_DELETED 0xE5
+
+/** @brief FSInfo lead signature */
+#define FAT_FSI_LEAD 0x41615252UL
+
+/** @brief FSInfo structure signature */
+#define FAT_FSI_STRUC 0x61417272UL
+
+/** @brief Stamp of a sealed free-space map, in FSInfo's reserved bytes */
+#define FAT_MAP_MAGIC 0x50414D46UL
+
+/** @brief Largest group of FAT sectors that the fine map is used with */
+#define FAT_MAX_GROUP 256
+
+/** @brief Checks whether a directory entry is in use and names a file or
+ *         directory */
+#define fat_entry_live(p) \
+    (((p)[0] != FAT_DELETED) && ((p)[11] != FAT_ATTR_LFN) && \
+     !((p)[11] & FAT_ATTR_VOLUME_ID))
+
+#ifdef FAT_USE_INDEX
+/** @brief Name of the directory index file, as stored in its entry */
+#define FAT_INDEX_NAME "DIRINDEXSYS"
+
+/** @brief Stamp at the start of a directory index's header ("DIDX") */
+#define FAT_INDEX_MAGIC 0x58444944UL
+
+/** @brief Hash buckets per index sector */
+#define FAT_INDEX_PER_SECTOR 64
+
+/** @brief Number of hash buckets in a directory index */
+#define FAT_INDEX_BUCKETS (FAT_INDEX_SECTORS * FAT_INDEX_PER_SECTOR)
+
+/** @brief Results of an index lookup */
+#define FAT_INDEX_MISS  0 /**< The name is not in the directory */
+#define FAT_INDEX_HIT   1 /**< The name was found */
+#define FAT_INDEX_STALE 2 /**< The index can't be trusted */
+#endif
+
+/** @brief Checks whether a group of FAT sectors may have free clusters */
+#define fat_group_free(vol, g) (((vol)->freeMap[(g) >> 3] >> ((g) & 7)) & 1)
+
+/***************************** Private Variables *****************************/
+/** @brief Fine map bits of the group being scanned for free clusters */
+static unsigned char groupMap[FAT_MAX_GROUP / 8];
+
+/************************ Private Function Prototypes ************************/
+static unsigned char FAT_WindowLoad(FAT_Volume_t* vol, unsigned long sector);
+static unsigned char FAT_IsBootSector(void);
+static unsigned char FAT_MountAt(FAT_Volume_t* vol, unsigned long partStart);
+static unsigned long FAT_ClusterToSector(
+    const FAT_Volume_t* vol,
+    unsigned long cluster
+);
+static unsigned char FAT_IsEOC(const FAT_Volume_t* vol, unsigned long value);
+static unsigned char FAT_GetEntry(
+    FAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long* value
+);
+static unsigned char FAT_SetEntry(
+    FAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long value
+);
+static unsigned char FAT_IsFSInfo(void);
+static void FAT_InitFreeMap(FAT_Volume_t* vol, unsigned long partStart);
+static unsigned char FAT_Unseal(FAT_Volume_t* vol);
+static unsigned char FAT_ScanGroup(
+    FAT_Volume_t* vol,
+    unsigned short group,
+    unsigned long from,
+    unsigned long* cluster
+);
+static unsigned char FAT_MarkFree(FAT_Volume_t* vol, unsigned long fatSector);
+static unsigned long FAT_AllocCluster(FAT_Volume_t* vol, unsigned long prev);
+static unsigned long FAT_FindRun(FAT_Volume_t* vol, unsigned long numClusters);
+static unsigned char FAT_FreeChain(FAT_Volume_t* vol, unsigned long cluster);
+static unsigned char FAT_DataRead(
+    FAT_Volume_t* vol,
+    unsigned long sector,
+    unsigned long numSectors,
+    unsigned char* buf
+);
+static unsigned char FAT_DataWrite(
+    FAT_Volume_t* vol,
+    unsigned long sector,
+    unsigned long numSectors,
+    unsigned char* buf
+);
+static unsigned char FAT_Locate(FAT_File_t* file, unsigned char allocate);
+static unsigned char FAT_SyncEntry(FAT_File_t* file);
+static FAT_Extent_t* FAT_FindExtent(FAT_File_t* file, unsigned long idx);
+static unsigned char FAT_MapExtents(FAT_File_t* file);
+static unsigned long FAT_RunLength(FAT_File_t* file);
+static unsigned char FAT_OpenEntry(
+    FAT_Volume_t* vol,
+    FAT_File_t* file,
+    unsigned long dirCluster,
+    const char* name,
+    fat_mode_e mode
+);
+static unsigned char FAT_ParseName(const char** path, char* name83);
+static unsigned long FAT_EntryCluster(
+    const FAT_Volume_t* vol,
+    const unsigned char* entry
+);
+static void FAT_DirStart(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long cluster
+);
+static unsigned char* FAT_DirEntry(FAT_Dir_t* dir);
+static unsigned char FAT_DirNext(FAT_Dir_t* dir, unsigned char extend);
+static unsigned char FAT_Search(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long dirCluster,
+    const char* name83
+);
+static unsigned char FAT_FindFree(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long dirCluster
+);
+static unsigned char FAT_Lookup(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long dirCluster,
+    const char* name83
+);
+static unsigned char FAT_NewEntry(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long dirCluster
+);
+#ifdef FAT_USE_INDEX
+static unsigned char FAT_IndexCovers(
+    const FAT_Volume_t* vol,
+    unsigned long dirCluster
+);
+static unsigned short FAT_IndexHash(const char* name83);
+static unsigned char FAT_IndexLookup(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    const char* name83
+);
+static unsigned char FAT_IndexInsert(
+    FAT_Volume_t* vol,
+    const char* name83,
+    unsigned long sector,
+    unsigned char slot
+);
+static void FAT_IndexAdd(
+    FAT_Volume_t* vol,
+    const FAT_Dir_t* dir,
+    const char* name83
+);
+static unsigned short FAT_IndexMix(
+    unsigned short crc,
+    const FAT_Dir_t* dir,
+    const unsigned char* entry
+);
+static unsigned char FAT_IndexSave(FAT_Volume_t* vol);
+static unsigned char FAT_IndexCheck(FAT_Volume_t* vol);
+#endif
+
+/***************************** Public Functions ******************************/
+unsigned char FAT_Mount(FAT_Volume_t* vol, SDCard_t* card){
+    unsigned char* p;
+    unsigned char type;
+
+    // The window may hold a sector of a previous mount of this volume
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+    WINDOW_Reset();
+
+    vol->card = card;
+    if(!FAT_WindowLoad(vol, 0) || (SD_Load16(&window.data[510]) != 0xAA55)){
+        return 0;
+    }
+
+    // Superfloppy: the volume starts at sector 0
+    if(FAT_IsBootSector()){
+        return FAT_MountAt(vol, 0);
+    }
+
+    // Otherwise, sector 0 is an MBR. Mount the first FAT16/FAT32 partition
+    for(unsigned char i = 0; i < 4; i++){
+        p = &window.data[446 + 16 * i];
+        type = p[4];
+        if((type == 0x04) || (type == 0x06) || (type == 0x0E) ||
+           (type == 0x0B) || (type == 0x0C)){
+            return FAT_MountAt(vol, SD_Load32(&p[8]));
+        }
+    }
+
+    return 0;
+}
+
+unsigned char FAT_MountPartition(
+    FAT_Volume_t* vol,
+    SDCard_t* card,
+    unsigned long startBlock
+)
+{
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+    WINDOW_Reset();
+    vol->card = card;
+
+    return FAT_MountAt(vol, startBlock);
+}
+
+unsigned char FAT_Unmount(FAT_Volume_t* vol){
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+
+    if(vol->unsealed){
+        if(!FAT_WindowLoad(vol, vol->fsInfoSector)){
+            return 0;
+        }
+        if(FAT_IsFSInfo()){
+            SD_Store32(&window.data[492], vol->freeHint);
+            if(vol->mapSector != 0){
+                // The stamp records the FSInfo fields it was sealed with.
+                // Drivers that allocate clusters update them
+                SD_Store32(&window.data[496], FAT_MAP_MAGIC);
+                SD_Store32(&window.data[500], SD_Load32(&window.data[488]));
+                SD_Store32(&window.data[504], vol->freeHint);
+            }
+            window.dirty = 1;
+        }
+        if(!WINDOW_Flush()){
+            return 0;
+        }
+        vol->unsealed = 0;
+    }
+
+    WINDOW_Reset();
+
+    return 1;
+}
+
+unsigned char FAT_Open(
+    FAT_Volume_t* vol,
+    FAT_File_t* file,
+    const char* path,
+    fat_mode_e mode
+)
+{
+    FAT_Dir_t dir;
+    char name[11];
+    unsigned long dirCluster = 0;
+    unsigned char* p;
+
+    // Walk down the path to the file's directory, one component at a time
+    while(1){
+        if(!FAT_ParseName(&path, name)){
+            return 0;
+        }
+        if(*path == '\0'){
+            break;
+        }
+        if(!FAT_Lookup(vol, &dir, dirCluster, name)){
+            return 0;
+        }
+        p = FAT_DirEntry(&dir);
+        if((p == NULL) || !(p[11] & FAT_ATTR_DIRECTORY)){
+            return 0;
+        }
+        dirCluster = FAT_EntryCluster(vol, p);
+    }
+
+    return FAT_OpenEntry(vol, file, dirCluster, name, mode);
+}
+
+unsigned short FAT_Read(
+    FAT_File_t* file,
+    unsigned char* buf,
+    unsigned short len
+)
+{
+    FAT_Volume_t* vol = file->vol;
+    unsigned long sector;
+    unsigned long n;
+    unsigned long room;
+    unsigned short offset;
+    unsigned short chunk;
+    unsigned short done = 0;
+
+    if(file->streaming || file->reading || (file->pos >= file->size)){
+        return 0;
+    }
+    if(len > file->size - file->pos){
+        len = (unsigned short)(file->size - file->pos);
+    }
+
+    while(done < len){
+        if(!FAT_Locate(file, 0)){
+            break;
+        }
+        offset = (unsigned short)(file->pos % 512);
+        room = vol->sectorsPerCluster -
+               ((file->pos / 512) % vol->sectorsPerCluster);
+        sector = FAT_ClusterToSector(vol, file->cluster) +
+                 (vol->sectorsPerCluster - room);
+
+        if((offset == 0) && (len - done >= 512)){
+            // Whole sectors go straight into the caller's buffer, in one
+            // multiple block read for as long as the clusters are consecutive
+            room += (FAT_RunLength(file) - 1) * vol->sectorsPerCluster;
+            n = (len - done) / 512;
+            if(n > room){
+                n = room;
+            }
+            if(!FAT_DataRead(vol, sector, n, &buf[done])){
+                break;
+            }
+            chunk = (unsigned short)n * 512;
+        }
+        else{
+            if(!FAT_WindowLoad(vol, sector)){
+                break;
+            }
+            chunk = 512 - offset;
+            if(chunk > len - done){
+                chunk = len - done;
+            }
+            memcpy(&buf[done], &window.data[offset], chunk);
+        }
+
+        file->pos += chunk;
+        done += chunk;
+    }
+
+    return done;
+}
+
+unsigned short FAT_Write(
+    FAT_File_t* file,
+    unsigned char* buf,
+    unsigned short len
+)
+{
+    FAT_Volume_t* vol = file->vol;
+    unsigned long sector;
+    unsigned long n;
+    unsigned long room;
+    unsigned short offset;
+    unsigned short chunk;
+    unsigned short done = 0;
+
+    if((file->mode == FAT_MODE_READ) || file->streaming || file->reading){
+        return 0;
+    }
+
+    while(done < len){
+        if(!FAT_Locate(file, 1)){
+            break;
+        }
+        offset = (unsigned short)(file->pos % 512);
+        room = vol->sectorsPerCluster -
+               ((file->pos / 512) % vol->sectorsPerCluster);
+        sector = FAT_ClusterToSector(vol, file->cluster) +
+                 (vol->sectorsPerCluster - room);
+
+        if((offset == 0) && (len - done >= 512)){
+            // Whole sectors go straight from the caller's buffer
+            n = (len - done) / 512;
+            if(n > room){
+                n = room;
+            }
+            if(!FAT_DataWrite(vol, sector, n, &buf[done])){
+                break;
+            }
+            chunk = (unsigned short)n * 512;
+        }
+        else{
+            // A sector that starts at or past the end of the file holds
+            // nothing worth preserving, so it needn't be read first
+            if((offset == 0) && (file->pos >= file->size)){
+                if(!WINDOW_Flush()){
+                    break;
+                }
+                WINDOW_Claim(vol, vol->card, sector);
+            }
+            else if(!FAT_WindowLoad(vol, sector)){
+                break;
+            }
+            chunk = 512 - offset;
+            if(chunk > len - done){
+                chunk = len - done;
+            }
+            memcpy(&window.data[offset], &buf[done], chunk);
+            window.dirty = 1;
+        }
+
+        file->pos += chunk;
+        done += chunk;
+        if(file->pos > file->size){
+            file->size = file->pos;
+            file->dirty = 1;
+        }
+    }
+
+    return done;
+}
+
+unsigned char FAT_Seek(FAT_File_t* file, unsigned long pos){
+    if(pos > file->size){
+        return 0;
+    }
+
+    // The cluster is located lazily by the next read or write
+    file->pos = pos;
+
+    return 1;
+}
+
+unsigned char FAT_Preallocate(FAT_File_t* file, unsigned long numBytes){
+    FAT_Volume_t* vol = file->vol;
+    unsigned long clusterBytes = vol->sectorsPerCluster * 512UL;
+    unsigned long n = (numBytes + clusterBytes - 1) / clusterBytes;
+    unsigned long first;
+    unsigned long eoc = (vol->type == FAT_TYPE_FAT32) ?
+                        0x0FFFFFFFUL : 0xFFFFUL;
+
+    if((file->mode == FAT_MODE_READ) || (file->firstCluster != 0) ||
+       (n == 0)){
+        return 0;
+    }
+
+    first = FAT_FindRun(vol, n);
+    if(first == 0){
+        return 0;
+    }
+
+    // Consecutive entries share FAT sectors, so linking the whole chain
+    // costs one window flush per 128 or 256 clusters
+    if(!FAT_Unseal(vol)){
+        return 0;
+    }
+    for(unsigned long i = 0; i < n; i++){
+        if(!FAT_SetEntry(vol, first + i, (i == n - 1) ? eoc : first + i + 1)){
+            return 0;
+        }
+    }
+    if((vol->freeHint >= first) && (vol->freeHint < first + n)){
+        vol->freeHint = first + n;
+    }
+
+    file->firstCluster = first;
+    file->cluster = first;
+    file->clusterIdx = 0;
+    file->contigClusters = n;
+    file->dirty = 1;
+
+    return 1;
+}
+
+unsigned char FAT_StreamStart(FAT_File_t* file){
+    FAT_Volume_t* vol = file->vol;
+    unsigned long sectorIdx = file->pos / 512;
+    unsigned long numSectors = file->contigClusters * vol->sectorsPerCluster;
+    unsigned long sector;
+
+    if((file->contigClusters == 0) || file->streaming ||
+       (file->pos % 512 != 0) || (sectorIdx >= numSectors)){
+        return 0;
+    }
+
+    // The stream holds the card until it is stopped, so pending metadata
+    // has to reach the card first. A copy of one of the streamed sectors in
+    // the window would go stale
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+    sector = FAT_ClusterToSector(vol, file->firstCluster) + sectorIdx;
+    WINDOW_Drop(vol, sector, numSectors - sectorIdx);
+
+    SD_MBW_Start(vol->card, sector, numSectors - sectorIdx);
+    file->streaming = 1;
+
+    return 1;
+}
+
+unsigned char FAT_StreamSend(FAT_File_t* file, unsigned char* arrWrite){
+    unsigned long numSectors;
+
+    if(!file->streaming){
+        return 0;
+    }
+    numSectors = file->contigClusters * file->vol->sectorsPerCluster;
+    if(file->pos / 512 >= numSectors){
+        return 0;
+    }
+
+    if(!SD_MBW_Send(file->vol->card, arrWrite)){
+        return 0;
+    }
+    file->pos += 512;
+    if(file->pos > file->size){
+        file->size = file->pos;
+        file->dirty = 1;
+    }
+
+    return 1;
+}
+
+unsigned char FAT_StreamStop(FAT_File_t* file){
+    if(!file->streaming){
+        return 1;
+    }
+    file->streaming = 0;
+
+    return SD_MBW_Stop(file->vol->card);
+}
+
+unsigned char FAT_ReadStreamStart(FAT_File_t* file){
+    if(file->streaming || file->reading || (file->pos % 512 != 0)){
+        return 0;
+    }
+
+    // The first multiple block read is opened by FAT_ReadStreamNext
+    file->reading = 1;
+    file->runLeft = 0;
+
+    return 1;
+}
+
+unsigned short FAT_ReadStreamNext(FAT_File_t* file, unsigned char* buf){
+    FAT_Volume_t* vol = file->vol;
+    unsigned long sectorIdx;
+    unsigned long numLeft;
+    unsigned short chunk;
+
+    if(!file->reading || (file->pos >= file->size)){
+        return 0;
+    }
+
+    if(file->runLeft == 0){
+        // Open a multiple block read over the rest of the current run of
+        // consecutive clusters, up to the end of the file
+        if(!FAT_Locate(file, 0)){
+            return 0;
+        }
+        sectorIdx = (file->pos / 512) % vol->sectorsPerCluster;
+        file->runLeft = FAT_RunLength(file) * vol->sectorsPerCluster -
+                        sectorIdx;
+        numLeft = (file->size - file->pos + 511) / 512;
+        if(file->runLeft > numLeft){
+            file->runLeft = numLeft;
+        }
+
+        // The window can't be flushed once the read is open
+        if(!WINDOW_Flush()){
+            file->runLeft = 0;
+            return 0;
+        }
+        if(!SD_MBR_Start(
+                vol->card,
+                FAT_ClusterToSector(vol, file->cluster) + sectorIdx
+            )
+        )
+        {
+            file->runLeft = 0;
+            return 0;
+        }
+    }
+
+    SD_MBR_Receive(vol->card, buf);
+    file->runLeft--;
+    if(file->runLeft == 0){
+        SD_MBR_Stop(vol->card);
+    }
+
+    chunk = (file->size - file->pos < 512) ?
+            (unsigned short)(file->size - file->pos) : 512;
+    file->pos += chunk;
+
+    return chunk;
+}
+
+void FAT_ReadStreamStop(FAT_File_t* file){
+    if(file->runLeft != 0){
+        SD_MBR_Stop(file->vol->card);
+        file->runLeft = 0;
+    }
+    file->reading = 0;
+}
+
+unsigned char FAT_Sync(FAT_File_t* file){
+    SDCard_t* card = file->vol->card;
+    SDWriteState_t savedWrite;
+    unsigned char success;
+
+    // A read stream reopens its multiple block read on the next sector
+    if(file->runLeft != 0){
+        SD_MBR_Stop(card);
+        file->runLeft = 0;
+    }
+
+    if(!file->streaming){
+        return FAT_SyncEntry(file);
+    }
+
+    // Park the stream at a block boundary. The directory update uses single
+    // block transfers, which would otherwise overwrite the bookkeeping the
+    // multiple block write resumes from
+    SD_MBW_Suspend(card);
+    savedWrite = card->write;
+    success = FAT_SyncEntry(file);
+    card->write = savedWrite;
+    SD_MBW_Resume(card);
+
+    return success;
+}
+
+unsigned char FAT_Close(FAT_File_t* file){
+    unsigned char success;
+
+    FAT_ReadStreamStop(file);
+    success = FAT_StreamStop(file);
+
+    if(!FAT_Sync(file)){
+        success = 0;
+    }
+
+    return success;
+}
+
+unsigned char FAT_OpenDir(FAT_Volume_t* vol, FAT_Dir_t* dir, const char* path){
+    char name[11];
+    unsigned long dirCluster = 0;
+    unsigned char* p;
+
+    while(*path == '/'){
+        path++;
+    }
+    while(*path != '\0'){
+        if(!FAT_ParseName(&path, name)){
+            return 0;
+        }
+        if(!FAT_Lookup(vol, dir, dirCluster, name)){
+            return 0;
+        }
+        p = FAT_DirEntry(dir);
+        if((p == NULL) || !(p[11] & FAT_ATTR_DIRECTORY)){
+            return 0;
+        }
+        dirCluster = FAT_EntryCluster(vol, p);
+    }
+
+    FAT_DirStart(vol, dir, dirCluster);
+
+    return 1;
+}
+
+unsigned char FAT_ReadDir(FAT_Dir_t* dir, FAT_DirInfo_t* info){
+    unsigned char* p;
+    unsigned char j;
+
+    while(!dir->end){
+        p = FAT_DirEntry(dir);
+        if((p == NULL) || (p[0] == 0x00)){
+            // 0x00 marks the end of the used entries
+            dir->end = 1;
+            break;
+        }
+
+        if((p[0] != FAT_DELETED) && (p[11] != FAT_ATTR_LFN) &&
+           !(p[11] & FAT_ATTR_VOLUME_ID)){
+            // Format the 8.3 name as NAME.EXT
+            j = 0;
+            for(unsigned char i = 0; i < 8; i++){
+                if(p[i] != ' '){
+                    info->name[j++] = (char)p[i];
+                }
+            }
+            if(p[8] != ' '){
+                info->name[j++] = '.';
+                for(unsigned char i = 8; i < 11; i++){
+                    if(p[i] != ' '){
+                        info->name[j++] = (char)p[i];
+                    }
+                }
+            }
+            info->name[j] = '\0';
+
+            // 0x05 stands in for a leading 0xE5 character
+            if(p[0] == 0x05){
+                info->name[0] = (char)FAT_DELETED;
+            }
+            info->attr = p[11];
+            info->size = SD_Load32(&p[28]);
+            info->cluster = FAT_EntryCluster(dir->vol, p);
+
+            if(!FAT_DirNext(dir, 0)){
+                dir->end = 1;
+            }
+            return 1;
+        }
+
+        if(!FAT_DirNext(dir, 0)){
+            dir->end = 1;
+        }
+    }
+
+    return 0;
+}
+
+#ifdef FAT_USE_INDEX
+unsigned char FAT_IndexAttach(FAT_Volume_t* vol, const char* path){
+    FAT_Dir_t dir;
+    FAT_File_t file;
+    unsigned long bytes = (1UL + FAT_INDEX_SECTORS) * 512;
+    unsigned long clusters;
+    unsigned long next;
+    unsigned char* p;
+    unsigned char fresh = 0;
+
+    FAT_IndexDetach(vol);
+    if(!FAT_OpenDir(vol, &dir, path)){
+        return 0;
+    }
+
+    // The index file: a header sector, then the hash buckets. It is
+    // contiguous, so its sectors can be addressed directly
+    if(!FAT_OpenEntry(
+            vol,
+            &file,
+            dir.cluster,
+            FAT_INDEX_NAME,
+            FAT_MODE_APPEND
+        )
+    )
+    {
+        return 0;
+    }
+    if(file.size == 0){
+        if(!FAT_Preallocate(&file, bytes)){
+            FAT_Close(&file);
+            return 0;
+        }
+        file.size = bytes;
+        fresh = 1;
+    }
+    else{
+        if(file.size != bytes){
+            return 0;
+        }
+        clusters = (bytes + vol->sectorsPerCluster * 512UL - 1) /
+                   (vol->sectorsPerCluster * 512UL);
+        for(unsigned long i = 0; i + 1 < clusters; i++){
+            if(!FAT_GetEntry(vol, file.firstCluster + i, &next) ||
+               (next != file.firstCluster + i + 1)){
+                return 0;
+            }
+        }
+    }
+    if(!FAT_Close(&file)){
+        return 0;
+    }
+    if(fresh){
+        // Keep the index out of the way on a PC
+        if(!FAT_WindowLoad(vol, file.dirSector)){
+            return 0;
+        }
+        p = &window.data[file.dirOffset];
+        p[11] |= FAT_ATTR_HIDDEN | FAT_ATTR_SYSTEM;
+        window.dirty = 1;
+    }
+
+    vol->idxDir = dir.cluster;
+    vol->idxBase = FAT_ClusterToSector(vol, file.firstCluster);
+    if(fresh || !FAT_IndexCheck(vol)){
+        return FAT_IndexRebuild(vol);
+    }
+
+    return 1;
+}
+
+unsigned char FAT_IndexRebuild(FAT_Volume_t* vol){
+    FAT_Dir_t dir;
+    SD_FillGen_t zeros;
+    char name[11];
+    unsigned char* p;
+
+    if(vol->idxBase == 0){
+        return 0;
+    }
+
+    // Empty every bucket
+    WINDOW_Drop(vol, vol->idxBase + 1, FAT_INDEX_SECTORS);
+    zeros.type = SD_FILL_CONSTANT;
+    zeros.value = 0x00;
+    if(!SD_FillBlocks(vol->card, vol->idxBase + 1, FAT_INDEX_SECTORS, &zeros)){
+        FAT_IndexDetach(vol);
+        return 0;
+    }
+
+    // Add every name up to the end marker. A directory with no end marker
+    // is extended, so that new entries always have somewhere to go
+    FAT_DirStart(vol, &dir, vol->idxDir);
+    vol->idxFingerprint = 0xFFFF;
+    while(1){
+        p = FAT_DirEntry(&dir);
+        if(p == NULL){
+            FAT_IndexDetach(vol);
+            return 0;
+        }
+        if(p[0] == 0x00){
+            break;
+        }
+        vol->idxFingerprint = FAT_IndexMix(vol->idxFingerprint, &dir, p);
+        if(fat_entry_live(p)){
+            memcpy(name, p, 11);
+            if(!FAT_IndexInsert(vol, name, dir.sector, dir.entry)){
+                FAT_IndexDetach(vol);
+                return 0;
+            }
+        }
+        if(!FAT_DirNext(&dir, 1)){
+            FAT_IndexDetach(vol);
+            return 0;
+        }
+    }
+
+    vol->idxEndCluster = dir.cluster;
+    vol->idxEndSector = dir.sector;
+    vol->idxEndSectorIdx = dir.sectorIdx;
+    vol->idxEndSlot = dir.entry;
+    if(!FAT_IndexSave(vol)){
+        FAT_IndexDetach(vol);
+        return 0;
+    }
+
+    return 1;
+}
+
+void FAT_IndexDetach(FAT_Volume_t* vol){
+    vol->idxBase = 0;
+}
+#endif
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Loads a sector into the shared window. Sectors of the first FAT are
+ *        written back to the other FAT copies as well
+ * @param vol Pointer to the volume
+ * @param sector Sector to load
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_WindowLoad(FAT_Volume_t* vol, unsigned long sector){
+    if(!WINDOW_Load(vol, vol->card, sector)){
+        return 0;
+    }
+    if((sector >= vol->fatStart) && (sector < vol->fatStart + vol->fatSize)){
+        window.numCopies = vol->numFats;
+        window.stride = vol->fatSize;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Checks whether the window holds a FAT boot sector with 512 byte
+ *        sectors
+ * @return 1 if so, 0 otherwise
+ */
+static unsigned char FAT_IsBootSector(void){
+    return ((window.data[0] == 0xEB) || (window.data[0] == 0xE9)) &&
+           (SD_Load16(&window.data[11]) == 512) &&
+           (window.data[13] != 0) &&
+           ((window.data[16] == 1) || (window.data[16] == 2));
+}
+
+/**
+ * @brief Reads a volume's boot sector and works out its layout
+ * @param vol Pointer to the volume, whose card has been set
+ * @param partStart First sector of the volume
+ * @return 1 if successful, 0 if the volume isn't FAT16 or FAT32
+ */
+static unsigned char FAT_MountAt(FAT_Volume_t* vol, unsigned long partStart){
+    unsigned short reserved;
+    unsigned short rootEntries;
+    unsigned long totalSectors;
+    unsigned long metaSectors;
+
+    if(!FAT_WindowLoad(vol, partStart)){
+        return 0;
+    }
+    if((SD_Load16(&window.data[510]) != 0xAA55) || !FAT_IsBootSector()){
+        return 0;
+    }
+
+    vol->sectorsPerCluster = window.data[13];
+    reserved = SD_Load16(&window.data[14]);
+    vol->numFats = window.data[16];
+    rootEntries = SD_Load16(&window.data[17]);
+    totalSectors = SD_Load16(&window.data[19]);
+    if(totalSectors == 0){
+        totalSectors = SD_Load32(&window.data[32]);
+    }
+    vol->fatSize = SD_Load16(&window.data[22]);
+    if(vol->fatSize == 0){
+        vol->fatSize = SD_Load32(&window.data[36]);
+    }
+
+    vol->rootSectors = (unsigned short)((rootEntries * 32UL + 511) / 512);
+    vol->fatStart = partStart + reserved;
+    vol->rootStart = vol->fatStart + vol->numFats * vol->fatSize;
+    vol->dataStart = vol->rootStart + vol->rootSectors;
+    metaSectors = vol->dataStart - partStart;
+    if(totalSectors <= metaSectors){
+        return 0;
+    }
+    vol->numClusters = (totalSectors - metaSectors) / vol->sectorsPerCluster;
+
+    // The cluster count alone decides the FAT type
+    if(vol->numClusters < 4085){
+        return 0; // FAT12 is not supported
+    }
+    else if(vol->numClusters < 65525){
+        vol->type = FAT_TYPE_FAT16;
+        vol->rootCluster = 0;
+        vol->fsInfoSector = 0;
+    }
+    else{
+        vol->type = FAT_TYPE_FAT32;
+        vol->rootCluster = SD_Load32(&window.data[44]);
+        vol->fsInfoSector = SD_Load16(&window.data[48]);
+        if((vol->fsInfoSector == 0) || (vol->fsInfoSector == 0xFFFF)){
+            vol->fsInfoSector = 0;
+        }
+        else{
+            vol->fsInfoSector += partStart;
+        }
+    }
+    FAT_InitFreeMap(vol, partStart);
+#ifdef FAT_USE_INDEX
+    vol->idxBase = 0;
+#endif
+
+    return 1;
+}
+
+/**
+ * @brief Gets the first sector of a cluster
+ * @param vol Pointer to the volume
+ * @param cluster Cluster number (2 or greater)
+ * @return The sector number
+ */
+static unsigned long FAT_ClusterToSector(
+    const FAT_Volume_t* vol,
+    unsigned long cluster
+)
+{
+    return vol->dataStart + (cluster - 2) * vol->sectorsPerCluster;
+}
+
+/**
+ * @brief Checks whether a FAT entry marks the end of a cluster chain
+ * @param vol Pointer to the volume
+ * @param value Value of the FAT entry
+ * @return 1 if so, 0 otherwise
+ */
+static unsigned char FAT_IsEOC(const FAT_Volume_t* vol, unsigned long value){
+    if(vol->type == FAT_TYPE_FAT32){
+        return (value >= 0x0FFFFFF8UL) ? 1 : 0;
+    }
+
+    return (value >= 0xFFF8UL) ? 1 : 0;
+}
+
+/**
+ * @brief Reads the FAT entry of a cluster
+ * @param vol Pointer to the volume
+ * @param cluster Cluster number
+ * @param value Set to the entry's value
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_GetEntry(
+    FAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long* value
+)
+{
+    unsigned long offset = (vol->type == FAT_TYPE_FAT32) ?
+                           cluster * 4 : cluster * 2;
+
+    if(!FAT_WindowLoad(vol, vol->fatStart + offset / 512)){
+        return 0;
+    }
+    offset %= 512;
+    if(vol->type == FAT_TYPE_FAT32){
+        *value = SD_Load32(&window.data[offset]) & 0x0FFFFFFFUL;
+    }
+    else{
+        *value = SD_Load16(&window.data[offset]);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Sets the FAT entry of a cluster. The upper 4 bits of FAT32 entries
+ *        are reserved and left as they are
+ * @param vol Pointer to the volume
+ * @param cluster Cluster number
+ * @param value New value of the entry
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_SetEntry(
+    FAT_Volume_t* vol,
+    unsigned long cluster,
+    unsigned long value
+)
+{
+    unsigned long offset = (vol->type == FAT_TYPE_FAT32) ?
+                           cluster * 4 : cluster * 2;
+
+    if(!FAT_WindowLoad(vol, vol->fatStart + offset / 512)){
+        return 0;
+    }
+    offset %= 512;
+    if(vol->type == FAT_TYPE_FAT32){
+        value = (value & 0x0FFFFFFFUL) |
+                (SD_Load32(&window.data[offset]) & 0xF0000000UL);
+        SD_Store32(&window.data[offset], value);
+    }
+    else{
+        SD_Store16(&window.data[offset], (unsigned short)value);
+    }
+    window.dirty = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Checks whether the window holds a valid FSInfo sector
+ * @return 1 if so, 0 otherwise
+ */
+static unsigned char FAT_IsFSInfo(void){
+    return (SD_Load32(&window.data[0]) == FAT_FSI_LEAD) &&
+           (SD_Load32(&window.data[484]) == FAT_FSI_STRUC);
+}
+
+/**
+ * @brief Sets up the free-space summary of a newly mounted volume. The
+ *        coarse map in RAM has one bit per group of FAT sectors. On FAT32,
+ *        a fine map with one bit per FAT sector is kept in the last sectors
+ *        of the reserved area, if they are free. If FSInfo shows that the
+ *        fine map was sealed and nothing has changed since, the coarse map
+ *        is rebuilt from it. Otherwise, every group is assumed to have free
+ *        clusters until a scan finds otherwise
+ * @param vol Pointer to the volume
+ * @param partStart First sector of the volume
+ */
+static void FAT_InitFreeMap(FAT_Volume_t* vol, unsigned long partStart){
+    unsigned short numGroups;
+    unsigned short groupBytes;
+    unsigned long mapSectors;
+    unsigned long bit;
+    unsigned long hint;
+    unsigned char any;
+
+    // Smallest power of two (so that groups never straddle map sectors)
+    // that lets the coarse map cover the whole FAT
+    vol->groupSectors = 8;
+    while(vol->fatSize >
+          (unsigned long)vol->groupSectors * (FAT_FREEMAP_BYTES * 8)){
+        vol->groupSectors <<= 1;
+    }
+    memset(vol->freeMap, 0xFF, FAT_FREEMAP_BYTES);
+    vol->freeHint = 2;
+    vol->unsealed = 0;
+    vol->mapSector = 0;
+    vol->mapValid = 0;
+
+    if((vol->fsInfoSector == 0) || !FAT_WindowLoad(vol, vol->fsInfoSector) ||
+       !FAT_IsFSInfo()){
+        vol->fsInfoSector = 0;
+        return;
+    }
+
+    hint = SD_Load32(&window.data[492]);
+    if((hint >= 2) && (hint < vol->numClusters + 2)){
+        vol->freeHint = hint;
+    }
+
+    // Stay clear of the boot sectors, their backups and FSInfo
+    mapSectors = (vol->fatSize + 4095) / 4096;
+    if((vol->groupSectors > FAT_MAX_GROUP) ||
+       (vol->fatStart - partStart < 16 + mapSectors)){
+        return;
+    }
+    vol->mapSector = vol->fatStart - mapSectors;
+
+    if((SD_Load32(&window.data[496]) != FAT_MAP_MAGIC) ||
+       (SD_Load32(&window.data[500]) != SD_Load32(&window.data[488])) ||
+       (SD_Load32(&window.data[504]) != SD_Load32(&window.data[492]))){
+        return;
+    }
+
+    numGroups = (unsigned short)((vol->fatSize + vol->groupSectors - 1) /
+                                 vol->groupSectors);
+    groupBytes = vol->groupSectors / 8;
+    for(unsigned short g = 0; g < numGroups; g++){
+        bit = (unsigned long)g * vol->groupSectors;
+        if(!FAT_WindowLoad(vol, vol->mapSector + bit / 4096)){
+            memset(vol->freeMap, 0xFF, FAT_FREEMAP_BYTES);
+            return;
+        }
+        any = 0;
+        for(unsigned short i = 0; i < groupBytes; i++){
+            any |= window.data[(unsigned short)(bit % 4096) / 8 + i];
+        }
+        if(!any){
+            vol->freeMap[g >> 3] &= (unsigned char)~(1U << (g & 7));
+        }
+    }
+    vol->mapValid = 1;
+}
+
+/**
+ * @brief Breaks the seal on the free-space map the first time allocation
+ *        changes after mounting, and marks FSInfo's free cluster count as
+ *        unknown rather than maintaining it. FSInfo is written before any FAT
+ *        sector is, so a power failure can't leave a stale map sealed. A fine
+ *        map that couldn't be trusted is reset to "every sector may have free
+ *        clusters"
+ * @param vol Pointer to the volume
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_Unseal(FAT_Volume_t* vol){
+    SD_FillGen_t ones;
+    unsigned long mapSectors;
+
+    if(vol->unsealed || (vol->fsInfoSector == 0)){
+        return 1;
+    }
+    vol->unsealed = 1;
+
+    if((vol->mapSector != 0) && !vol->mapValid){
+        mapSectors = vol->fatStart - vol->mapSector;
+        WINDOW_Drop(vol, vol->mapSector, mapSectors);
+        ones.type = SD_FILL_CONSTANT;
+        ones.value = 0xFF;
+        if(SD_FillBlocks(vol->card, vol->mapSector, mapSectors, &ones)){
+            vol->mapValid = 1;
+        }
+        else{
+            vol->mapSector = 0;
+        }
+    }
+
+    if(!FAT_WindowLoad(vol, vol->fsInfoSector)){
+        return 0;
+    }
+    if(FAT_IsFSInfo()){
+        SD_Store32(&window.data[488], 0xFFFFFFFFUL);
+        SD_Store32(&window.data[496], 0);
+        window.dirty = 1;
+    }
+
+    return WINDOW_Flush();
+}
+
+/**
+ * @brief Scans a group of FAT sectors for a free cluster. Sectors that the
+ *        fine map shows to be full are skipped without being read, and
+ *        sectors found to be full are marked as such
+ * @param vol Pointer to the volume
+ * @param group Index of the group
+ * @param from Index of the FAT sector within the FAT to start at
+ * @param cluster Set to the free cluster found, or 0 if there is none
+ * @return 1 if successful, 0 if an error occurred
+ */
+static unsigned char FAT_ScanGroup(
+    FAT_Volume_t* vol,
+    unsigned short group,
+    unsigned long from,
+    unsigned long* cluster
+)
+{
+    unsigned long first = (unsigned long)group * vol->groupSectors;
+    unsigned long end = first + vol->groupSectors;
+    unsigned short perSector = (vol->type == FAT_TYPE_FAT32) ? 128 : 256;
+    unsigned short groupBytes = vol->groupSectors / 8;
+    unsigned short mapOffset = (unsigned short)(first % 4096) / 8;
+    unsigned char changed = 0;
+    unsigned short idx;
+    unsigned long c;
+    unsigned long value;
+
+    *cluster = 0;
+    if(end > vol->fatSize){
+        end = vol->fatSize;
+    }
+
+    if(vol->mapSector != 0){
+        if(!FAT_WindowLoad(vol, vol->mapSector + first / 4096)){
+            return 0;
+        }
+        memcpy(groupMap, &window.data[mapOffset], groupBytes);
+    }
+
+    for(unsigned long s = from; (s < end) && (*cluster == 0); s++){
+        idx = (unsigned short)(s - first);
+        if((vol->mapSector != 0) && !(groupMap[idx >> 3] & (1U << (idx & 7)))){
+            continue;
+        }
+
+        if(!FAT_WindowLoad(vol, vol->fatStart + s)){
+            return 0;
+        }
+        for(unsigned short i = 0; i < perSector; i++){
+            c = s * perSector + i;
+            if(c < 2){
+                continue;
+            }
+            if(c >= vol->numClusters + 2){
+                break;
+            }
+            if(vol->type == FAT_TYPE_FAT32){
+                value = SD_Load32(&window.data[i * 4]) & 0x0FFFFFFFUL;
+            }
+            else{
+                value = SD_Load16(&window.data[i * 2]);
+            }
+            if(value == 0){
+                *cluster = c;
+                break;
+            }
+        }
+
+        if((*cluster == 0) && (vol->mapSector != 0)){
+            groupMap[idx >> 3] &= (unsigned char)~(1U << (idx & 7));
+            changed = 1;
+        }
+    }
+
+    if(changed){
+        if(!FAT_WindowLoad(vol, vol->mapSector + first / 4096)){
+            return 0;
+        }
+        memcpy(&window.data[mapOffset], groupMap, groupBytes);
+        window.dirty = 1;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Records in the free-space maps that a FAT sector has free clusters
+ * @param vol Pointer to the volume
+ * @param fatSector Index of the sector within the FAT
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_MarkFree(FAT_Volume_t* vol, unsigned long fatSector){
+    unsigned short g = (unsigned short)(fatSector / vol->groupSectors);
+
+    vol->freeMap[g >> 3] |= (unsigned char)(1U << (g & 7));
+    if(vol->mapSector == 0){
+        return 1;
+    }
+
+    if(!FAT_WindowLoad(vol, vol->mapSector + fatSector / 4096)){
+        return 0;
+    }
+    window.data[(unsigned short)(fatSector % 4096) / 8] |=
+        (unsigned char)(1U << (fatSector & 7));
+    window.dirty = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Allocates a free cluster, marks it as the end of its chain and links
+ *        it after prev. The search starts at the hint's FAT sector and then
+ *        visits the groups in turn, skipping those the coarse map shows to be
+ *        full, and coming back round to the start of the hint's group last
+ * @param vol Pointer to the volume
+ * @param prev Last cluster of the chain to extend, or 0 to start a new chain
+ * @return The cluster number, or 0 if the volume is full or an error occurred
+ */
+static unsigned long FAT_AllocCluster(FAT_Volume_t* vol, unsigned long prev){
+    unsigned short perSector = (vol->type == FAT_TYPE_FAT32) ? 128 : 256;
+    unsigned short numGroups = (unsigned short)(
+        (vol->fatSize + vol->groupSectors - 1) / vol->groupSectors
+    );
+    unsigned long eoc = (vol->type == FAT_TYPE_FAT32) ?
+                        0x0FFFFFFFUL : 0xFFFFUL;
+    unsigned long hintSector;
+    unsigned long from;
+    unsigned long cluster;
+    unsigned short g0;
+    unsigned short g;
+
+    if(!FAT_Unseal(vol)){
+        return 0;
+    }
+
+    if((vol->freeHint < 2) || (vol->freeHint >= vol->numClusters + 2)){
+        vol->freeHint = 2;
+    }
+    hintSector = vol->freeHint / perSector;
+    g0 = (unsigned short)(hintSector / vol->groupSectors);
+
+    for(unsigned short n = 0; n <= numGroups; n++){
+        g = (unsigned short)((g0 + n) % numGroups);
+        if(!fat_group_free(vol, g)){
+            continue;
+        }
+
+        from = (n == 0) ? hintSector : (unsigned long)g * vol->groupSectors;
+        if(!FAT_ScanGroup(vol, g, from, &cluster)){
+            return 0;
+        }
+        if(cluster != 0){
+            if(!FAT_SetEntry(vol, cluster, eoc)){
+                return 0;
+            }
+            if((prev != 0) && !FAT_SetEntry(vol, prev, cluster)){
+                return 0;
+            }
+            vol->freeHint = cluster + 1;
+            return cluster;
+        }
+
+        // Only a scan of the whole group proves it full
+        if(from == (unsigned long)g * vol->groupSectors){
+            vol->freeMap[g >> 3] &= (unsigned char)~(1U << (g & 7));
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Finds the first run of consecutive free clusters that is long enough
+ * @param vol Pointer to the volume
+ * @param numClusters Number of clusters needed
+ * @return The first cluster of the run, or 0 if there is none or an error
+ *         occurred
+ */
+static unsigned long FAT_FindRun(FAT_Volume_t* vol, unsigned long numClusters){
+    unsigned short perSector = (vol->type == FAT_TYPE_FAT32) ? 128 : 256;
+    unsigned long groupClusters = (unsigned long)vol->groupSectors * perSector;
+    unsigned long start = 2;
+    unsigned long len = 0;
+    unsigned long value;
+    unsigned short g;
+
+    for(unsigned long c = 2; c < vol->numClusters + 2; c++){
+        // A run can't span a group that has no free clusters
+        if((c == 2) || (c % groupClusters == 0)){
+            g = (unsigned short)(c / groupClusters);
+            if(!fat_group_free(vol, g)){
+                len = 0;
+                start = (g + 1) * groupClusters;
+                c = start - 1;
+                continue;
+            }
+        }
+
+        if(!FAT_GetEntry(vol, c, &value)){
+            return 0;
+        }
+        if(value != 0){
+            len = 0;
+            start = c + 1;
+            continue;
+        }
+        len++;
+        if(len == numClusters){
+            return start;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Frees every cluster of a chain
+ * @param vol Pointer to the volume
+ * @param cluster First cluster of the chain
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_FreeChain(FAT_Volume_t* vol, unsigned long cluster){
+    unsigned short perSector = (vol->type == FAT_TYPE_FAT32) ? 128 : 256;
+    unsigned long fatSector = FAT_NO_SECTOR;
+    unsigned long next;
+
+    if(!FAT_Unseal(vol)){
+        return 0;
+    }
+    while((cluster >= 2) && (cluster < vol->numClusters + 2)){
+        if(!FAT_GetEntry(vol, cluster, &next)){
+            return 0;
+        }
+        if(!FAT_SetEntry(vol, cluster, 0)){
+            return 0;
+        }
+
+        // Updating the maps once per FAT sector keeps the window from
+        // swapping back and forth on every cluster
+        if(cluster / perSector != fatSector){
+            fatSector = cluster / perSector;
+            if(!FAT_MarkFree(vol, fatSector)){
+                return 0;
+            }
+        }
+        if(cluster < vol->freeHint){
+            vol->freeHint = cluster;
+        }
+        if(FAT_IsEOC(vol, next)){
+            break;
+        }
+        cluster = next;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Reads consecutive sectors of file data directly into a buffer. More
+ *        than one sector is read with a multiple block read
+ * @param vol Pointer to the volume
+ * @param sector First sector to read
+ * @param numSectors Number of sectors to read
+ * @param buf Pointer to where the data is to be stored
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_DataRead(
+    FAT_Volume_t* vol,
+    unsigned long sector,
+    unsigned long numSectors,
+    unsigned char* buf
+)
+{
+    // A modified copy of one of the sectors in the window is newer than the
+    // one on the card
+    if(window.dirty && WINDOW_Holds(vol, sector, numSectors)){
+        if(!WINDOW_Flush()){
+            return 0;
+        }
+    }
+
+    if(numSectors == 1){
+        return SD_SingleBlockRead(vol->card, sector, buf);
+    }
+
+    if(!SD_MBR_Start(vol->card, sector)){
+        return 0;
+    }
+    while(numSectors > 0){
+        SD_MBR_Receive(vol->card, buf);
+        buf += 512;
+        numSectors--;
+    }
+    SD_MBR_Stop(vol->card);
+
+    return 1;
+}
+
+/**
+ * @brief Writes consecutive sectors of file data directly from a buffer.
+ *        More than one sector is written with a multiple block write, which
+ *        pre-erases the range
+ * @param vol Pointer to the volume
+ * @param sector First sector to write
+ * @param numSectors Number of sectors to write
+ * @param buf Pointer to the data to be written
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_DataWrite(
+    FAT_Volume_t* vol,
+    unsigned long sector,
+    unsigned long numSectors,
+    unsigned char* buf
+)
+{
+    unsigned char success = 1;
+
+    WINDOW_Drop(vol, sector, numSectors);
+
+    if(numSectors == 1){
+        return SD_SingleBlockWrite(vol->card, sector, buf);
+    }
+
+    SD_MBW_Start(vol->card, sector, numSectors);
+    while(numSectors > 0){
+        if(!SD_MBW_Send(vol->card, buf)){
+            success = 0;
+            break;
+        }
+        buf += 512;
+        numSectors--;
+    }
+    if(!SD_MBW_Stop(vol->card)){
+        success = 0;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Finds the cluster holding a file's current position, walking the
+ *        chain forward from the last cluster located (or from the start when
+ *        seeking backwards)
+ * @param file Pointer to the file
+ * @param allocate 1 to allocate clusters past the end of the chain, 0 to fail
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_Locate(FAT_File_t* file, unsigned char allocate){
+    FAT_Volume_t* vol = file->vol;
+    unsigned long target = file->pos / (vol->sectorsPerCluster * 512UL);
+    unsigned long next;
+    FAT_Extent_t* ext;
+
+    if(file->firstCluster == 0){
+        if(!allocate){
+            return 0;
+        }
+        next = FAT_AllocCluster(vol, 0);
+        if(next == 0){
+            return 0;
+        }
+        file->firstCluster = next;
+        file->cluster = next;
+        file->clusterIdx = 0;
+        file->dirty = 1;
+    }
+
+    // Preallocated clusters are consecutive, so there is no chain to walk
+    if(target < file->contigClusters){
+        file->cluster = file->firstCluster + target;
+        file->clusterIdx = target;
+        return 1;
+    }
+
+    // So are the clusters of each cached run
+    ext = FAT_FindExtent(file, target);
+    if(ext != NULL){
+        file->cluster = ext->cluster + (target - ext->fileIdx);
+        file->clusterIdx = target;
+        return 1;
+    }
+
+    if((file->cluster == 0) || (target < file->clusterIdx)){
+        file->cluster = file->firstCluster;
+        file->clusterIdx = 0;
+    }
+
+    while(file->clusterIdx < target){
+        if(!FAT_GetEntry(vol, file->cluster, &next)){
+            return 0;
+        }
+        if(FAT_IsEOC(vol, next)){
+            if(!allocate){
+                return 0;
+            }
+            next = FAT_AllocCluster(vol, file->cluster);
+            if(next == 0){
+                return 0;
+            }
+        }
+        else if((next < 2) || (next >= vol->numClusters + 2)){
+            return 0; // Broken chain
+        }
+        file->cluster = next;
+        file->clusterIdx++;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Writes a file's size and first cluster to its directory entry if they
+ *        changed, then flushes the window
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_SyncEntry(FAT_File_t* file){
+    unsigned char* p;
+
+    if(file->dirty){
+        if(!FAT_WindowLoad(file->vol, file->dirSector)){
+            return 0;
+        }
+        p = &window.data[file->dirOffset];
+        SD_Store16(&p[20], (unsigned short)(file->firstCluster >> 16));
+        SD_Store16(&p[26], (unsigned short)file->firstCluster);
+        SD_Store32(&p[28], file->size);
+        SD_Store16(&p[18], FAT_TIMESTAMP_DATE);
+        SD_Store16(&p[22], FAT_TIMESTAMP_TIME);
+        SD_Store16(&p[24], FAT_TIMESTAMP_DATE);
+        p[11] |= FAT_ATTR_ARCHIVE;
+        window.dirty = 1;
+        file->dirty = 0;
+    }
+
+    return WINDOW_Flush();
+}
+
+/**
+ * @brief Finds the cached run holding a cluster of a file
+ * @param file Pointer to the file
+ * @param idx Index of the cluster within the file
+ * @return Pointer to the run, or NULL if it isn't cached
+ */
+static FAT_Extent_t* FAT_FindExtent(FAT_File_t* file, unsigned long idx){
+    FAT_Extent_t* ext;
+
+    for(unsigned char i = 0; i < file->numExtents; i++){
+        ext = &file->extents[i];
+        if((idx >= ext->fileIdx) && (idx - ext->fileIdx < ext->length)){
+            return ext;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Walks a file's cluster chain ahead of its located cluster, replacing
+ *        the extent cache with the runs of consecutive clusters found. The
+ *        walk stops after FAT_MAX_EXTENTS runs, FAT_MAP_CLUSTERS entries, or
+ *        at the end of the file's data
+ * @pre The file's current cluster has been located
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_MapExtents(FAT_File_t* file){
+    FAT_Volume_t* vol = file->vol;
+    FAT_Extent_t* ext = &file->extents[0];
+    unsigned long clusterBytes = vol->sectorsPerCluster * 512UL;
+    unsigned long numClusters = (file->size + clusterBytes - 1) / clusterBytes;
+    unsigned long idx = file->clusterIdx;
+    unsigned long cluster = file->cluster;
+    unsigned long next;
+
+    ext->fileIdx = idx;
+    ext->cluster = cluster;
+    ext->length = 1;
+    file->numExtents = 1;
+
+    for(unsigned short n = 0; n < FAT_MAP_CLUSTERS; n++){
+        if(idx + 1 >= numClusters){
+            break;
+        }
+        if(!FAT_GetEntry(vol, cluster, &next)){
+            return 0;
+        }
+        if(FAT_IsEOC(vol, next) || (next < 2) ||
+           (next >= vol->numClusters + 2)){
+            break;
+        }
+        idx++;
+
+        if(next == cluster + 1){
+            ext->length++;
+        }
+        else{
+            if(file->numExtents == FAT_MAX_EXTENTS){
+                break;
+            }
+            ext = &file->extents[file->numExtents++];
+            ext->fileIdx = idx;
+            ext->cluster = next;
+            ext->length = 1;
+        }
+        cluster = next;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Gets the number of consecutive clusters starting at a file's
+ *        located cluster, mapping the chain ahead if it isn't cached
+ * @pre The file's current cluster has been located
+ * @param file Pointer to the file
+ * @return The number of clusters (at least 1)
+ */
+static unsigned long FAT_RunLength(FAT_File_t* file){
+    FAT_Extent_t* ext;
+
+    if(file->clusterIdx < file->contigClusters){
+        return file->contigClusters - file->clusterIdx;
+    }
+
+    ext = FAT_FindExtent(file, file->clusterIdx);
+    if(ext == NULL){
+        if(!FAT_MapExtents(file)){
+            return 1;
+        }
+        ext = &file->extents[0];
+    }
+
+    return ext->length - (file->clusterIdx - ext->fileIdx);
+}
+
+/**
+ * @brief Opens a file in a directory, creating it if needed
+ * @param vol Pointer to the volume
+ * @param file Pointer to the file
+ * @param dirCluster First cluster of the directory, or 0 for the root
+ * @param name Space-padded 8.3 name of the file
+ * @param mode How to open the file
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_OpenEntry(
+    FAT_Volume_t* vol,
+    FAT_File_t* file,
+    unsigned long dirCluster,
+    const char* name,
+    fat_mode_e mode
+)
+{
+    FAT_Dir_t dir;
+    unsigned char* p;
+    unsigned char found = FAT_Lookup(vol, &dir, dirCluster, name);
+
+    if(found){
+        p = FAT_DirEntry(&dir);
+        if((p == NULL) || (p[11] & (FAT_ATTR_DIRECTORY | FAT_ATTR_VOLUME_ID))){
+            return 0;
+        }
+        if((mode != FAT_MODE_READ) && (p[11] & FAT_ATTR_READ_ONLY)){
+            return 0;
+        }
+        file->firstCluster = FAT_EntryCluster(vol, p);
+        file->size = SD_Load32(&p[28]);
+    }
+    else{
+        if(mode == FAT_MODE_READ){
+            return 0;
+        }
+
+        // Create an empty file
+        if(!FAT_NewEntry(vol, &dir, dirCluster)){
+            return 0;
+        }
+        p = FAT_DirEntry(&dir);
+        if(p == NULL){
+            return 0;
+        }
+        memset(p, 0, FAT_ENTRY_SIZE);
+        memcpy(p, name, 11);
+        p[11] = FAT_ATTR_ARCHIVE;
+        SD_Store16(&p[14], FAT_TIMESTAMP_TIME);
+        SD_Store16(&p[16], FAT_TIMESTAMP_DATE);
+        SD_Store16(&p[18], FAT_TIMESTAMP_DATE);
+        SD_Store16(&p[22], FAT_TIMESTAMP_TIME);
+        SD_Store16(&p[24], FAT_TIMESTAMP_DATE);
+        window.dirty = 1;
+#ifdef FAT_USE_INDEX
+        FAT_IndexAdd(vol, &dir, name);
+#endif
+        file->firstCluster = 0;
+        file->size = 0;
+    }
+
+    file->vol = vol;
+    file->dirSector = dir.sector;
+    file->dirOffset = (unsigned short)dir.entry * FAT_ENTRY_SIZE;
+    file->mode = mode;
+    file->pos = 0;
+    file->cluster = file->firstCluster;
+    file->clusterIdx = 0;
+    file->contigClusters = 0;
+    file->dirty = 0;
+    file->streaming = 0;
+    file->reading = 0;
+    file->runLeft = 0;
+    file->numExtents = 0;
+
+    if((mode == FAT_MODE_WRITE) && (file->firstCluster != 0)){
+        // Truncate
+        if(!FAT_FreeChain(vol, file->firstCluster)){
+            return 0;
+        }
+        file->firstCluster = 0;
+        file->cluster = 0;
+        file->size = 0;
+        file->dirty = 1;
+    }
+    else if(mode == FAT_MODE_APPEND){
+        file->pos = file->size;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Converts the next component of a path into a space-padded 8.3 name
+ *        and advances the path past it
+ * @param path Pointer to the path
+ * @param name83 Array of 11 chars that the name is to be stored in
+ * @return 1 if successful, 0 if the component isn't a valid 8.3 name
+ */
+static unsigned char FAT_ParseName(const char** path, char* name83){
+    const char* s = *path;
+    unsigned char i = 0;
+    unsigned char end = 8;
+    char c;
+
+    memset(name83, ' ', 11);
+    while(*s == '/'){
+        s++;
+    }
+
+    if(*s == '.'){
+        // "." and ".." are stored as they are
+        name83[0] = '.';
+        s++;
+        if(*s == '.'){
+            name83[1] = '.';
+            s++;
+        }
+        if((*s != '/') && (*s != '\0')){
+            return 0;
+        }
+    }
+    else{
+        while((*s != '/') && (*s != '\0')){
+            c = *s++;
+            if(c == '.'){
+                if(end == 11){
+                    return 0;
+                }
+                i = 8;
+                end = 11;
+                continue;
+            }
+            if((c >= 'a') && (c <= 'z')){
+                c -= 'a' - 'A';
+            }
+            if((c <= ' ') || (strchr("\"*+,:;<=>?[\\]|", c) != NULL)){
+                return 0;
+            }
+            if(i >= end){
+                return 0;
+            }
+            name83[i++] = c;
+        }
+        if(name83[0] == ' '){
+            return 0;
+        }
+        if(name83[0] == (char)FAT_DELETED){
+            name83[0] = 0x05;
+        }
+    }
+
+    while(*s == '/'){
+        s++;
+    }
+    *path = s;
+
+    return 1;
+}
+
+/**
+ * @brief Gets the first cluster of a directory entry
+ * @param vol Pointer to the volume
+ * @param entry Pointer to the directory entry
+ * @return The cluster number
+ */
+static unsigned long FAT_EntryCluster(
+    const FAT_Volume_t* vol,
+    const unsigned char* entry
+)
+{
+    unsigned long cluster = SD_Load16(&entry[26]);
+
+    if(vol->type == FAT_TYPE_FAT32){
+        cluster |= (unsigned long)SD_Load16(&entry[20]) << 16;
+    }
+
+    return cluster;
+}
+
+/**
+ * @brief Positions a traversal at the first entry of a directory
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state
+ * @param cluster First cluster of the directory, or 0 for the root directory
+ */
+static void FAT_DirStart(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long cluster
+)
+{
+    // ".." entries of top-level directories point to cluster 0
+    if((cluster == 0) && (vol->type == FAT_TYPE_FAT32)){
+        cluster = vol->rootCluster;
+    }
+
+    dir->vol = vol;
+    dir->cluster = cluster;
+    dir->sector = (cluster == 0) ?
+                  vol->rootStart : FAT_ClusterToSector(vol, cluster);
+    dir->sectorIdx = 0;
+    dir->entry = 0;
+    dir->end = 0;
+}
+
+/**
+ * @brief Loads the sector holding a traversal's current entry into the window
+ * @param dir Pointer to the traversal state
+ * @return Pointer to the entry in the window, or NULL if an error occurred
+ */
+static unsigned char* FAT_DirEntry(FAT_Dir_t* dir){
+    if(!FAT_WindowLoad(dir->vol, dir->sector)){
+        return NULL;
+    }
+
+    return &window.data[(unsigned short)dir->entry * FAT_ENTRY_SIZE];
+}
+
+/**
+ * @brief Advances a traversal to the next entry, following the directory's
+ *        cluster chain
+ * @param dir Pointer to the traversal state
+ * @param extend 1 to add a zeroed cluster at the end of the directory (except
+ *        for the fixed FAT16 root directory), 0 to stop there
+ * @return 1 if successful, 0 at the end of the directory or on error
+ */
+static unsigned char FAT_DirNext(FAT_Dir_t* dir, unsigned char extend){
+    FAT_Volume_t* vol = dir->vol;
+    SD_FillGen_t zeros;
+    unsigned long next;
+    unsigned long sector;
+
+    dir->entry++;
+    if(dir->entry < FAT_ENTRIES_PER_SECTOR){
+        return 1;
+    }
+    dir->entry = 0;
+    dir->sectorIdx++;
+
+    if(dir->cluster == 0){
+        // Fixed FAT16 root directory
+        if(dir->sectorIdx >= vol->rootSectors){
+            return 0;
+        }
+        dir->sector++;
+        return 1;
+    }
+
+    if(dir->sectorIdx < vol->sectorsPerCluster){
+        dir->sector++;
+        return 1;
+    }
+
+    if(!FAT_GetEntry(vol, dir->cluster, &next)){
+        return 0;
+    }
+    if(FAT_IsEOC(vol, next)){
+        if(!extend){
+            return 0;
+        }
+        next = FAT_AllocCluster(vol, dir->cluster);
+        if(next == 0){
+            return 0;
+        }
+
+        // Zeroed entries mark the end of the directory
+        sector = FAT_ClusterToSector(vol, next);
+        WINDOW_Drop(vol, sector, vol->sectorsPerCluster);
+        zeros.type = SD_FILL_CONSTANT;
+        zeros.value = 0x00;
+        if(!SD_FillBlocks(vol->card, sector, vol->sectorsPerCluster, &zeros)){
+            return 0;
+        }
+    }
+    else if((next < 2) || (next >= vol->numClusters + 2)){
+        return 0; // Broken chain
+    }
+
+    dir->cluster = next;
+    dir->sectorIdx = 0;
+    dir->sector = FAT_ClusterToSector(vol, next);
+
+    return 1;
+}
+
+/**
+ * @brief Searches a directory for an entry
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state. Left on the entry if found
+ * @param dirCluster First cluster of the directory, or 0 for the root
+ * @param name83 Space-padded 8.3 name to look for
+ * @return 1 if found, 0 otherwise
+ */
+static unsigned char FAT_Search(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long dirCluster,
+    const char* name83
+)
+{
+    unsigned char* p;
+
+    FAT_DirStart(vol, dir, dirCluster);
+    do{
+        p = FAT_DirEntry(dir);
+        if((p == NULL) || (p[0] == 0x00)){
+            return 0;
+        }
+        if((p[0] != FAT_DELETED) && (p[11] != FAT_ATTR_LFN) &&
+           !(p[11] & FAT_ATTR_VOLUME_ID) && (memcmp(p, name83, 11) == 0)){
+            return 1;
+        }
+    }while(FAT_DirNext(dir, 0));
+
+    return 0;
+}
+
+/**
+ * @brief Finds an unused entry in a directory, growing the directory if it is
+ *        full
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state. Left on the entry if found
+ * @param dirCluster First cluster of the directory, or 0 for the root
+ * @return 1 if successful, 0 if the directory can't hold another entry
+ */
+static unsigned char FAT_FindFree(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long dirCluster
+)
+{
+    unsigned char* p;
+
+    FAT_DirStart(vol, dir, dirCluster);
+    do{
+        p = FAT_DirEntry(dir);
+        if(p == NULL){
+            return 0;
+        }
+        if((p[0] == 0x00) || (p[0] == FAT_DELETED)){
+            return 1;
+        }
+    }while(FAT_DirNext(dir, 1));
+
+    return 0;
+}
+
+/**
+ * @brief Looks up a name in a directory, through the directory index if the
+ *        directory has one and by scanning it otherwise
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state. Left on the entry if found
+ * @param dirCluster First cluster of the directory, or 0 for the root
+ * @param name83 Space-padded 8.3 name to look for
+ * @return 1 if found, 0 otherwise
+ */
+static unsigned char FAT_Lookup(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long dirCluster,
+    const char* name83
+)
+{
+#ifdef FAT_USE_INDEX
+    unsigned char result;
+
+    if(FAT_IndexCovers(vol, dirCluster)){
+        result = FAT_IndexLookup(vol, dir, name83);
+        if(result != FAT_INDEX_STALE){
+            return result;
+        }
+
+        // The directory changed behind the index's back
+        FAT_IndexDetach(vol);
+    }
+#endif
+
+    return FAT_Search(vol, dir, dirCluster, name83);
+}
+
+/**
+ * @brief Finds a slot for a new entry in a directory. With a directory
+ *        index, this is the end marker the index keeps track of. Otherwise,
+ *        the directory is scanned for an unused entry
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state. Left on the entry if found
+ * @param dirCluster First cluster of the directory, or 0 for the root
+ * @return 1 if successful, 0 if the directory can't hold another entry
+ */
+static unsigned char FAT_NewEntry(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    unsigned long dirCluster
+)
+{
+#ifdef FAT_USE_INDEX
+    if(FAT_IndexCovers(vol, dirCluster)){
+        dir->vol = vol;
+        dir->cluster = vol->idxEndCluster;
+        dir->sector = vol->idxEndSector;
+        dir->sectorIdx = vol->idxEndSectorIdx;
+        dir->entry = vol->idxEndSlot;
+        dir->end = 0;
+        return 1;
+    }
+#endif
+
+    return FAT_FindFree(vol, dir, dirCluster);
+}
+
+#ifdef FAT_USE_INDEX
+/**
+ * @brief Checks whether a directory has the attached index
+ * @param vol Pointer to the volume
+ * @param dirCluster First cluster of the directory, or 0 for the root
+ * @return 1 if so, 0 otherwise
+ */
+static unsigned char FAT_IndexCovers(
+    const FAT_Volume_t* vol,
+    unsigned long dirCluster
+)
+{
+    // The FAT32 root directory is referred to as cluster 0 in paths
+    if((dirCluster == 0) && (vol->type == FAT_TYPE_FAT32)){
+        dirCluster = vol->rootCluster;
+    }
+
+    return (vol->idxBase != 0) && (dirCluster == vol->idxDir);
+}
+
+/**
+ * @brief Hashes an 8.3 name
+ * @param name83 Space-padded 8.3 name
+ * @return The hash. Never 0, which marks empty buckets
+ */
+static unsigned short FAT_IndexHash(const char* name83){
+    unsigned short hash = 0xFFFF;
+
+    for(unsigned char i = 0; i < 11; i++){
+        hash = SD_CRC16(hash, (unsigned char)name83[i]);
+    }
+
+    return (hash == 0) ? 1 : hash;
+}
+
+/**
+ * @brief Looks up a name in the directory index. Buckets are probed linearly
+ *        from the one the name hashes to, and every hash match is checked
+ *        against the directory entry it points to
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state. Left on the entry if found
+ * @param name83 Space-padded 8.3 name to look for
+ * @return FAT_INDEX_HIT, FAT_INDEX_MISS, or FAT_INDEX_STALE if an entry the
+ *         index points to doesn't match or an error occurred
+ */
+static unsigned char FAT_IndexLookup(
+    FAT_Volume_t* vol,
+    FAT_Dir_t* dir,
+    const char* name83
+)
+{
+    unsigned short hash = FAT_IndexHash(name83);
+    unsigned short bucket = hash % FAT_INDEX_BUCKETS;
+    unsigned long sector;
+    unsigned char slot;
+    unsigned char* e;
+    unsigned char* p;
+
+    for(unsigned short n = 0; n < FAT_INDEX_BUCKETS; n++){
+        if(!FAT_WindowLoad(
+                vol,
+                vol->idxBase + 1 + bucket / FAT_INDEX_PER_SECTOR
+            )
+        )
+        {
+            return FAT_INDEX_STALE;
+        }
+        e = &window.data[(bucket % FAT_INDEX_PER_SECTOR) * 8];
+        if(SD_Load16(&e[0]) == 0){
+            return FAT_INDEX_MISS;
+        }
+
+        if(SD_Load16(&e[0]) == hash){
+            sector = SD_Load32(&e[4]);
+            slot = e[2];
+            if(!FAT_WindowLoad(vol, sector)){
+                return FAT_INDEX_STALE;
+            }
+            p = &window.data[(unsigned short)slot * FAT_ENTRY_SIZE];
+            if((p[0] == 0x00) || !fat_entry_live(p)){
+                return FAT_INDEX_STALE;
+            }
+            if(memcmp(p, name83, 11) == 0){
+                // Only the sector and entry are needed to use the entry. The
+                // directory can't be traversed from here
+                dir->vol = vol;
+                dir->cluster = 0;
+                dir->sector = sector;
+                dir->sectorIdx = 0;
+                dir->entry = slot;
+                dir->end = 0;
+                return FAT_INDEX_HIT;
+            }
+        }
+
+        bucket = (bucket + 1) % FAT_INDEX_BUCKETS;
+    }
+
+    return FAT_INDEX_MISS;
+}
+
+/**
+ * @brief Adds a name to the directory index
+ * @param vol Pointer to the volume
+ * @param name83 Space-padded 8.3 name
+ * @param sector Sector holding the name's directory entry
+ * @param slot Entry within the sector
+ * @return 1 if successful, 0 if the index is full or an error occurred
+ */
+static unsigned char FAT_IndexInsert(
+    FAT_Volume_t* vol,
+    const char* name83,
+    unsigned long sector,
+    unsigned char slot
+)
+{
+    unsigned short hash = FAT_IndexHash(name83);
+    unsigned short bucket = hash % FAT_INDEX_BUCKETS;
+    unsigned char* e;
+
+    for(unsigned short n = 0; n < FAT_INDEX_BUCKETS; n++){
+        if(!FAT_WindowLoad(
+                vol,
+                vol->idxBase + 1 + bucket / FAT_INDEX_PER_SECTOR
+            )
+        )
+        {
+            return 0;
+        }
+        e = &window.data[(bucket % FAT_INDEX_PER_SECTOR) * 8];
+        if(SD_Load16(&e[0]) == 0){
+            SD_Store16(&e[0], hash);
+            e[2] = slot;
+            e[3] = 0;
+            SD_Store32(&e[4], sector);
+            window.dirty = 1;
+            return 1;
+        }
+        bucket = (bucket + 1) % FAT_INDEX_BUCKETS;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Records a name that was just created at the directory's end marker,
+ *        then moves the end marker on by one entry (extending the directory
+ *        if needed). The index is detached if anything fails
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state, on the new entry
+ * @param name83 Space-padded 8.3 name of the new entry
+ */
+static void FAT_IndexAdd(
+    FAT_Volume_t* vol,
+    const FAT_Dir_t* dir,
+    const char* name83
+)
+{
+    FAT_Dir_t end = *dir;
+
+    if((vol->idxBase == 0) || (end.sector != vol->idxEndSector) ||
+       (end.entry != vol->idxEndSlot)){
+        return;
+    }
+
+    if(!FAT_IndexInsert(vol, name83, end.sector, end.entry)){
+        FAT_IndexDetach(vol);
+        return;
+    }
+    vol->idxFingerprint = FAT_IndexMix(
+        vol->idxFingerprint,
+        &end,
+        (const unsigned char*)name83
+    );
+    if(!FAT_DirNext(&end, 1)){
+        FAT_IndexDetach(vol);
+        return;
+    }
+
+    vol->idxEndCluster = end.cluster;
+    vol->idxEndSector = end.sector;
+    vol->idxEndSectorIdx = end.sectorIdx;
+    vol->idxEndSlot = end.entry;
+    if(!FAT_IndexSave(vol)){
+        FAT_IndexDetach(vol);
+    }
+}
+
+/**
+ * @brief Adds a directory entry to the directory's fingerprint. The
+ *        fingerprint covers the name of every entry before the end marker,
+ *        including deleted ones, and the cluster of each entry that starts
+ *        a cluster. Attributes, sizes and first clusters are left out, since
+ *        they change every time a file is synced
+ * @param crc Fingerprint of the entries before this one
+ * @param dir Pointer to the traversal state, on the entry
+ * @param entry Pointer to the entry, of which only the name is used
+ * @return The fingerprint including the entry
+ */
+static unsigned short FAT_IndexMix(
+    unsigned short crc,
+    const FAT_Dir_t* dir,
+    const unsigned char* entry
+)
+{
+    if((dir->cluster != 0) && (dir->sectorIdx == 0) && (dir->entry == 0)){
+        for(unsigned char i = 0; i < 32; i += 8){
+            crc = SD_CRC16(crc, (unsigned char)(dir->cluster >> i));
+        }
+    }
+    for(unsigned char i = 0; i < 11; i++){
+        crc = SD_CRC16(crc, entry[i]);
+    }
+
+    return crc;
+}
+
+/**
+ * @brief Writes the directory index's header: which directory it covers,
+ *        where the end marker is, and the directory's fingerprint
+ * @param vol Pointer to the volume
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char FAT_IndexSave(FAT_Volume_t* vol){
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+
+    WINDOW_Claim(vol, vol->card, vol->idxBase);
+    SD_Store32(&window.data[0], FAT_INDEX_MAGIC);
+    SD_Store32(&window.data[4], vol->idxDir);
+    SD_Store32(&window.data[8], vol->idxEndCluster);
+    SD_Store32(&window.data[12], vol->idxEndSector);
+    SD_Store16(&window.data[16], vol->idxEndSectorIdx);
+    window.data[18] = vol->idxEndSlot;
+    SD_Store16(&window.data[20], vol->idxFingerprint);
+    SD_Store16(&window.data[22], FAT_INDEX_SECTORS);
+    window.dirty = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Checks that the directory index's header matches the directory: the
+ *        directory is read up to its end marker, which has to be where the
+ *        index saw it last, and its fingerprint has to be unchanged
+ * @param vol Pointer to the volume, with idxBase and idxDir set
+ * @return 1 if the index can be used, 0 if it has to be rebuilt
+ */
+static unsigned char FAT_IndexCheck(FAT_Volume_t* vol){
+    FAT_Dir_t dir;
+    unsigned short fingerprint = 0xFFFF;
+    unsigned char* p;
+
+    if(!FAT_WindowLoad(vol, vol->idxBase)){
+        return 0;
+    }
+    if((SD_Load32(&window.data[0]) != FAT_INDEX_MAGIC) ||
+       (SD_Load32(&window.data[4]) != vol->idxDir) ||
+       (SD_Load16(&window.data[22]) != FAT_INDEX_SECTORS)){
+        return 0;
+    }
+    vol->idxEndCluster = SD_Load32(&window.data[8]);
+    vol->idxEndSector = SD_Load32(&window.data[12]);
+    vol->idxEndSectorIdx = SD_Load16(&window.data[16]);
+    vol->idxEndSlot = window.data[18];
+    vol->idxFingerprint = SD_Load16(&window.data[20]);
+
+    // A name created or renamed anywhere before the end marker, even in a
+    // deleted slot, changes the fingerprint
+    FAT_DirStart(vol, &dir, vol->idxDir);
+    while(1){
+        p = FAT_DirEntry(&dir);
+        if(p == NULL){
+            return 0;
+        }
+        if(p[0] == 0x00){
+            break;
+        }
+        fingerprint = FAT_IndexMix(fingerprint, &dir, p);
+        if(!FAT_DirNext(&dir, 0)){
+            return 0;
+        }
+    }
+
+    return (dir.cluster == vol->idxEndCluster) &&
+           (dir.sector == vol->idxEndSector) &&
+           (dir.sectorIdx == vol->idxEndSectorIdx) &&
+           (dir.entry == vol->idxEndSlot) &&
+           (fingerprint == vol->idxFingerprint);
+}
+#endif
\ No newline at end of file
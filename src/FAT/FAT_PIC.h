@@ -0,0 +1,416 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 21, 2026, 10:00 AM
+ *
+ * @defgroup FAT
+ * @brief FAT16/FAT32 file system on top of the block driver, so that cards
+ *        written by the PIC can be read on a PC. Sized for the PIC18F4620:
+ *        all metadata goes through a single shared 512 byte sector window,
+ *        paths are resolved iteratively, and only 8.3 names are supported.
+ *        Whole sectors of file data bypass the window and are transferred
+ *        directly to/from the caller's buffer, using multiple block reads
+ *        (CMD18) and writes (CMD25) when more than one sector is involved.
+ *        Define FAT_USE_INDEX to build the optional directory index, which
+ *        makes opening and creating files in one large directory take a
+ *        constant number of sector transfers
+ * @{
+ */
+
+#ifndef FAT_PIC_H
+#define FAT_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Date stamped on files that are created or modified (FAT format) */
+#ifndef FAT_TIMESTAMP_DATE
+#define FAT_TIMESTAMP_DATE ((((2017U - 1980U) << 9) | (7U << 5) | 21U))
+#endif
+
+/** @brief Time stamped on files that are created or modified (FAT format) */
+#ifndef FAT_TIMESTAMP_TIME
+#define FAT_TIMESTAMP_TIME 0U
+#endif
+
+/**
+ * @brief Bytes of RAM per volume for the coarse free-space map. Each bit
+ *        covers a group of FAT sectors, so the allocator can skip groups with
+ *        no free clusters without reading them
+ */
+#ifndef FAT_FREEMAP_BYTES
+#define FAT_FREEMAP_BYTES 32
+#endif
+
+/** @brief Sectors of hash buckets in a directory index (64 names each) */
+#ifndef FAT_INDEX_SECTORS
+#define FAT_INDEX_SECTORS 16
+#endif
+
+/** @brief Runs of consecutive clusters cached per open file */
+#ifndef FAT_MAX_EXTENTS
+#define FAT_MAX_EXTENTS 4
+#endif
+
+/** @brief Most FAT entries followed each time a file's extents are mapped */
+#ifndef FAT_MAP_CLUSTERS
+#define FAT_MAP_CLUSTERS 1024
+#endif
+
+/** @brief Directory entry attribute: read only */
+#define FAT_ATTR_READ_ONLY 0x01
+/** @brief Directory entry attribute: hidden */
+#define FAT_ATTR_HIDDEN    0x02
+/** @brief Directory entry attribute: system */
+#define FAT_ATTR_SYSTEM    0x04
+/** @brief Directory entry attribute: volume label */
+#define FAT_ATTR_VOLUME_ID 0x08
+/** @brief Directory entry attribute: directory */
+#define FAT_ATTR_DIRECTORY 0x10
+/** @brief Directory entry attribute: archive */
+#define FAT_ATTR_ARCHIVE   0x20
+
+/********************************** Types ************************************/
+/** @brief File system types */
+typedef enum{
+    FAT_TYPE_FAT16 = 0, /**< 4085 to 65524 clusters   */
+    FAT_TYPE_FAT32 = 1  /**< 65525 clusters and above */
+}fat_type_e;
+
+/** @brief Ways a file can be opened */
+typedef enum{
+    FAT_MODE_READ = 0,  /**< Read only. The file must exist                */
+    FAT_MODE_WRITE = 1, /**< Read/write. Created if missing, else truncated */
+    FAT_MODE_APPEND = 2 /**< Read/write. Created if missing, starts at end  */
+}fat_mode_e;
+
+/** @brief A mounted volume */
+typedef struct{
+    SDCard_t* card;             /**< Card the volume is on */
+    fat_type_e type;            /**< FAT16 or FAT32 */
+    unsigned char sectorsPerCluster; /**< Cluster size, in sectors */
+    unsigned char numFats;      /**< Number of FAT copies */
+    unsigned long fatStart;     /**< First sector of the first FAT */
+    unsigned long fatSize;      /**< Sectors per FAT */
+    unsigned long rootStart;    /**< First sector of the FAT16 root dir */
+    unsigned short rootSectors; /**< Sectors in the FAT16 root dir */
+    unsigned long rootCluster;  /**< First cluster of the FAT32 root dir */
+    unsigned long dataStart;    /**< Sector of cluster 2 */
+    unsigned long numClusters;  /**< Number of data clusters */
+    unsigned long fsInfoSector; /**< FAT32 FSInfo sector (0 if none) */
+    unsigned long freeHint;     /**< Cluster to start looking for free ones */
+    unsigned char unsealed;     /**< 1 once allocation has changed this mount */
+    unsigned long mapSector;    /**< First sector of the fine free-space map
+                                 *   (one bit per FAT sector) in the reserved
+                                 *   area (0: none) */
+    unsigned char mapValid;     /**< 1 if the fine map can be trusted */
+    unsigned short groupSectors; /**< FAT sectors per coarse map bit */
+    unsigned char freeMap[FAT_FREEMAP_BYTES]; /**< Coarse free-space map. Bit
+                                 *   clear: the group has no free clusters */
+#ifdef FAT_USE_INDEX
+    unsigned long idxBase;      /**< First sector of the attached directory
+                                 *   index (0: none) */
+    unsigned long idxDir;       /**< First cluster of the indexed directory */
+    unsigned long idxEndCluster; /**< Cluster of the directory's end marker */
+    unsigned long idxEndSector; /**< Sector of the directory's end marker */
+    unsigned short idxEndSectorIdx; /**< Index of idxEndSector within its
+                                 *   cluster or the root directory */
+    unsigned char idxEndSlot;   /**< Entry of the end marker in its sector */
+    unsigned short idxFingerprint; /**< Fingerprint of the directory's names
+                                 *   and clusters up to the end marker */
+#endif
+}FAT_Volume_t;
+
+/** @brief Run of consecutive clusters belonging to a file */
+typedef struct{
+    unsigned long fileIdx; /**< Index of the run's first cluster in the file */
+    unsigned long cluster; /**< First cluster of the run */
+    unsigned long length;  /**< Number of clusters in the run */
+}FAT_Extent_t;
+
+/** @brief An open file */
+typedef struct{
+    FAT_Volume_t* vol;          /**< Volume the file is on */
+    unsigned long firstCluster; /**< First cluster (0 if the file is empty) */
+    unsigned long size;         /**< File size, in bytes */
+    unsigned long pos;          /**< Current position, in bytes */
+    unsigned long cluster;      /**< Cluster holding pos, once located */
+    unsigned long clusterIdx;   /**< Index of cluster within the chain */
+    unsigned long dirSector;    /**< Sector holding the directory entry */
+    unsigned short dirOffset;   /**< Offset of the entry within dirSector */
+    unsigned long contigClusters; /**< Clusters reserved in one run from
+                                   *   firstCluster (0: not preallocated) */
+    fat_mode_e mode;            /**< How the file was opened */
+    unsigned char dirty;        /**< 1 if the directory entry is out of date */
+    unsigned char streaming;    /**< 1 while a stream is open on the file */
+    unsigned char reading;      /**< 1 while a read stream is open */
+    unsigned long runLeft;      /**< Sectors left in the open multiple block
+                                 *   read of the read stream */
+    FAT_Extent_t extents[FAT_MAX_EXTENTS]; /**< Cached cluster runs */
+    unsigned char numExtents;   /**< Number of valid entries in extents */
+}FAT_File_t;
+
+/** @brief Directory traversal state */
+typedef struct{
+    FAT_Volume_t* vol;        /**< Volume the directory is on */
+    unsigned long cluster;    /**< Current cluster (0: FAT16 root directory) */
+    unsigned long sector;     /**< Current sector */
+    unsigned short sectorIdx; /**< Sector within the cluster or root dir */
+    unsigned char entry;      /**< Entry within the sector (0 to 15) */
+    unsigned char end;        /**< 1 once the end of the directory is reached */
+}FAT_Dir_t;
+
+/** @brief Directory entry information returned by FAT_ReadDir */
+typedef struct{
+    char name[13];         /**< "NAME.EXT", NUL-terminated */
+    unsigned char attr;    /**< Attributes (FAT_ATTR_*) */
+    unsigned long size;    /**< File size, in bytes */
+    unsigned long cluster; /**< First cluster */
+}FAT_DirInfo_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Mounts the FAT16 or FAT32 volume on a card. Sector 0 may either be
+ *        the volume's boot sector or a master boot record (MBR), in which
+ *        case the first FAT16 or FAT32 partition is mounted
+ * @pre The card has been initialized using initSD, and the SPI module has
+ *      been started using sd_start
+ * @param vol Pointer to the volume
+ * @param card Pointer to the card
+ * @return 1 if successful, 0 if no supported volume was found
+ */
+unsigned char FAT_Mount(FAT_Volume_t* vol, SDCard_t* card);
+
+/**
+ * @brief Mounts the FAT16 or FAT32 volume that starts at a given block, e.g.
+ *        a partition found using the PART module
+ * @pre The card has been initialized using initSD
+ * @param vol Pointer to the volume
+ * @param card Pointer to the card
+ * @param startBlock Block holding the volume's boot sector
+ * @return 1 if successful, 0 if there is no supported volume there
+ */
+unsigned char FAT_MountPartition(
+    FAT_Volume_t* vol,
+    SDCard_t* card,
+    unsigned long startBlock
+);
+
+/**
+ * @brief Flushes the sector window and, on FAT32, seals the free-space map:
+ *        FSInfo gets the next free cluster and a stamp in its reserved bytes,
+ *        so that the next mount can reuse the map instead of rebuilding it.
+ *        A map is only reused if FSInfo is unchanged since it was sealed, so
+ *        modifications made elsewhere (e.g. on a PC) invalidate it, and so
+ *        does a power failure before this is called
+ * @pre Every file on the volume has been closed
+ * @param vol Pointer to the volume
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char FAT_Unmount(FAT_Volume_t* vol);
+
+/**
+ * @brief Opens a file
+ * @param vol Pointer to the volume
+ * @param file Pointer to the file
+ * @param path Path of the file, e.g. "LOGS/DATA.CSV". Each component is an
+ *        8.3 name. Matching is case-insensitive
+ * @param mode How to open the file
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char FAT_Open(
+    FAT_Volume_t* vol,
+    FAT_File_t* file,
+    const char* path,
+    fat_mode_e mode
+);
+
+/**
+ * @brief Reads from the current position, which is advanced
+ * @param file Pointer to the file
+ * @param buf Pointer to where the data is to be stored
+ * @param len Maximum number of bytes to read
+ * @return The number of bytes read, which is less than len at the end of the
+ *         file or if an error occurred
+ */
+unsigned short FAT_Read(
+    FAT_File_t* file,
+    unsigned char* buf,
+    unsigned short len
+);
+
+/**
+ * @brief Writes at the current position, which is advanced. Clusters are
+ *        allocated as the file grows
+ * @param file Pointer to the file, opened for writing or appending
+ * @param buf Pointer to the data to be written
+ * @param len Number of bytes to write
+ * @return The number of bytes written, which is less than len if the volume
+ *         is full or an error occurred
+ */
+unsigned short FAT_Write(
+    FAT_File_t* file,
+    unsigned char* buf,
+    unsigned short len
+);
+
+/**
+ * @brief Moves the current position
+ * @param file Pointer to the file
+ * @param pos New position, in bytes from the start of the file
+ * @return 1 if successful, 0 if pos is past the end of the file
+ */
+unsigned char FAT_Seek(FAT_File_t* file, unsigned long pos);
+
+/**
+ * @brief Reserves a contiguous run of clusters for an empty file and links
+ *        its cluster chain in one pass, so that the file can then be written
+ *        by streaming (see FAT_StreamStart) without touching the FAT again.
+ *        The file size stays 0 until data is written; reserved clusters past
+ *        the end of the data remain allocated to the file
+ * @param file Pointer to the file, opened for writing or appending and empty
+ * @param numBytes Number of bytes to reserve, rounded up to whole clusters
+ * @return 1 if successful, 0 if the file isn't empty or no free run of
+ *         clusters is long enough
+ */
+unsigned char FAT_Preallocate(FAT_File_t* file, unsigned long numBytes);
+
+/**
+ * @brief Opens a single multiple block write (CMD25) covering the rest of a
+ *        preallocated file, starting at the current position. Sectors are
+ *        then sent at raw speed using FAT_StreamSend; neither the FAT nor the
+ *        directory is touched until FAT_Sync or FAT_Close
+ * @pre The file was preallocated using FAT_Preallocate. No other file on the
+ *      card is accessed until the stream is stopped, except through FAT_Sync
+ *      on this file
+ * @param file Pointer to the file. The position must be a multiple of 512
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char FAT_StreamStart(FAT_File_t* file);
+
+/**
+ * @brief Sends the next sector of a stream, advancing the position and
+ *        growing the file size as needed
+ * @pre The stream was opened using FAT_StreamStart
+ * @param file Pointer to the file
+ * @param arrWrite Pointer to the 512 bytes to be written
+ * @return 1 if successful, 0 if the card rejected the sector or the
+ *         preallocated space is used up
+ */
+unsigned char FAT_StreamSend(FAT_File_t* file, unsigned char* arrWrite);
+
+/**
+ * @brief Stops a stream
+ * @pre The stream was opened using FAT_StreamStart
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise (see SD_MBW_Stop)
+ */
+unsigned char FAT_StreamStop(FAT_File_t* file);
+
+/**
+ * @brief Starts reading a file sector by sector at the current position. The
+ *        cluster chain is mapped ahead into the file's extent cache, and each
+ *        run of consecutive clusters is read with a single multiple block
+ *        read (CMD18), so a defragmented file streams at the card's rate
+ * @pre No other file on the card is accessed until the stream is stopped,
+ *      except through FAT_Sync on this file
+ * @param file Pointer to the file. The position must be a multiple of 512
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char FAT_ReadStreamStart(FAT_File_t* file);
+
+/**
+ * @brief Receives the next sector of a read stream, advancing the position
+ * @pre The stream was opened using FAT_ReadStreamStart
+ * @param file Pointer to the file
+ * @param buf Pointer to the 512 byte array that will store the data
+ * @return The number of bytes of file data in buf (less than 512 for the last
+ *         sector), or 0 at the end of the file or if an error occurred
+ */
+unsigned short FAT_ReadStreamNext(FAT_File_t* file, unsigned char* buf);
+
+/**
+ * @brief Stops a read stream
+ * @param file Pointer to the file
+ */
+void FAT_ReadStreamStop(FAT_File_t* file);
+
+/**
+ * @brief Writes the file's size and first cluster to its directory entry and
+ *        flushes the sector window, so that the data written so far survives
+ *        a power failure. An open stream is suspended for the update and then
+ *        resumed, so this also serves as a checkpoint while streaming. An
+ *        open read stream picks up again at the next FAT_ReadStreamNext
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char FAT_Sync(FAT_File_t* file);
+
+/**
+ * @brief Closes a file, stopping its streams if any are open, then calling
+ *        FAT_Sync
+ * @param file Pointer to the file
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char FAT_Close(FAT_File_t* file);
+
+/**
+ * @brief Opens a directory for traversal
+ * @param vol Pointer to the volume
+ * @param dir Pointer to the traversal state
+ * @param path Path of the directory. "" or "/" is the root directory
+ * @return 1 if successful, 0 if the directory doesn't exist
+ */
+unsigned char FAT_OpenDir(FAT_Volume_t* vol, FAT_Dir_t* dir, const char* path);
+
+/**
+ * @brief Gets the next entry of a directory. Long file name entries, volume
+ *        labels and deleted entries are skipped
+ * @param dir Pointer to the traversal state
+ * @param info Pointer to where the entry information is to be stored
+ * @return 1 if an entry was returned, 0 at the end of the directory
+ */
+unsigned char FAT_ReadDir(FAT_Dir_t* dir, FAT_DirInfo_t* info);
+
+#ifdef FAT_USE_INDEX
+/**
+ * @brief Attaches a hashed index to a directory. The index maps the hash of
+ *        each 8.3 name to the sector and slot of its entry, and records where
+ *        the directory's end marker is, so that FAT_Open finds existing files
+ *        and creates new ones (at the end of the directory) without scanning
+ *        it. The index is kept in a hidden, contiguous file named
+ *        DIRINDEX.SYS in the directory. Attaching reads the directory once
+ *        to fingerprint its names and clusters, and the index is rebuilt if
+ *        the fingerprint or the end marker doesn't match what the index last
+ *        saw, e.g. because a name was created or renamed elsewhere. Hits are
+ *        always checked against the directory entry, and a stale one
+ *        detaches the index
+ * @param vol Pointer to the volume. Only one directory per volume is indexed
+ * @param path Path of the directory. "" or "/" is the root directory
+ * @return 1 if successful, 0 otherwise (the directory is then scanned as
+ *         usual)
+ */
+unsigned char FAT_IndexAttach(FAT_Volume_t* vol, const char* path);
+
+/**
+ * @brief Rebuilds the attached directory index by scanning the directory
+ * @param vol Pointer to the volume
+ * @return 1 if successful, 0 otherwise (the index is then detached)
+ */
+unsigned char FAT_IndexRebuild(FAT_Volume_t* vol);
+
+/**
+ * @brief Detaches the directory index. The index file stays on the card and
+ *        is checked when it is next attached
+ * @param vol Pointer to the volume
+ */
+void FAT_IndexDetach(FAT_Volume_t* vol);
+#endif
+
+/**
+ * @}
+ */
+
+#endif	/* FAT_PIC_H */
\ No newline at end of file
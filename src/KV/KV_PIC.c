@@ -0,0 +1,587 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 24, 2026, 2:30 PM
+ *
+ * @ingroup KV
+ */
+
+/********************************* Includes **********************************/
+#include <string.h>
+#include "KV_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Bytes at the start of each sector taken by the sector header */
+#define KV_HEADER 8
+
+/** @brief Bytes in front of each value (key, length and CRC16) */
+#define KV_ENTRY 5
+
+/** @brief Length of an entry that marks its key as deleted */
+#define KV_DELETED 0xFF
+
+/*
+ * Sector 0 of a bank is its header, written last when the bank is filled by
+ * a compaction, little-endian:
+ *   0 'K', 'V'
+ *   2 generation, one more than that of the bank it was compacted from
+ *   6 CRC16 of bytes 0 to 5
+ * Sectors 1 and up hold the entries, after a header of their own:
+ *   0 generation of the bank
+ *   4 bytes of the sector in use
+ *   6 CRC16 of bytes 0 to 5
+ * Each entry is its key (2 bytes), the length of its value (1 byte, or
+ * KV_DELETED), the CRC16 of the key, length and value (2 bytes), then the
+ * value. Entries never cross sectors. Sectors are filled in order, so the
+ * entries of a bank end at the first sector of another generation
+ */
+
+/************************ Private Function Prototypes ************************/
+static unsigned short KV_HeaderCRC(const unsigned char* hdr, unsigned char n);
+static unsigned short KV_EntryCRC(const unsigned char* entry);
+static unsigned long KV_Block(
+    const KV_Store_t* store,
+    unsigned char bank,
+    unsigned short sector
+);
+static KV_Slot_t* KV_Find(KV_Store_t* store, unsigned short key);
+static unsigned char KV_Insert(
+    KV_Store_t* store,
+    unsigned short key,
+    unsigned short sector,
+    unsigned short offset
+);
+static unsigned char KV_WriteTail(
+    KV_Store_t* store,
+    unsigned char bank,
+    unsigned short sector
+);
+static unsigned char KV_Scan(KV_Store_t* store);
+static unsigned char KV_Append(
+    KV_Store_t* store,
+    unsigned short key,
+    const unsigned char* value,
+    unsigned char len
+);
+static unsigned char KV_Copy(KV_Store_t* store, unsigned char next);
+
+/***************************** Public Functions ******************************/
+unsigned char KV_Mount(
+    KV_Store_t* store,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char* buf
+)
+{
+    unsigned char hdr[KV_HEADER];
+    SD_IOVec_t iov;
+    unsigned char found = 0;
+    unsigned long gen;
+
+    store->card = card;
+    store->startBlock = startBlock;
+    store->bankBlocks = numBlocks / KV_BANKS;
+    store->buf = buf;
+    if((store->bankBlocks < 2) || (store->bankBlocks > 0xFFFF)){
+        return 0;
+    }
+
+    // The bank with the latest generation is the active one
+    iov.base = hdr;
+    iov.len = KV_HEADER;
+    for(unsigned char b = 0; b < KV_BANKS; b++){
+        if(!SD_SingleBlockReadV(card, KV_Block(store, b, 0), &iov, 1)){
+            return 0;
+        }
+        if((hdr[0] != 'K') || (hdr[1] != 'V') ||
+           (KV_HeaderCRC(hdr, 6) != SD_Load16(&hdr[6]))){
+            continue;
+        }
+        gen = SD_Load32(&hdr[2]);
+        if(!found || (gen > store->gen)){
+            store->gen = gen;
+            store->bank = b;
+            found = 1;
+        }
+    }
+
+    // Start an empty store in bank 0
+    if(!found){
+        store->gen = 1;
+        store->bank = 0;
+        hdr[0] = 'K';
+        hdr[1] = 'V';
+        SD_Store32(&hdr[2], store->gen);
+        SD_Store16(&hdr[6], KV_HeaderCRC(hdr, 6));
+        if(!SD_SingleBlockWriteV(card, KV_Block(store, 0, 0), &iov, 1)){
+            return 0;
+        }
+    }
+
+    return KV_Scan(store);
+}
+
+unsigned char KV_Get(
+    KV_Store_t* store,
+    unsigned short key,
+    unsigned char* value,
+    unsigned char maxLen,
+    unsigned char* len
+)
+{
+    KV_Slot_t* slot = KV_Find(store, key);
+    unsigned char entry[KV_ENTRY];
+    unsigned char* p;
+    SD_IOVec_t iov[3];
+    unsigned short crc;
+    unsigned char n;
+
+    if(slot->key != key){
+        return 0;
+    }
+
+    // Entries in the last sector are already in RAM
+    if(slot->sector == store->tail){
+        p = &store->buf[slot->offset];
+        n = p[2];
+        if((n == KV_DELETED) || (n > maxLen)){
+            return 0;
+        }
+        memcpy(value, &p[KV_ENTRY], n);
+        *len = n;
+        return 1;
+    }
+
+    // Otherwise only the entry is read. The value is read into place along
+    // with its header, up to maxLen bytes
+    n = maxLen;
+    if(n > 512 - KV_ENTRY - slot->offset){
+        n = 512 - KV_ENTRY - slot->offset;
+    }
+    iov[0].base = NULL;
+    iov[0].len = slot->offset;
+    iov[1].base = entry;
+    iov[1].len = KV_ENTRY;
+    iov[2].base = value;
+    iov[2].len = n;
+    if(!SD_SingleBlockReadV(
+            store->card,
+            KV_Block(store, store->bank, slot->sector),
+            iov,
+            3
+        )
+    )
+    {
+        return 0;
+    }
+    if((entry[2] == KV_DELETED) || (entry[2] > maxLen)){
+        return 0;
+    }
+
+    crc = 0;
+    for(unsigned char i = 0; i < 3; i++){
+        crc = SD_CRC16(crc, entry[i]);
+    }
+    for(unsigned char i = 0; i < entry[2]; i++){
+        crc = SD_CRC16(crc, value[i]);
+    }
+    if(crc != SD_Load16(&entry[3])){
+        return 0;
+    }
+
+    *len = entry[2];
+    return 1;
+}
+
+unsigned char KV_Set(
+    KV_Store_t* store,
+    unsigned short key,
+    const unsigned char* value,
+    unsigned char len
+)
+{
+    if((key == KV_NO_KEY) || (len > KV_MAX_VALUE)){
+        return 0;
+    }
+    return KV_Append(store, key, value, len);
+}
+
+unsigned char KV_Delete(KV_Store_t* store, unsigned short key){
+    if(KV_Find(store, key)->key != key){
+        return 1;
+    }
+    return KV_Append(store, key, NULL, KV_DELETED);
+}
+
+unsigned char KV_Compact(KV_Store_t* store){
+    unsigned char next = (store->bank + 1) % KV_BANKS;
+
+    store->gen++;
+    if(!KV_Copy(store, next)){
+        // The old bank is untouched, so go back to it
+        store->gen--;
+        KV_Scan(store);
+        return 0;
+    }
+
+    store->bank = next;
+    return KV_Scan(store);
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Computes the CRC16 of the start of a header
+ * @param hdr Pointer to the header
+ * @param n Number of bytes covered
+ * @return The CRC
+ */
+static unsigned short KV_HeaderCRC(const unsigned char* hdr, unsigned char n){
+    unsigned short crc = 0;
+
+    for(unsigned char i = 0; i < n; i++){
+        crc = SD_CRC16(crc, hdr[i]);
+    }
+    return crc;
+}
+
+/**
+ * @brief Computes the CRC16 of an entry, skipping the CRC itself
+ * @param entry Pointer to the entry
+ * @return The CRC
+ */
+static unsigned short KV_EntryCRC(const unsigned char* entry){
+    unsigned short crc = KV_HeaderCRC(entry, 3);
+
+    if(entry[2] != KV_DELETED){
+        for(unsigned char i = 0; i < entry[2]; i++){
+            crc = SD_CRC16(crc, entry[KV_ENTRY + i]);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Computes the block number of a sector of a bank
+ * @param store Pointer to the store
+ * @param bank Bank
+ * @param sector Sector within the bank
+ * @return The block number on the card
+ */
+static unsigned long KV_Block(
+    const KV_Store_t* store,
+    unsigned char bank,
+    unsigned short sector
+)
+{
+    return store->startBlock + bank * store->bankBlocks + sector;
+}
+
+/**
+ * @brief Looks a key up in the table
+ * @param store Pointer to the store
+ * @param key Key
+ * @return Pointer to the key's slot if it is in the table. Otherwise, pointer
+ *         to the unused slot where it would go, or to a slot holding another
+ *         key if the table is full
+ */
+static KV_Slot_t* KV_Find(KV_Store_t* store, unsigned short key){
+    unsigned char i = (unsigned char)((key ^ (key >> 8)) % KV_MAX_KEYS);
+    KV_Slot_t* slot;
+
+    for(unsigned char n = 0; n < KV_MAX_KEYS; n++){
+        slot = &store->slots[i];
+        if((slot->key == key) || (slot->key == KV_NO_KEY)){
+            return slot;
+        }
+        i = (i + 1) % KV_MAX_KEYS;
+    }
+    return slot;
+}
+
+/**
+ * @brief Records where the latest entry for a key is
+ * @param store Pointer to the store
+ * @param key Key
+ * @param sector Sector of the entry within the bank
+ * @param offset Offset of the entry within the sector
+ * @return 1 if successful, 0 if the table is full
+ */
+static unsigned char KV_Insert(
+    KV_Store_t* store,
+    unsigned short key,
+    unsigned short sector,
+    unsigned short offset
+)
+{
+    KV_Slot_t* slot = KV_Find(store, key);
+
+    if(slot->key != key){
+        if(slot->key != KV_NO_KEY){
+            return 0;
+        }
+        slot->key = key;
+        store->numKeys++;
+    }
+    slot->sector = sector;
+    slot->offset = offset;
+    return 1;
+}
+
+/**
+ * @brief Fills in the header of the buffered sector and writes it
+ * @param store Pointer to the store. Its generation and fill are used
+ * @param bank Bank to write to
+ * @param sector Sector within the bank
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char KV_WriteTail(
+    KV_Store_t* store,
+    unsigned char bank,
+    unsigned short sector
+)
+{
+    unsigned char* buf = store->buf;
+
+    SD_Store32(&buf[0], store->gen);
+    SD_Store16(&buf[4], store->fill);
+    SD_Store16(&buf[6], KV_HeaderCRC(buf, 6));
+    return SD_SingleBlockWrite(store->card, KV_Block(store, bank, sector), buf);
+}
+
+/**
+ * @brief Rebuilds the table from the entries of the active bank, and loads
+ *        its last sector into the buffer
+ * @param store Pointer to the store
+ * @return 1 if successful, 0 if the card couldn't be read or the table is
+ *         full
+ */
+static unsigned char KV_Scan(KV_Store_t* store){
+    unsigned char* buf = store->buf;
+    unsigned short used;
+    unsigned short off;
+    unsigned short size;
+    unsigned short s;
+
+    for(unsigned char i = 0; i < KV_MAX_KEYS; i++){
+        store->slots[i].key = KV_NO_KEY;
+    }
+    store->numKeys = 0;
+    store->tail = 1;
+    store->fill = KV_HEADER;
+
+    for(s = 1; s < store->bankBlocks; s++){
+        if(!SD_SingleBlockRead(store->card, KV_Block(store, store->bank, s),
+                               buf)){
+            return 0;
+        }
+        used = SD_Load16(&buf[4]);
+        if((SD_Load32(&buf[0]) != store->gen) || (used < KV_HEADER) ||
+           (used > 512) ||
+           (KV_HeaderCRC(buf, 6) != SD_Load16(&buf[6]))){
+            break;
+        }
+
+        // Entries that fail their CRC are left out, and later entries for a
+        // key replace earlier ones
+        off = KV_HEADER;
+        while(off + KV_ENTRY <= used){
+            size = KV_ENTRY;
+            if(buf[off + 2] != KV_DELETED){
+                size += buf[off + 2];
+            }
+            if(off + size > used){
+                break;
+            }
+            if(KV_EntryCRC(&buf[off]) == SD_Load16(&buf[off + 3])){
+                if(!KV_Insert(store, SD_Load16(&buf[off]), s, off)){
+                    return 0;
+                }
+            }
+            off += size;
+        }
+        store->tail = s;
+        store->fill = used;
+    }
+
+    // The loop stopped at the sector after the last one
+    if((s < store->bankBlocks) && (s != store->tail)){
+        if(!SD_SingleBlockRead(store->card,
+                               KV_Block(store, store->bank, store->tail),
+                               buf)){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Appends an entry to the last sector and writes it, moving on to the
+ *        next sector or compacting the bank when it doesn't fit
+ * @param store Pointer to the store
+ * @param key Key
+ * @param value Pointer to the value, or NULL for a deletion
+ * @param len Length of the value, or KV_DELETED
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char KV_Append(
+    KV_Store_t* store,
+    unsigned short key,
+    const unsigned char* value,
+    unsigned char len
+)
+{
+    unsigned char* buf = store->buf;
+    unsigned short size = KV_ENTRY;
+    unsigned char* p;
+    KV_Slot_t* slot = KV_Find(store, key);
+
+    // Deleted keys only leave the table when the bank is compacted
+    if((slot->key != key) && (slot->key != KV_NO_KEY)){
+        if(!KV_Compact(store)){
+            return 0;
+        }
+        slot = KV_Find(store, key);
+        if((slot->key != key) && (slot->key != KV_NO_KEY)){
+            return 0;
+        }
+    }
+    if(len != KV_DELETED){
+        size += len;
+    }
+
+    if(store->fill + size > 512){
+        if((unsigned long)store->tail + 1 < store->bankBlocks){
+            store->tail++;
+            store->fill = KV_HEADER;
+        }
+        else{
+            if(!KV_Compact(store)){
+                return 0;
+            }
+            if(store->fill + size > 512){
+                if((unsigned long)store->tail + 1 >= store->bankBlocks){
+                    return 0;
+                }
+                store->tail++;
+                store->fill = KV_HEADER;
+            }
+        }
+    }
+
+    p = &buf[store->fill];
+    SD_Store16(&p[0], key);
+    p[2] = len;
+    if(len != KV_DELETED){
+        memcpy(&p[KV_ENTRY], value, len);
+    }
+    SD_Store16(&p[3], KV_EntryCRC(p));
+
+    store->fill += size;
+    if(!KV_WriteTail(store, store->bank, store->tail)){
+        store->fill -= size;
+        return 0;
+    }
+    return KV_Insert(store, key, store->tail, store->fill - size);
+}
+
+/**
+ * @brief Erases another bank, copies the latest entry of every key that
+ *        hasn't been deleted into it, then writes its header, which makes it
+ *        the one with the latest generation
+ * @param store Pointer to the store. Its generation is that of the new bank.
+ *        The buffer and fill are overwritten
+ * @param next Bank to copy to
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char KV_Copy(KV_Store_t* store, unsigned char next){
+    unsigned char* buf = store->buf;
+    unsigned short sector = 1;
+    unsigned short fill = KV_HEADER;
+    unsigned char hdr[KV_HEADER];
+    unsigned short size;
+    KV_Slot_t* slot;
+    SD_IOVec_t iov[2];
+
+    // A compaction that failed with this generation may have left sectors
+    // that would look like part of the bank, even after more are appended
+    // later on. Erased sectors fail their header, so the bank starts clean
+    if(!SD_EraseBlocks(
+            store->card,
+            KV_Block(store, next, 0),
+            KV_Block(store, next, store->bankBlocks - 1)
+        )
+    )
+    {
+        return 0;
+    }
+
+    // The last sector is on the card, so buf can be used to build the new
+    // bank's sectors. Each live entry is read straight into place
+    for(unsigned char i = 0; i < KV_MAX_KEYS; i++){
+        slot = &store->slots[i];
+        if(slot->key == KV_NO_KEY){
+            continue;
+        }
+
+        iov[0].base = NULL;
+        iov[0].len = slot->offset;
+        iov[1].base = hdr;
+        iov[1].len = KV_ENTRY;
+        if(!SD_SingleBlockReadV(
+                store->card,
+                KV_Block(store, store->bank, slot->sector),
+                iov,
+                2
+            )
+        )
+        {
+            return 0;
+        }
+        if(hdr[2] == KV_DELETED){
+            continue;
+        }
+
+        size = KV_ENTRY + hdr[2];
+        if(fill + size > 512){
+            store->fill = fill;
+            if(!KV_WriteTail(store, next, sector)){
+                return 0;
+            }
+            sector++;
+            fill = KV_HEADER;
+            if(sector >= store->bankBlocks){
+                return 0;
+            }
+        }
+
+        iov[1].base = &buf[fill];
+        iov[1].len = size;
+        if(!SD_SingleBlockReadV(
+                store->card,
+                KV_Block(store, store->bank, slot->sector),
+                iov,
+                2
+            )
+        )
+        {
+            return 0;
+        }
+        fill += size;
+    }
+
+    store->fill = fill;
+    if(!KV_WriteTail(store, next, sector)){
+        return 0;
+    }
+
+    // Switch banks by writing the new bank's header
+    hdr[0] = 'K';
+    hdr[1] = 'V';
+    SD_Store32(&hdr[2], store->gen);
+    SD_Store16(&hdr[6], KV_HeaderCRC(hdr, 6));
+    iov[0].base = hdr;
+    iov[0].len = KV_HEADER;
+    return SD_SingleBlockWriteV(store->card, KV_Block(store, next, 0), iov, 1);
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 24, 2026, 2:30 PM
+ *
+ * @defgroup KV
+ * @brief Small key-value store for configuration and state, over a raw
+ *        region of the card split into KV_BANKS banks. Entries (a 16-bit key,
+ *        a value of up to KV_MAX_VALUE bytes and a CRC16) are appended to the
+ *        last sector of the active bank, so changing a parameter costs one
+ *        single block write. When the bank is full, the live entries are
+ *        compacted into the next bank, whose header sector is written last
+ *        so that a power failure leaves the old bank in use. A hash table in
+ *        RAM, rebuilt when the store is mounted, maps each key to the sector
+ *        and offset of its latest entry, so a get is a single partial read of
+ *        that entry (or no read at all if it is in the buffered last sector)
+ * @{
+ */
+
+#ifndef KV_PIC_H
+#define KV_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Banks the region is split into. Compaction moves to the next one */
+#ifndef KV_BANKS
+#define KV_BANKS 2
+#endif
+
+/** @brief Keys the RAM table can hold, including deleted ones until the next
+ *         compaction */
+#ifndef KV_MAX_KEYS
+#define KV_MAX_KEYS 32
+#endif
+
+/** @brief Longest value, in bytes */
+#define KV_MAX_VALUE 254
+
+/** @brief Key that can't be used, which marks unused slots of the table */
+#define KV_NO_KEY 0xFFFF
+
+/********************************** Types ************************************/
+/** @brief Location of the latest entry for a key */
+typedef struct{
+    unsigned short key;      /**< Key, or KV_NO_KEY if the slot is unused */
+    unsigned short sector;   /**< Sector of the entry within the bank */
+    unsigned short offset;   /**< Offset of the entry within the sector */
+}KV_Slot_t;
+
+/** @brief A mounted key-value store */
+typedef struct{
+    SDCard_t* card;            /**< Card holding the store */
+    unsigned long startBlock;  /**< First block of the region */
+    unsigned long bankBlocks;  /**< Blocks in each bank */
+    unsigned long gen;         /**< Generation of the active bank */
+    unsigned char* buf;        /**< 512 byte buffer holding the last sector
+                                *   of the active bank */
+    unsigned short tail;       /**< Last sector of the active bank */
+    unsigned short fill;       /**< Bytes of the last sector in use */
+    unsigned char bank;        /**< Active bank */
+    unsigned char numKeys;     /**< Slots of the table in use */
+    KV_Slot_t slots[KV_MAX_KEYS]; /**< Hash table, with linear probing */
+}KV_Store_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Mounts the store in a region. The bank with the latest generation is
+ *        scanned once to build the RAM table. A region without a store gets
+ *        an empty one
+ * @pre The card has been initialized using initSD
+ * @param store Pointer to the store
+ * @param card Pointer to the card
+ * @param startBlock First block of the region
+ * @param numBlocks Blocks in the region, split evenly between the banks (at
+ *        least 2 per bank)
+ * @param buf Pointer to a 512 byte buffer, owned by the store
+ * @return 1 if successful, 0 if the card couldn't be accessed or the bank
+ *         holds more keys than the table
+ */
+unsigned char KV_Mount(
+    KV_Store_t* store,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char* buf
+);
+
+/**
+ * @brief Reads the value of a key
+ * @param store Pointer to the store
+ * @param key Key
+ * @param value Pointer to the array that will store the value
+ * @param maxLen Size of value
+ * @param len Set to the length of the value
+ * @return 1 if successful, 0 if the key isn't in the store, its value is
+ *         longer than maxLen, or its entry couldn't be read or failed its CRC
+ */
+unsigned char KV_Get(
+    KV_Store_t* store,
+    unsigned short key,
+    unsigned char* value,
+    unsigned char maxLen,
+    unsigned char* len
+);
+
+/**
+ * @brief Sets the value of a key by appending an entry to the last sector of
+ *        the active bank and writing that sector. The bank is compacted first
+ *        if it is full
+ * @param store Pointer to the store
+ * @param key Key, anything but KV_NO_KEY
+ * @param value Pointer to the value
+ * @param len Length of the value, up to KV_MAX_VALUE bytes
+ * @return 1 if successful, 0 if the table or the store is full or the write
+ *         failed
+ */
+unsigned char KV_Set(
+    KV_Store_t* store,
+    unsigned short key,
+    const unsigned char* value,
+    unsigned char len
+);
+
+/**
+ * @brief Deletes a key by appending an entry that marks it as deleted. Its
+ *        slot in the table is freed by the next compaction
+ * @param store Pointer to the store
+ * @param key Key
+ * @return 1 if successful (or the key wasn't in the store), 0 otherwise
+ */
+unsigned char KV_Delete(KV_Store_t* store, unsigned short key);
+
+/**
+ * @brief Copies the latest entry of every key that hasn't been deleted into
+ *        the next bank and switches to it. Happens by itself when the active
+ *        bank fills up
+ * @param store Pointer to the store
+ * @return 1 if successful, 0 if the entries don't fit in a bank or the card
+ *         couldn't be accessed
+ */
+unsigned char KV_Compact(KV_Store_t* store);
+
+/**
+ * @}
+ */
+
+#endif	/* KV_PIC_H */
\ No newline at end of file
@@ -0,0 +1,516 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 23, 2026, 10:20 AM
+ *
+ * @ingroup LOG
+ */
+
+/********************************* Includes **********************************/
+#include <string.h>
+#include "LOG_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Bytes at the start of each sector taken by the sector header */
+#define LOG_HEADER 16
+
+/** @brief Bytes in front of each record (length and CRC16) */
+#define LOG_RECORD_HEADER 4
+
+/** @brief First record offset of a sector in which no record starts */
+#define LOG_NONE 0xFFFF
+
+/*
+ * Layout of the sector header, little-endian:
+ *   0  epoch
+ *   2  sequence number of the sector (its index in the region)
+ *   6  sequence number of the first record that starts in the sector, or of
+ *      the next record to start if none does
+ *   10 offset of that record's header within the payload, or LOG_NONE
+ *   12 bytes of the payload that are used
+ *   14 CRC16 of the rest of the sector
+ * A record header (length, then CRC16 of the record) is never split between
+ * sectors. If fewer than 4 bytes are left, the sector is sent as it is
+ */
+
+/************************ Private Function Prototypes ************************/
+static unsigned short LOG_SectorCRC(const unsigned char* buf);
+static unsigned char LOG_Intact(const unsigned char* buf, unsigned long sector);
+static unsigned char LOG_Valid(
+    const LOG_Log_t* log,
+    const unsigned char* buf,
+    unsigned long sector
+);
+static void LOG_Begin(LOG_Log_t* log);
+static unsigned char LOG_Send(LOG_Log_t* log);
+static unsigned char LOG_Load(LOG_Reader_t* reader, unsigned long sector);
+
+/***************************** Public Functions ******************************/
+unsigned char LOG_Format(
+    LOG_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char* buf
+)
+{
+    unsigned short top = 0;
+
+    if(numBlocks < 2){
+        return 0;
+    }
+
+    log->card = card;
+    log->startBlock = startBlock;
+    log->numBlocks = numBlocks;
+    log->buf = buf;
+    log->streaming = 0;
+
+    // The new epoch must differ from that of every sector left in the region.
+    // Those may be from the log being replaced or from any older one, so the
+    // whole region is read and the new epoch is one past the highest found
+    if(!SD_MBR_Start(card, startBlock)){
+        return 0;
+    }
+    for(unsigned long i = 0; i < numBlocks; i++){
+        if(!SD_MBR_Receive(card, buf)){
+            SD_MBR_Stop(card);
+            return 0;
+        }
+        if(LOG_Intact(buf, i) && (SD_Load16(&buf[0]) > top)){
+            top = SD_Load16(&buf[0]);
+        }
+    }
+    SD_MBR_Stop(card);
+    log->epoch = top + 1;
+
+    log->head = 0;
+    log->nextSeq = 0;
+    LOG_Begin(log);
+
+    // Sector 0 is written right away, which discards the old log even if no
+    // record is ever appended to the new one
+    SD_MBW_Start(card, startBlock, numBlocks);
+    log->streaming = 1;
+    return LOG_Send(log);
+}
+
+unsigned char LOG_Open(
+    LOG_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char* buf
+)
+{
+    unsigned long lo = 1;
+    unsigned long hi = numBlocks;
+    unsigned long mid;
+    unsigned long off;
+    unsigned short used;
+
+    log->card = card;
+    log->startBlock = startBlock;
+    log->numBlocks = numBlocks;
+    log->buf = buf;
+    log->streaming = 0;
+
+    if(!SD_SingleBlockRead(card, startBlock, buf) ||
+       !LOG_Valid(log, buf, 0)){
+        return 0;
+    }
+    log->epoch = SD_Load16(&buf[0]);
+
+    // The valid sectors form a prefix of the region, so the head is the first
+    // sector that isn't valid. Sectors below lo are valid, hi and above aren't
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(!SD_SingleBlockRead(card, startBlock + mid, buf)){
+            return 0;
+        }
+        if(LOG_Valid(log, buf, mid)){
+            lo = mid + 1;
+        }
+        else{
+            hi = mid;
+        }
+    }
+    log->head = lo;
+
+    // Count the records that start in the last sector to recover the next
+    // sequence number. The last of them may have been cut off, in which case
+    // its sequence number is simply never used
+    if(!SD_SingleBlockRead(card, startBlock + lo - 1, buf)){
+        return 0;
+    }
+    log->nextSeq = SD_Load32(&buf[6]);
+    off = SD_Load16(&buf[10]);
+    used = SD_Load16(&buf[12]);
+    if(off != LOG_NONE){
+        while(off + LOG_RECORD_HEADER <= used){
+            log->nextSeq++;
+            off += LOG_RECORD_HEADER + SD_Load16(&buf[LOG_HEADER + off]);
+        }
+    }
+    LOG_Begin(log);
+
+    if(log->head < numBlocks){
+        SD_MBW_Start(card, startBlock + log->head, numBlocks - log->head);
+        log->streaming = 1;
+    }
+
+    return 1;
+}
+
+unsigned char LOG_Append(
+    LOG_Log_t* log,
+    const unsigned char* data,
+    unsigned short len
+)
+{
+    unsigned char* buf = log->buf;
+    unsigned short crc = 0;
+    unsigned short n;
+
+    if(log->head >= log->numBlocks){
+        return 0;
+    }
+    if(LOG_PAYLOAD_BYTES - log->fill < LOG_RECORD_HEADER){
+        if(!LOG_Send(log) || (log->head >= log->numBlocks)){
+            return 0;
+        }
+    }
+
+    // Refuse records that don't fit in the rest of the region rather than
+    // leaving one behind that was cut off
+    if((log->numBlocks - log->head) * LOG_PAYLOAD_BYTES - log->fill <
+       (unsigned long)len + LOG_RECORD_HEADER){
+        return 0;
+    }
+
+    for(n = 0; n < len; n++){
+        crc = SD_CRC16(crc, data[n]);
+    }
+    SD_Store16(&buf[LOG_HEADER + log->fill], len);
+    SD_Store16(&buf[LOG_HEADER + log->fill + 2], crc);
+    if(log->firstOffset == LOG_NONE){
+        log->firstOffset = log->fill;
+        log->firstSeq = log->nextSeq;
+    }
+    log->fill += LOG_RECORD_HEADER;
+    log->nextSeq++;
+
+    while(len > 0){
+        if(log->fill == LOG_PAYLOAD_BYTES){
+            if(!LOG_Send(log)){
+                return 0;
+            }
+        }
+        n = LOG_PAYLOAD_BYTES - log->fill;
+        if(n > len){
+            n = len;
+        }
+        memcpy(&buf[LOG_HEADER + log->fill], data, n);
+        log->fill += n;
+        data += n;
+        len -= n;
+    }
+
+    return 1;
+}
+
+unsigned char LOG_Flush(LOG_Log_t* log){
+    if(log->fill == 0){
+        return 1;
+    }
+    if(!LOG_Send(log)){
+        return 0;
+    }
+
+    // The card holds DAT0 low until the sector is programmed
+    for(unsigned long i = 0; i < LOG_BUSY_POLLS; i++){
+        if(!SD_IsBusy(log->card)){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+unsigned char LOG_Close(LOG_Log_t* log){
+    unsigned char ok = LOG_Flush(log);
+
+    if(log->streaming){
+        if(!SD_MBW_Stop(log->card)){
+            ok = 0;
+        }
+        log->streaming = 0;
+    }
+    return ok;
+}
+
+unsigned char LOG_ReadStart(
+    LOG_Reader_t* reader,
+    LOG_Log_t* log,
+    unsigned char* buf,
+    unsigned long seq
+)
+{
+    unsigned long lo = 0;
+    unsigned long hi;
+    unsigned long mid;
+    unsigned long off;
+    unsigned short used;
+
+    reader->log = log;
+    reader->buf = buf;
+    if(log->head == 0){
+        return 0;
+    }
+
+    // Find the last sector whose first sequence number is no greater than
+    // seq. The record's header is in that sector, if it exists at all
+    hi = log->head - 1;
+    while(lo < hi){
+        mid = hi - (hi - lo) / 2;
+        if(!LOG_Load(reader, mid)){
+            return 0;
+        }
+        if(reader->seq <= seq){
+            lo = mid;
+        }
+        else{
+            hi = mid - 1;
+        }
+    }
+    if(!LOG_Load(reader, lo)){
+        return 0;
+    }
+
+    // Skip the records before it
+    used = SD_Load16(&buf[12]);
+    while((reader->seq < seq) && (reader->off != LOG_NONE) &&
+          (reader->off + LOG_RECORD_HEADER <= used)){
+        off = reader->off + LOG_RECORD_HEADER +
+              SD_Load16(&buf[LOG_HEADER + reader->off]);
+        reader->off = (off < used) ? (unsigned short)off : used;
+        reader->seq++;
+    }
+
+    return 1;
+}
+
+unsigned char LOG_ReadNext(
+    LOG_Reader_t* reader,
+    unsigned char* data,
+    unsigned short maxLen,
+    unsigned short* len,
+    unsigned long* seq
+)
+{
+    unsigned char* buf = reader->buf;
+    unsigned short used = SD_Load16(&buf[12]);
+    unsigned short recLen;
+    unsigned short recCRC;
+    unsigned short crc;
+    unsigned short left;
+    unsigned short copied;
+    unsigned short cont;
+    unsigned short n;
+    unsigned char torn;
+    unsigned char byte;
+
+    while(1){
+        // Move on to the next sector once this one has no more headers
+        if((reader->off == LOG_NONE) ||
+           (reader->off + LOG_RECORD_HEADER > used)){
+            if(!LOG_Load(reader, reader->sector + 1)){
+                return 0;
+            }
+            used = SD_Load16(&buf[12]);
+            continue;
+        }
+
+        recLen = SD_Load16(&buf[LOG_HEADER + reader->off]);
+        recCRC = SD_Load16(&buf[LOG_HEADER + reader->off + 2]);
+        *seq = reader->seq;
+        reader->seq++;
+        reader->off += LOG_RECORD_HEADER;
+
+        crc = 0;
+        copied = 0;
+        left = recLen;
+        torn = 0;
+        while(left > 0){
+            if(reader->off >= used){
+                if(!LOG_Load(reader, reader->sector + 1)){
+                    return 0;
+                }
+                used = SD_Load16(&buf[12]);
+
+                // The sector must start with exactly the rest of the record.
+                // If it doesn't, the record was cut off and the log went on
+                // in a new sector after a reboot
+                cont = (reader->off != LOG_NONE) ? reader->off : used;
+                n = (left < LOG_PAYLOAD_BYTES) ? left : LOG_PAYLOAD_BYTES;
+                if(cont != n){
+                    torn = 1;
+                    break;
+                }
+                reader->off = 0;
+            }
+
+            n = used - reader->off;
+            if(n > left){
+                n = left;
+            }
+            left -= n;
+            while(n > 0){
+                byte = buf[LOG_HEADER + reader->off];
+                crc = SD_CRC16(crc, byte);
+                if(copied < maxLen){
+                    data[copied] = byte;
+                }
+                copied++;
+                reader->off++;
+                n--;
+            }
+        }
+
+        if(!torn && (crc == recCRC)){
+            *len = recLen;
+            return 1;
+        }
+    }
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Computes the CRC16 of a sector, leaving out the CRC itself
+ * @param buf Pointer to the sector
+ * @return The CRC
+ */
+static unsigned short LOG_SectorCRC(const unsigned char* buf){
+    unsigned short crc = 0;
+
+    for(unsigned short i = 0; i < 512; i++){
+        if((i != 14) && (i != 15)){
+            crc = SD_CRC16(crc, buf[i]);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Checks whether a sector was written by a log, whichever log it was
+ * @param buf Pointer to the sector
+ * @param sector Index of the sector in the region
+ * @return 1 if the sector is intact, 0 otherwise
+ */
+static unsigned char LOG_Intact(const unsigned char* buf, unsigned long sector){
+    unsigned short first = SD_Load16(&buf[10]);
+    unsigned short used = SD_Load16(&buf[12]);
+
+    if((SD_Load32(&buf[2]) != sector) || (used > LOG_PAYLOAD_BYTES) ||
+       ((first != LOG_NONE) && (first >= used))){
+        return 0;
+    }
+    return LOG_SectorCRC(buf) == SD_Load16(&buf[14]);
+}
+
+/**
+ * @brief Checks whether a sector belongs to a log
+ * @param log Pointer to the log. Its epoch isn't checked for sector 0, which
+ *        is where the epoch is learned from
+ * @param buf Pointer to the sector
+ * @param sector Index of the sector in the region
+ * @return 1 if the sector is valid, 0 otherwise
+ */
+static unsigned char LOG_Valid(
+    const LOG_Log_t* log,
+    const unsigned char* buf,
+    unsigned long sector
+)
+{
+    if((sector != 0) && (SD_Load16(&buf[0]) != log->epoch)){
+        return 0;
+    }
+    return LOG_Intact(buf, sector);
+}
+
+/**
+ * @brief Starts filling a new sector
+ * @param log Pointer to the log
+ */
+static void LOG_Begin(LOG_Log_t* log){
+    log->fill = 0;
+    log->firstOffset = LOG_NONE;
+    log->firstSeq = log->nextSeq;
+}
+
+/**
+ * @brief Completes the sector being filled and sends it as the next block of
+ *        the multiple block write, reopening the write if the card ended it.
+ *        The unused end of the payload is zeroed
+ * @param log Pointer to the log
+ * @return 1 if successful, 0 if the region is full or the card rejected it
+ */
+static unsigned char LOG_Send(LOG_Log_t* log){
+    unsigned char* buf = log->buf;
+
+    if(log->head >= log->numBlocks){
+        return 0;
+    }
+
+    // After the card rejected a sector, the write is reopened at that sector
+    // and the buffered sector is sent again
+    if(!log->streaming){
+        SD_MBW_Start(
+            log->card,
+            log->startBlock + log->head,
+            log->numBlocks - log->head
+        );
+        log->streaming = 1;
+    }
+
+    memset(&buf[LOG_HEADER + log->fill], 0, LOG_PAYLOAD_BYTES - log->fill);
+    SD_Store16(&buf[0], log->epoch);
+    SD_Store32(&buf[2], log->head);
+    SD_Store32(&buf[6], log->firstSeq);
+    SD_Store16(&buf[10], log->firstOffset);
+    SD_Store16(&buf[12], log->fill);
+    SD_Store16(&buf[14], LOG_SectorCRC(buf));
+    if(!SD_MBW_Send(log->card, buf)){
+        // The card ended the multiple block write when it rejected the sector
+        log->streaming = 0;
+        return 0;
+    }
+
+    log->head++;
+    LOG_Begin(log);
+    return 1;
+}
+
+/**
+ * @brief Reads a sector of the log into a reader's buffer and positions the
+ *        reader at the first record that starts in it
+ * @param reader Pointer to the reader
+ * @param sector Index of the sector in the region
+ * @return 1 if successful, 0 if the sector is past the head, couldn't be read
+ *         or isn't valid
+ */
+static unsigned char LOG_Load(LOG_Reader_t* reader, unsigned long sector){
+    LOG_Log_t* log = reader->log;
+    unsigned char* buf = reader->buf;
+
+    if((sector >= log->head) ||
+       !SD_SingleBlockRead(log->card, log->startBlock + sector, buf) ||
+       !LOG_Valid(log, buf, sector)){
+        return 0;
+    }
+
+    reader->sector = sector;
+    reader->seq = SD_Load32(&buf[6]);
+    reader->off = SD_Load16(&buf[10]);
+    return 1;
+}
\ No newline at end of file
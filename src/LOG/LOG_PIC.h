@@ -0,0 +1,193 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 23, 2026, 10:20 AM
+ *
+ * @defgroup LOG
+ * @brief Append-only, log-structured record store over a raw region of the
+ *        card. Variable-length records are packed back to back into sectors,
+ *        each with a 4 byte header (length and CRC16), and a record that
+ *        doesn't fit in the rest of a sector continues in the next one. Each
+ *        sector starts with a 16 byte header holding the log's epoch, the
+ *        sector's sequence number, the sequence number and offset of the
+ *        first record that starts in it, and a CRC16 of the whole sector.
+ *        Sectors are only ever written through one multiple block write that
+ *        stays open for as long as the log is, so a full sector costs one
+ *        SD_MBW_Send.
+ *
+ *        Sector n of the log is valid only if its CRC matches, it carries the
+ *        log's epoch and its sequence number is n. Since sectors are written
+ *        in order, the valid sectors form a prefix of the region, and the
+ *        head of the log is found on boot by binary search rather than by
+ *        reading every sector. Formatting the log bumps the epoch, so the
+ *        sectors of an older log are never taken for part of the new one
+ * @{
+ */
+
+#ifndef LOG_PIC_H
+#define LOG_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Bytes of each sector available for records and their headers */
+#define LOG_PAYLOAD_BYTES 496
+
+/** @brief Times LOG_Flush polls the card while it programs a sector before
+ *         giving up on it */
+#ifndef LOG_BUSY_POLLS
+#define LOG_BUSY_POLLS 100000UL
+#endif
+
+/********************************** Types ************************************/
+/** @brief A log, open for appending */
+typedef struct{
+    SDCard_t* card;            /**< Card holding the log */
+    unsigned long startBlock;  /**< First block of the region */
+    unsigned long numBlocks;   /**< Blocks in the region */
+    unsigned char* buf;        /**< 512 byte buffer for the sector being
+                                *   filled */
+    unsigned long head;        /**< Sectors written */
+    unsigned long nextSeq;     /**< Sequence number of the next record */
+    unsigned long firstSeq;    /**< Sequence number of the first record that
+                                *   starts in the buffered sector */
+    unsigned short firstOffset; /**< Offset of that record's header */
+    unsigned short fill;       /**< Bytes of the buffered sector's payload
+                                *   used so far */
+    unsigned short epoch;      /**< Epoch of the log */
+    unsigned char streaming;   /**< 1 while the multiple block write is open */
+}LOG_Log_t;
+
+/** @brief Position of a reader in a closed log */
+typedef struct{
+    LOG_Log_t* log;            /**< Log being read */
+    unsigned char* buf;        /**< 512 byte buffer for the sector being read */
+    unsigned long sector;      /**< Sector held in buf */
+    unsigned long seq;         /**< Sequence number of the next record header */
+    unsigned short off;        /**< Offset of the next record header */
+}LOG_Reader_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Starts a new, empty log in a region, discarding whatever log was
+ *        there. The whole region is read to find an epoch that no sector
+ *        in it carries yet. An empty sector carrying the new epoch is written
+ *        first, and the multiple block write stays open for appending
+ * @pre The card has been initialized using initSD
+ * @param log Pointer to the log
+ * @param card Pointer to the card
+ * @param startBlock First block of the region
+ * @param numBlocks Blocks in the region (at least 2)
+ * @param buf Pointer to a 512 byte buffer, owned by the log until it is closed
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char LOG_Format(
+    LOG_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char* buf
+);
+
+/**
+ * @brief Opens the log in a region for appending. The head is found by binary
+ *        search, and the multiple block write is reopened after the last
+ *        sector that was written. Records are appended to a fresh sector; the
+ *        unused end of the last sector stays unused. A record that was cut off
+ *        by a power failure is dropped
+ * @pre The card has been initialized using initSD
+ * @param log Pointer to the log
+ * @param card Pointer to the card
+ * @param startBlock First block of the region
+ * @param numBlocks Blocks in the region
+ * @param buf Pointer to a 512 byte buffer, owned by the log until it is closed
+ * @return 1 if successful, 0 if there is no log in the region (see
+ *         LOG_Format) or the card couldn't be read
+ */
+unsigned char LOG_Open(
+    LOG_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char* buf
+);
+
+/**
+ * @brief Appends a record. Full sectors are sent as they fill up; the rest of
+ *        the record stays in the buffer until more records fill the sector or
+ *        LOG_Flush is called
+ * @param log Pointer to the open log
+ * @param data Pointer to the record
+ * @param len Length of the record, in bytes
+ * @return 1 if successful, 0 if the region is full or the card rejected a
+ *         sector. A rejected sector is sent again, in a new multiple block
+ *         write, by the next append or flush. If it held the start of this
+ *         record, the record is dropped when reading
+ */
+unsigned char LOG_Append(
+    LOG_Log_t* log,
+    const unsigned char* data,
+    unsigned short len
+);
+
+/**
+ * @brief Sends the partly filled sector, if any, and waits for the card to
+ *        program it, so that every record appended so far survives a power
+ *        failure. The rest of the sector is left unused
+ * @param log Pointer to the open log
+ * @return 1 if successful, 0 if the sector was rejected or the card was
+ *         still busy after LOG_BUSY_POLLS polls
+ */
+unsigned char LOG_Flush(LOG_Log_t* log);
+
+/**
+ * @brief Flushes the log and stops its multiple block write
+ * @param log Pointer to the open log
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char LOG_Close(LOG_Log_t* log);
+
+/**
+ * @brief Positions a reader at a record. The sector holding the record's
+ *        header is found by binary search over the sectors' first sequence
+ *        numbers
+ * @pre The log has been closed using LOG_Close (or opened and closed again)
+ * @param reader Pointer to the reader
+ * @param log Pointer to the log
+ * @param buf Pointer to a 512 byte buffer, owned by the reader
+ * @param seq Sequence number of the first record to read. Records that no
+ *        longer exist are skipped
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char LOG_ReadStart(
+    LOG_Reader_t* reader,
+    LOG_Log_t* log,
+    unsigned char* buf,
+    unsigned long seq
+);
+
+/**
+ * @brief Reads the next record. Records that fail their CRC, or that were cut
+ *        off by a power failure, are skipped
+ * @param reader Pointer to the reader
+ * @param data Pointer to the array that will store the record
+ * @param maxLen Size of data. Longer records are truncated
+ * @param len Set to the full length of the record
+ * @param seq Set to the sequence number of the record
+ * @return 1 if a record was read, 0 at the end of the log
+ */
+unsigned char LOG_ReadNext(
+    LOG_Reader_t* reader,
+    unsigned char* data,
+    unsigned short maxLen,
+    unsigned short* len,
+    unsigned long* seq
+);
+
+/**
+ * @}
+ */
+
+#endif	/* LOG_PIC_H */
\ No newline at end of file
@@ -0,0 +1,227 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 20, 2026, 1:40 PM
+ *
+ * @ingroup MIRROR
+ */
+
+/********************************* Includes **********************************/
+#include "MIRROR_PIC.h"
+
+/************************ Private Function Prototypes ************************/
+static unsigned char MIRROR_Choose(MIRROR_Pair_t* pair);
+static unsigned char MIRROR_IsUsable(MIRROR_Pair_t* pair, unsigned char i);
+static void MIRROR_UpdateLatency(MIRROR_Pair_t* pair, unsigned char i);
+
+/***************************** Public Functions ******************************/
+void MIRROR_Init(MIRROR_Pair_t* pair, SDCard_t* cardA, SDCard_t* cardB){
+    pair->cards[0] = cardA;
+    pair->cards[1] = cardB;
+    pair->latency[0] = 0;
+    pair->latency[1] = 0;
+    pair->readCard = 0;
+    pair->mismatch = 0;
+    pair->failed = 0;
+}
+
+unsigned char MIRROR_SingleBlockWrite(
+    MIRROR_Pair_t* pair,
+    unsigned long block,
+    unsigned char* arr
+)
+{
+    unsigned char success = 0;
+
+    // Single block writes wait for the card to finish programming, so the
+    // two copies are written one after the other. Streams should use the
+    // MIRROR_MBW_* functions, which overlap them
+    for(unsigned char i = 0; i < 2; i++){
+        if(pair->failed & (1U << i)){
+            continue;
+        }
+        if(SD_SingleBlockWrite(pair->cards[i], block, arr)){
+            success = 1;
+        }
+        else{
+            pair->failed |= (1U << i);
+        }
+    }
+
+    return success;
+}
+
+unsigned char MIRROR_SingleBlockRead(
+    MIRROR_Pair_t* pair,
+    unsigned long block,
+    unsigned char* buf
+)
+{
+    unsigned char i = MIRROR_Choose(pair);
+
+    if(SD_SingleBlockRead(pair->cards[i], block, buf)){
+        MIRROR_UpdateLatency(pair, i);
+        return 1;
+    }
+
+    // Try the other copy
+    i ^= 1;
+    if(MIRROR_IsUsable(pair, i) &&
+       SD_SingleBlockRead(pair->cards[i], block, buf)){
+        MIRROR_UpdateLatency(pair, i);
+        return 1;
+    }
+
+    return 0;
+}
+
+void MIRROR_MBW_Start(
+    MIRROR_Pair_t* pair,
+    unsigned long startBlock,
+    unsigned long numBlocks
+)
+{
+    for(unsigned char i = 0; i < 2; i++){
+        if(!(pair->failed & (1U << i))){
+            SD_MBW_Start(pair->cards[i], startBlock, numBlocks);
+        }
+    }
+}
+
+unsigned char MIRROR_MBW_Send(MIRROR_Pair_t* pair, unsigned char* arrWrite){
+    unsigned char success = 0;
+
+    // SD_MBW_Send waits for the selected card alone to finish programming its
+    // previous block, so each card programs while the other is sent data. A
+    // card that rejects a block ends its write with CMD12 and would never
+    // answer another one, so it is left out from then on
+    for(unsigned char i = 0; i < 2; i++){
+        if(pair->failed & (1U << i)){
+            continue;
+        }
+        if(SD_MBW_Send(pair->cards[i], arrWrite)){
+            success = 1;
+        }
+        else{
+            pair->failed |= (1U << i);
+        }
+    }
+
+    return success;
+}
+
+unsigned char MIRROR_MBW_Stop(MIRROR_Pair_t* pair){
+    SDCard_t* card;
+    unsigned long numWritten;
+
+    // Failed cards are out of date, whether they failed during this write
+    // or before it
+    pair->mismatch = pair->failed;
+    for(unsigned char i = 0; i < 2; i++){
+        if(pair->failed & (1U << i)){
+            continue;
+        }
+        card = pair->cards[i];
+        if(!SD_MBW_Stop(card)){
+            pair->mismatch |= (1U << i);
+            pair->failed |= (1U << i);
+            continue;
+        }
+
+        // ACMD22 counts the blocks the card committed since its last
+        // WRITE_MULTIPLE_BLOCK command, which is exactly what MBW_numSent
+        // counts on the host side. Cards that can't answer are taken at
+        // their data response tokens
+        if(SD_GetNumWrBlocks(card, &numWritten) &&
+           (numWritten != card->write.MBW_numSent)){
+            pair->mismatch |= (1U << i);
+            pair->failed |= (1U << i);
+        }
+    }
+
+    return (pair->mismatch == 0) ? 1 : 0;
+}
+
+unsigned char MIRROR_MBR_Start(MIRROR_Pair_t* pair, unsigned long startBlock){
+    unsigned char i = MIRROR_Choose(pair);
+
+    if(!SD_MBR_Start(pair->cards[i], startBlock)){
+        i ^= 1;
+        if(!MIRROR_IsUsable(pair, i) ||
+           !SD_MBR_Start(pair->cards[i], startBlock)){
+            return 0;
+        }
+    }
+    pair->readCard = i;
+
+    return 1;
+}
+
+void MIRROR_MBR_Receive(MIRROR_Pair_t* pair, unsigned char* bufReceive){
+    SD_MBR_Receive(pair->cards[pair->readCard], bufReceive);
+    MIRROR_UpdateLatency(pair, pair->readCard);
+}
+
+void MIRROR_MBR_Stop(MIRROR_Pair_t* pair){
+    SD_MBR_Stop(pair->cards[pair->readCard]);
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Picks the card a read should be sent to. A failed card is never
+ *        picked while the other one hasn't failed. Otherwise, a card that is
+ *        still busy (e.g. programming a mirrored write) is avoided if the
+ *        other one is idle, and then the card with the lower average access
+ *        time wins
+ * @param pair Pointer to the pair
+ * @return Index of the chosen card
+ */
+static unsigned char MIRROR_Choose(MIRROR_Pair_t* pair){
+    unsigned char busy0;
+    unsigned char busy1;
+
+    if(!MIRROR_IsUsable(pair, 0)){
+        return 1;
+    }
+    if(!MIRROR_IsUsable(pair, 1)){
+        return 0;
+    }
+
+    busy0 = SD_IsBusy(pair->cards[0]);
+    busy1 = SD_IsBusy(pair->cards[1]);
+
+    if(busy0 != busy1){
+        return busy0 ? 1 : 0;
+    }
+
+    return (pair->latency[1] < pair->latency[0]) ? 1 : 0;
+}
+
+/**
+ * @brief Checks whether a card may serve reads. A failed card only may if
+ *        both have failed, since neither copy is then known to be good
+ * @param pair Pointer to the pair
+ * @param i Index of the card
+ * @return 1 if the card may serve reads, 0 otherwise
+ */
+static unsigned char MIRROR_IsUsable(MIRROR_Pair_t* pair, unsigned char i){
+    return (!(pair->failed & (1U << i)) || (pair->failed == 0x03)) ? 1 : 0;
+}
+
+/**
+ * @brief Folds the access time of the last block read from a card into its
+ *        running average, weighting the new sample by 1/8
+ * @param pair Pointer to the pair
+ * @param i Index of the card
+ */
+static void MIRROR_UpdateLatency(MIRROR_Pair_t* pair, unsigned char i){
+    unsigned short sample = pair->cards[i]->read.waitBytes;
+
+    // Cap outliers, such as a read that had to wait for an erase
+    if(sample > 0x1FFF){
+        sample = 0x1FFF;
+    }
+    pair->latency[i] = (pair->latency[i] - (pair->latency[i] >> 3)) +
+                       (sample >> 3);
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 20, 2026, 1:40 PM
+ *
+ * @defgroup MIRROR
+ * @brief Mirrored (RAID-1 style) block device over two cards sharing the SPI
+ *        bus. Every block is written to both cards as it is produced: each
+ *        multiple block write is opened on both cards, and each block is
+ *        streamed to one card while the other programs the block it was just
+ *        sent, so neither card's busy time holds up the bus. After a session,
+ *        SEND_NUM_WR_BLOCKS (ACMD22) confirms that both cards committed every
+ *        block. Reads go to whichever card is idle, or to the card with the
+ *        lower running average access time. A card that rejects a block or
+ *        fails verification is marked as failed: writes carry on with the
+ *        other card alone and reads are only served by the other card, until
+ *        the application has rebuilt the failed copy and cleared the mark
+ * @{
+ */
+
+#ifndef MIRROR_PIC_H
+#define MIRROR_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Types ************************************/
+/** @brief Mirrored pair of cards */
+typedef struct{
+    SDCard_t* cards[2];        /**< The two cards */
+    unsigned short latency[2]; /**< Running average of each card's read
+                                *   access time, in polled bytes */
+    unsigned char readCard;    /**< Card serving the open multiple block read */
+    unsigned char mismatch;    /**< Bit i set: card i did not commit every block
+                                *   of the last multiple block write */
+    unsigned char failed;      /**< Bit i set: card i's copy is out of date and
+                                *   it is left out of reads and writes */
+}MIRROR_Pair_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Sets up a mirrored pair
+ * @pre Both cards have been initialized using initSD
+ * @param pair Pointer to the pair
+ * @param cardA Pointer to the first card
+ * @param cardB Pointer to the second card
+ */
+void MIRROR_Init(MIRROR_Pair_t* pair, SDCard_t* cardA, SDCard_t* cardB);
+
+/**
+ * @brief Writes a block to both cards, one after the other. A card that
+ *        fails the write is marked as failed
+ * @param pair Pointer to the pair
+ * @param block Block number to write to
+ * @param arr Pointer to the array of bytes to be written
+ * @return 1 if at least one card that hadn't failed succeeded, 0 otherwise
+ */
+unsigned char MIRROR_SingleBlockWrite(
+    MIRROR_Pair_t* pair,
+    unsigned long block,
+    unsigned char* arr
+);
+
+/**
+ * @brief Reads a block from the preferred card, falling back to the other
+ *        card if the read fails. Failed cards are only used if both have
+ *        failed
+ * @param pair Pointer to the pair
+ * @param block Block number to read
+ * @param buf Pointer to the array of bytes that data read is to be stored
+ * @return 1 if successful, 0 if neither card could be read
+ */
+unsigned char MIRROR_SingleBlockRead(
+    MIRROR_Pair_t* pair,
+    unsigned long block,
+    unsigned char* buf
+);
+
+/**
+ * @brief Starts a multiple block write on both cards, or on the one that
+ *        hasn't failed
+ * @param pair Pointer to the pair
+ * @param startBlock Block number to begin the write
+ * @param numBlocks Number of blocks to be written to
+ */
+void MIRROR_MBW_Start(
+    MIRROR_Pair_t* pair,
+    unsigned long startBlock,
+    unsigned long numBlocks
+);
+
+/**
+ * @brief Sends a block to both cards as part of a multiple block write. A
+ *        card that rejects the block has its write ended by the card, so it
+ *        is marked as failed and left out of the rest of the write
+ * @pre The multiple block write was started using MIRROR_MBW_Start
+ * @param pair Pointer to the pair
+ * @param arrWrite Pointer to the array of bytes to be written
+ * @return 1 if at least one card accepted the block, 0 otherwise
+ */
+unsigned char MIRROR_MBW_Send(MIRROR_Pair_t* pair, unsigned char* arrWrite);
+
+/**
+ * @brief Stops the multiple block write on both cards, then checks with
+ *        SEND_NUM_WR_BLOCKS (ACMD22) that each card committed every block it
+ *        accepted since its last WRITE_MULTIPLE_BLOCK command. Cards that
+ *        didn't, and cards that have failed, are flagged in the pair's
+ *        mismatch field. Cards that didn't are also marked as failed
+ * @pre The multiple block write was started using MIRROR_MBW_Start
+ * @param pair Pointer to the pair
+ * @return 1 if both copies are consistent, 0 otherwise
+ */
+unsigned char MIRROR_MBW_Stop(MIRROR_Pair_t* pair);
+
+/**
+ * @brief Starts a multiple block read on the preferred card. Failed cards
+ *        are only used if both have failed
+ * @param pair Pointer to the pair
+ * @param startBlock Block number to begin the read
+ * @return 1 if successful, 0 if neither card could start the read
+ */
+unsigned char MIRROR_MBR_Start(MIRROR_Pair_t* pair, unsigned long startBlock);
+
+/**
+ * @brief Receives the next block of a multiple block read
+ * @pre The multiple block read was started using MIRROR_MBR_Start
+ * @param pair Pointer to the pair
+ * @param bufReceive Pointer to the array that will store the data
+ */
+void MIRROR_MBR_Receive(MIRROR_Pair_t* pair, unsigned char* bufReceive);
+
+/**
+ * @brief Stops a multiple block read
+ * @pre The multiple block read was started using MIRROR_MBR_Start
+ * @param pair Pointer to the pair
+ */
+void MIRROR_MBR_Stop(MIRROR_Pair_t* pair);
+
+/**
+ * @}
+ */
+
+#endif	/* MIRROR_PIC_H */
\ No newline at end of file
@@ -0,0 +1,555 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 22, 2026, 4:10 PM
+ *
+ * @ingroup PART
+ */
+
+/********************************* Includes **********************************/
+#include <string.h>
+#include "PART_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Offset of the partition table in the MBR */
+#define PART_MBR_TABLE 446
+
+/** @brief MBR partition type of a protective MBR, which points to a GPT */
+#define PART_PROTECTIVE 0xEE
+
+/**
+ * @brief Bytes at the start of sector 0 needed to tell a volume boot sector
+ *        from an MBR, up to the end of the FAT32 file system type
+ */
+#define PART_BOOT_BYTES 90
+
+/***************************** Private Variables *****************************/
+/**
+ * @brief GPT type GUID of basic data partitions (FAT, exFAT and NTFS), as
+ *        stored on the card
+ */
+static const unsigned char basicData[16] = {
+    0xA2, 0xA0, 0xD0, 0xEB, 0xE5, 0xB9, 0x33, 0x44,
+    0x87, 0xC0, 0x68, 0xB6, 0xB7, 0x26, 0x99, 0xC7
+};
+
+/************************ Private Function Prototypes ************************/
+static unsigned char PART_IsTable(
+    const SDCard_t* card,
+    const unsigned char* boot,
+    const unsigned char* table
+);
+static unsigned long PART_Align(const SDCard_t* card, unsigned long block);
+static void PART_SetEntry(
+    unsigned char* p,
+    unsigned char type,
+    unsigned long start,
+    unsigned long numBlocks
+);
+static unsigned char PART_Scan(
+    SDCard_t* card,
+    unsigned char index,
+    unsigned char type,
+    PART_Partition_t* part
+);
+static unsigned char PART_ScanGPT(
+    SDCard_t* card,
+    unsigned char index,
+    unsigned char type,
+    PART_Partition_t* part
+);
+
+/***************************** Public Functions ******************************/
+unsigned char PART_Find(
+    SDCard_t* card,
+    unsigned char index,
+    PART_Partition_t* part
+)
+{
+    return PART_Scan(card, index, 0, part);
+}
+
+unsigned char PART_FindType(
+    SDCard_t* card,
+    unsigned char type,
+    PART_Partition_t* part
+)
+{
+    return PART_Scan(card, 0, type, part);
+}
+
+unsigned char PART_AddRaw(
+    SDCard_t* card,
+    unsigned long numBlocks,
+    unsigned char* buf,
+    PART_Partition_t* part
+)
+{
+    unsigned char* table = &buf[PART_MBR_TABLE];
+    unsigned char unused = 4;
+    unsigned long end = 1;
+    unsigned long start;
+    unsigned long e;
+    unsigned char* p;
+
+    if(!SD_SingleBlockRead(card, 0, buf) ||
+       (buf[510] != 0x55) || (buf[511] != 0xAA) ||
+       !PART_IsTable(card, buf, table)){
+        return 0;
+    }
+
+    // The new partition goes after the last one, in the first unused entry
+    for(unsigned char i = 0; i < 4; i++){
+        p = &table[16 * i];
+        if(p[4] == PART_PROTECTIVE){
+            return 0;
+        }
+        if((p[4] == 0) || (SD_Load32(&p[12]) == 0)){
+            if(unused == 4){
+                unused = i;
+            }
+            continue;
+        }
+        e = SD_Load32(&p[8]) + SD_Load32(&p[12]);
+        if(e > end){
+            end = e;
+        }
+    }
+    if(unused == 4){
+        return 0;
+    }
+
+    start = PART_Align(card, end);
+    if(start >= card->numBlocks){
+        return 0;
+    }
+    if(numBlocks == 0){
+        numBlocks = card->numBlocks - start;
+    }
+    else if(numBlocks > card->numBlocks - start){
+        return 0;
+    }
+
+    PART_SetEntry(&table[16 * unused], PART_TYPE_RAW, start, numBlocks);
+    if(!SD_SingleBlockWrite(card, 0, buf)){
+        return 0;
+    }
+
+    part->card = card;
+    part->start = start;
+    part->numBlocks = numBlocks;
+    part->next = 0;
+    part->type = PART_TYPE_RAW;
+
+    return 1;
+}
+
+unsigned char PART_Create(
+    SDCard_t* card,
+    unsigned char fsType,
+    unsigned long rawBlocks,
+    PART_Partition_t* part
+)
+{
+    unsigned char table[64];
+    unsigned char signature[2] = {0x55, 0xAA};
+    SD_IOVec_t iov[3];
+    unsigned long fsStart = PART_Align(card, 1);
+    unsigned long rawStart;
+
+    if((rawBlocks == 0) || (rawBlocks >= card->numBlocks)){
+        return 0;
+    }
+
+    // The file system partition starts one allocation unit in. The raw
+    // partition starts on the last boundary that leaves it rawBlocks, so it
+    // may come out a little larger
+    rawStart = ((card->numBlocks - rawBlocks) / fsStart) * fsStart;
+    if(rawStart <= fsStart){
+        return 0;
+    }
+
+    memset(table, 0, sizeof(table));
+    PART_SetEntry(&table[0], fsType, fsStart, rawStart - fsStart);
+    PART_SetEntry(&table[16], PART_TYPE_RAW, rawStart,
+                  card->numBlocks - rawStart);
+
+    // The boot code and disk signature are written as zeros
+    iov[0].base = NULL;
+    iov[0].len = PART_MBR_TABLE;
+    iov[1].base = table;
+    iov[1].len = sizeof(table);
+    iov[2].base = signature;
+    iov[2].len = sizeof(signature);
+    if(!SD_SingleBlockWriteV(card, 0, iov, 3)){
+        return 0;
+    }
+
+    // Wipe the file system partition's first block, so that a PC offers to
+    // format it instead of mounting an old volume with the wrong size
+    if(!SD_SingleBlockWriteV(card, fsStart, NULL, 0)){
+        return 0;
+    }
+
+    part->card = card;
+    part->start = rawStart;
+    part->numBlocks = card->numBlocks - rawStart;
+    part->next = 0;
+    part->type = PART_TYPE_RAW;
+
+    return 1;
+}
+
+unsigned char PART_SingleBlockWrite(
+    PART_Partition_t* part,
+    unsigned long block,
+    unsigned char* arr
+)
+{
+    if(block >= part->numBlocks){
+        return 0;
+    }
+
+    return SD_SingleBlockWrite(part->card, part->start + block, arr);
+}
+
+unsigned char PART_SingleBlockRead(
+    PART_Partition_t* part,
+    unsigned long block,
+    unsigned char* buf
+)
+{
+    if(block >= part->numBlocks){
+        return 0;
+    }
+
+    return SD_SingleBlockRead(part->card, part->start + block, buf);
+}
+
+unsigned char PART_MBW_Start(
+    PART_Partition_t* part,
+    unsigned long startBlock,
+    unsigned long numBlocks
+)
+{
+    if(startBlock >= part->numBlocks){
+        return 0;
+    }
+
+    // Don't let the card pre-erase blocks of the next partition
+    if(numBlocks > part->numBlocks - startBlock){
+        numBlocks = part->numBlocks - startBlock;
+    }
+    SD_MBW_Start(part->card, part->start + startBlock, numBlocks);
+    part->next = startBlock;
+
+    return 1;
+}
+
+unsigned char PART_MBW_Send(PART_Partition_t* part, unsigned char* arrWrite){
+    if(part->next >= part->numBlocks){
+        return 0;
+    }
+    part->next++;
+
+    return SD_MBW_Send(part->card, arrWrite);
+}
+
+unsigned char PART_MBW_Stop(PART_Partition_t* part){
+    return SD_MBW_Stop(part->card);
+}
+
+unsigned char PART_MBR_Start(PART_Partition_t* part, unsigned long startBlock){
+    if(startBlock >= part->numBlocks){
+        return 0;
+    }
+    if(!SD_MBR_Start(part->card, part->start + startBlock)){
+        return 0;
+    }
+    part->next = startBlock;
+
+    return 1;
+}
+
+unsigned char PART_MBR_Receive(
+    PART_Partition_t* part,
+    unsigned char* bufReceive
+)
+{
+    if(part->next >= part->numBlocks){
+        return 0;
+    }
+    part->next++;
+    SD_MBR_Receive(part->card, bufReceive);
+
+    return 1;
+}
+
+void PART_MBR_Stop(PART_Partition_t* part){
+    SD_MBR_Stop(part->card);
+}
+
+unsigned char PART_EraseBlocks(
+    PART_Partition_t* part,
+    unsigned long firstBlock,
+    unsigned long lastBlock
+)
+{
+    if((firstBlock > lastBlock) || (lastBlock >= part->numBlocks)){
+        return 0;
+    }
+
+    return SD_EraseBlocks(
+        part->card,
+        part->start + firstBlock,
+        part->start + lastBlock
+    );
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Checks whether sector 0, with its 0x55AA signature, holds a
+ *        partition table rather than being the boot sector of a volume that
+ *        takes up the whole card (i.e. a card with no partition table). A FAT
+ *        or exFAT boot sector starts with a jump and names its file system
+ * @param card Pointer to the card
+ * @param boot Pointer to the first PART_BOOT_BYTES bytes of the sector
+ * @param table Pointer to the four partition entries
+ * @return 1 if the sector isn't a volume boot sector, every entry's status
+ *         byte is valid and every partition fits on the card, 0 otherwise
+ */
+static unsigned char PART_IsTable(
+    const SDCard_t* card,
+    const unsigned char* boot,
+    const unsigned char* table
+)
+{
+    const unsigned char* p;
+    unsigned long start;
+
+    if(((boot[0] == 0xEB) || (boot[0] == 0xE9)) &&
+       ((memcmp(&boot[3], "EXFAT   ", 8) == 0) ||
+        (memcmp(&boot[54], "FAT", 3) == 0) ||
+        (memcmp(&boot[82], "FAT", 3) == 0))){
+        return 0;
+    }
+
+    // A protective MBR's entry may cover more than the card, and the GPT
+    // describes the real partitions anyway
+    for(unsigned char i = 0; i < 4; i++){
+        p = &table[16 * i];
+        if((p[0] != 0x00) && (p[0] != 0x80)){
+            return 0;
+        }
+        if((p[4] == 0) || (p[4] == PART_PROTECTIVE)){
+            continue;
+        }
+        start = SD_Load32(&p[8]);
+        if((start > card->numBlocks) ||
+           (SD_Load32(&p[12]) > card->numBlocks - start)){
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Rounds a block number up to the next allocation unit boundary, so
+ *        that a partition's writes line up with the card's erase units
+ * @param card Pointer to the card
+ * @param block Block number
+ * @return The first boundary at or after block
+ */
+static unsigned long PART_Align(const SDCard_t* card, unsigned long block){
+    unsigned long align = (card->auBlocks != 0) ?
+                          card->auBlocks : PART_ALIGN_BLOCKS;
+
+    return ((block + align - 1) / align) * align;
+}
+
+/**
+ * @brief Fills in an MBR partition entry. The CHS fields are set to the
+ *        values that tell readers to use the LBA fields
+ * @param p Pointer to the entry
+ * @param type Partition type
+ * @param start First block of the partition
+ * @param numBlocks Blocks in the partition
+ */
+static void PART_SetEntry(
+    unsigned char* p,
+    unsigned char type,
+    unsigned long start,
+    unsigned long numBlocks
+)
+{
+    p[0] = 0x00;
+    p[1] = 0xFE;
+    p[2] = 0xFF;
+    p[3] = 0xFF;
+    p[4] = type;
+    p[5] = 0xFE;
+    p[6] = 0xFF;
+    p[7] = 0xFF;
+    SD_Store32(&p[8], start);
+    SD_Store32(&p[12], numBlocks);
+}
+
+/**
+ * @brief Looks through the partition table for a partition, either by index
+ *        or by type. Only the start of the MBR and its table are read
+ * @param card Pointer to the card
+ * @param index Index among the non-empty entries, if type is 0
+ * @param type Partition type to look for, or 0 to look by index
+ * @param part Pointer to the partition, filled in if found
+ * @return 1 if found, 0 otherwise
+ */
+static unsigned char PART_Scan(
+    SDCard_t* card,
+    unsigned char index,
+    unsigned char type,
+    PART_Partition_t* part
+)
+{
+    unsigned char boot[PART_BOOT_BYTES];
+    unsigned char table[64];
+    unsigned char signature[2];
+    SD_IOVec_t iov[4];
+    unsigned char n = 0;
+    unsigned char* p;
+
+    iov[0].base = boot;
+    iov[0].len = sizeof(boot);
+    iov[1].base = NULL;
+    iov[1].len = PART_MBR_TABLE - PART_BOOT_BYTES;
+    iov[2].base = table;
+    iov[2].len = sizeof(table);
+    iov[3].base = signature;
+    iov[3].len = sizeof(signature);
+    if(!SD_SingleBlockReadV(card, 0, iov, 4) ||
+       (signature[0] != 0x55) || (signature[1] != 0xAA) ||
+       !PART_IsTable(card, boot, table)){
+        return 0;
+    }
+
+    for(unsigned char i = 0; i < 4; i++){
+        if(table[16 * i + 4] == PART_PROTECTIVE){
+            return PART_ScanGPT(card, index, type, part);
+        }
+    }
+
+    for(unsigned char i = 0; i < 4; i++){
+        p = &table[16 * i];
+        if((p[4] == 0) || (SD_Load32(&p[12]) == 0)){
+            continue;
+        }
+        if((type != 0) ? (p[4] == type) : (n++ == index)){
+            part->card = card;
+            part->start = SD_Load32(&p[8]);
+            part->numBlocks = SD_Load32(&p[12]);
+            part->next = 0;
+            part->type = p[4];
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Looks through a GPT for a partition. Each entry is read on its own,
+ *        picking out just its type GUID and block range. Basic data
+ *        partitions are reported as PART_TYPE_EXFAT and others as
+ *        PART_TYPE_GPT_OTHER. Partitions beyond 2 TB are skipped
+ * @param card Pointer to the card
+ * @param index Index among the non-empty entries, if type is 0
+ * @param type Partition type to look for, or 0 to look by index
+ * @param part Pointer to the partition, filled in if found
+ * @return 1 if found, 0 otherwise
+ */
+static unsigned char PART_ScanGPT(
+    SDCard_t* card,
+    unsigned char index,
+    unsigned char type,
+    PART_Partition_t* part
+)
+{
+    unsigned char signature[8];
+    unsigned char fields[16];
+    unsigned char guid[16];
+    unsigned char range[16];
+    SD_IOVec_t iov[4];
+    unsigned char k;
+    unsigned char n = 0;
+    unsigned char entryType;
+    unsigned long entryBlock;
+    unsigned long numEntries;
+    unsigned long entrySize;
+    unsigned long offset;
+
+    // Header: entry array location, number of entries and entry size
+    iov[0].base = signature;
+    iov[0].len = sizeof(signature);
+    iov[1].base = NULL;
+    iov[1].len = 64;
+    iov[2].base = fields;
+    iov[2].len = sizeof(fields);
+    if(!SD_SingleBlockReadV(card, 1, iov, 3) ||
+       (memcmp(signature, "EFI PART", 8) != 0) ||
+       (SD_Load32(&fields[4]) != 0)){
+        return 0;
+    }
+    entryBlock = SD_Load32(&fields[0]);
+    numEntries = SD_Load32(&fields[8]);
+    entrySize = SD_Load32(&fields[12]);
+    if((entrySize < 128) || (entrySize > 512) || (512 % entrySize != 0)){
+        return 0;
+    }
+
+    for(unsigned long i = 0; i < numEntries; i++){
+        offset = i * entrySize;
+        k = 0;
+        if(offset % 512 != 0){
+            iov[k].base = NULL;
+            iov[k].len = (unsigned short)(offset % 512);
+            k++;
+        }
+        iov[k].base = guid;
+        iov[k].len = sizeof(guid);
+        k++;
+        iov[k].base = NULL;
+        iov[k].len = 16;
+        k++;
+        iov[k].base = range;
+        iov[k].len = sizeof(range);
+        k++;
+        if(!SD_SingleBlockReadV(card, entryBlock + offset / 512, iov, k)){
+            return 0;
+        }
+
+        // Unused entries have an all-zero type GUID
+        k = 0;
+        while((k < 16) && (guid[k] == 0)){
+            k++;
+        }
+        if((k == 16) || (SD_Load32(&range[4]) != 0) ||
+           (SD_Load32(&range[12]) != 0) ||
+           (SD_Load32(&range[8]) < SD_Load32(&range[0]))){
+            continue;
+        }
+
+        entryType = (memcmp(guid, basicData, 16) == 0) ?
+                    PART_TYPE_EXFAT : PART_TYPE_GPT_OTHER;
+        if((type != 0) ? (entryType == type) : (n++ == index)){
+            part->card = card;
+            part->start = SD_Load32(&range[0]);
+            part->numBlocks = SD_Load32(&range[8]) - part->start + 1;
+            part->next = 0;
+            part->type = entryType;
+            return 1;
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 22, 2026, 4:10 PM
+ *
+ * @defgroup PART
+ * @brief Partition tables (MBR and GPT). Partitions are found by index or by
+ *        type and exposed as block devices whose block numbers are relative
+ *        to the start of the partition, so raw logging code can be given a
+ *        partition of its own instead of absolute blocks that overwrite the
+ *        partition table. Transfers outside the partition are refused. A raw
+ *        partition (type PART_TYPE_RAW) can be added to free space after the
+ *        existing partitions, or a new table can be written with a file
+ *        system partition followed by a raw one. Tables are read a few bytes
+ *        at a time, so no 512 byte buffer is needed except to modify one
+ * @{
+ */
+
+#ifndef PART_PIC_H
+#define PART_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief MBR partition type: FAT32 (LBA) */
+#define PART_TYPE_FAT32     0x0C
+/** @brief MBR partition type: exFAT or NTFS. Also used for GPT basic data */
+#define PART_TYPE_EXFAT     0x07
+/** @brief MBR partition type: non-file system data, used for raw logs */
+#define PART_TYPE_RAW       0xDA
+/** @brief GPT partition of any type other than basic data */
+#define PART_TYPE_GPT_OTHER 0xEE
+
+/** @brief Blocks that partitions are aligned to if the AU size is unknown */
+#define PART_ALIGN_BLOCKS 8192UL
+
+/********************************** Types ************************************/
+/** @brief A partition, used as a block device */
+typedef struct{
+    SDCard_t* card;          /**< Card holding the partition */
+    unsigned long start;     /**< First block of the partition on the card */
+    unsigned long numBlocks; /**< Blocks in the partition */
+    unsigned long next;      /**< Partition block of the next block of the open
+                              *   multiple block transfer */
+    unsigned char type;      /**< Partition type (see PART_TYPE_*) */
+}PART_Partition_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Finds a partition by its position in the partition table. Empty
+ *        entries are skipped. A protective MBR is followed to the GPT
+ * @pre The card has been initialized using initSD
+ * @param card Pointer to the card
+ * @param index Index of the partition among the non-empty entries
+ * @param part Pointer to the partition, filled in if found
+ * @return 1 if found, 0 otherwise
+ */
+unsigned char PART_Find(
+    SDCard_t* card,
+    unsigned char index,
+    PART_Partition_t* part
+);
+
+/**
+ * @brief Finds the first partition of a type
+ * @pre The card has been initialized using initSD
+ * @param card Pointer to the card
+ * @param type Partition type (see PART_TYPE_*)
+ * @param part Pointer to the partition, filled in if found
+ * @return 1 if found, 0 otherwise
+ */
+unsigned char PART_FindType(
+    SDCard_t* card,
+    unsigned char type,
+    PART_Partition_t* part
+);
+
+/**
+ * @brief Adds a raw partition to an MBR, in the free space after the last
+ *        partition. The MBR's boot code and other entries are kept
+ * @pre The card has been initialized using initSD
+ * @param card Pointer to the card
+ * @param numBlocks Size of the raw partition, in blocks. 0 takes all of the
+ *        free space
+ * @param buf Pointer to a 512 byte scratch buffer
+ * @param part Pointer to the new partition, filled in if successful
+ * @return 1 if successful, 0 if the card has no MBR (or has a GPT, or is a
+ *         volume without a partition table), the MBR has no unused entry or
+ *         describes a partition past the end of the card, or there isn't
+ *         enough free space
+ */
+unsigned char PART_AddRaw(
+    SDCard_t* card,
+    unsigned long numBlocks,
+    unsigned char* buf,
+    PART_Partition_t* part
+);
+
+/**
+ * @brief Writes a new MBR with two partitions: a file system partition at the
+ *        start of the card, then a raw partition at the end. Both start on an
+ *        allocation unit boundary. The file system partition still has to be
+ *        formatted (e.g. on a PC) before it can be mounted. Anything the
+ *        previous partition table described is lost
+ * @pre The card has been initialized using initSD
+ * @param card Pointer to the card
+ * @param fsType Type of the file system partition, e.g. PART_TYPE_FAT32
+ * @param rawBlocks Size of the raw partition, in blocks
+ * @param part Pointer to the raw partition, filled in if successful
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char PART_Create(
+    SDCard_t* card,
+    unsigned char fsType,
+    unsigned long rawBlocks,
+    PART_Partition_t* part
+);
+
+/**
+ * @brief Writes a block of a partition
+ * @param part Pointer to the partition
+ * @param block Block number within the partition
+ * @param arr Pointer to the array of bytes to be written
+ * @return 1 if successful, 0 if the block is outside the partition or the
+ *         write failed
+ */
+unsigned char PART_SingleBlockWrite(
+    PART_Partition_t* part,
+    unsigned long block,
+    unsigned char* arr
+);
+
+/**
+ * @brief Reads a block of a partition
+ * @param part Pointer to the partition
+ * @param block Block number within the partition
+ * @param buf Pointer to the array of bytes that data read is to be stored
+ * @return 1 if successful, 0 if the block is outside the partition or the
+ *         read failed
+ */
+unsigned char PART_SingleBlockRead(
+    PART_Partition_t* part,
+    unsigned long block,
+    unsigned char* buf
+);
+
+/**
+ * @brief Starts a multiple block write within a partition
+ * @param part Pointer to the partition
+ * @param startBlock Block number within the partition to begin the write
+ * @param numBlocks Number of blocks to be written to, for pre-erasing. The
+ *        announced range is cut short at the end of the partition
+ * @return 1 if successful, 0 if startBlock is outside the partition
+ */
+unsigned char PART_MBW_Start(
+    PART_Partition_t* part,
+    unsigned long startBlock,
+    unsigned long numBlocks
+);
+
+/**
+ * @brief Sends the next block of a multiple block write
+ * @pre The multiple block write was started using PART_MBW_Start
+ * @param part Pointer to the partition
+ * @param arrWrite Pointer to the array of bytes to be written
+ * @return 1 if successful, 0 if the end of the partition has been reached or
+ *         the card rejected the block
+ */
+unsigned char PART_MBW_Send(PART_Partition_t* part, unsigned char* arrWrite);
+
+/**
+ * @brief Stops a multiple block write
+ * @pre The multiple block write was started using PART_MBW_Start
+ * @param part Pointer to the partition
+ * @return 1 if successful, 0 otherwise (see SD_MBW_Stop)
+ */
+unsigned char PART_MBW_Stop(PART_Partition_t* part);
+
+/**
+ * @brief Starts a multiple block read within a partition
+ * @param part Pointer to the partition
+ * @param startBlock Block number within the partition to begin the read
+ * @return 1 if successful, 0 if startBlock is outside the partition or the
+ *         read could not be started
+ */
+unsigned char PART_MBR_Start(PART_Partition_t* part, unsigned long startBlock);
+
+/**
+ * @brief Receives the next block of a multiple block read
+ * @pre The multiple block read was started using PART_MBR_Start
+ * @param part Pointer to the partition
+ * @param bufReceive Pointer to the array that will store the data
+ * @return 1 if successful, 0 if the end of the partition has been reached
+ */
+unsigned char PART_MBR_Receive(
+    PART_Partition_t* part,
+    unsigned char* bufReceive
+);
+
+/**
+ * @brief Stops a multiple block read
+ * @pre The multiple block read was started using PART_MBR_Start
+ * @param part Pointer to the partition
+ */
+void PART_MBR_Stop(PART_Partition_t* part);
+
+/**
+ * @brief Erases blocks of a partition (see SD_EraseBlocks)
+ * @param part Pointer to the partition
+ * @param firstBlock First block within the partition to be erased
+ * @param lastBlock Last block within the partition to be erased
+ * @return 1 if the card accepted the erase, 0 if the range isn't inside the
+ *         partition or the card rejected it
+ */
+unsigned char PART_EraseBlocks(
+    PART_Partition_t* part,
+    unsigned long firstBlock,
+    unsigned long lastBlock
+);
+
+/**
+ * @}
+ */
+
+#endif	/* PART_PIC_H */
\ No newline at end of file
@@ -0,0 +1,198 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 19, 2026, 10:05 AM
+ *
+ * @ingroup PREERASE
+ */
+
+/********************************* Includes **********************************/
+#include "PREERASE_PIC.h"
+
+/************************ Private Function Prototypes ************************/
+static unsigned long PREERASE_AlignUp(
+    const PREERASE_Window_t* w,
+    unsigned long block
+);
+
+/***************************** Public Functions ******************************/
+void PREERASE_Init(
+    PREERASE_Window_t* w,
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock,
+    unsigned long numAhead
+)
+{
+    unsigned long n;
+
+    w->card = card;
+
+    // Erase whole allocation units, which is what the card erases fastest
+    w->unitBlocks = w->card->auBlocks;
+    if(w->unitBlocks == 0){
+        w->unitBlocks = PREERASE_DEFAULT_UNIT_BLOCKS;
+    }
+    if(w->unitBlocks < w->card->eraseGroup){
+        w->unitBlocks = w->card->eraseGroup;
+    }
+
+    n = (numAhead + w->unitBlocks - 1) / w->unitBlocks;
+    if(n > PREERASE_MAX_UNITS){
+        n = PREERASE_MAX_UNITS;
+    }
+    if(n == 0){
+        n = 1;
+    }
+    w->numUnits = (unsigned char)n;
+
+    w->regionLast = lastBlock;
+    w->headBlock = firstBlock;
+    w->baseBlock = PREERASE_AlignUp(w, firstBlock);
+    w->erasedMap = 0;
+    w->erasing = 0;
+}
+
+void PREERASE_SetHead(PREERASE_Window_t* w, unsigned long block){
+    unsigned long newBase = PREERASE_AlignUp(w, block);
+    unsigned long shift;
+
+    if((block < w->headBlock) || (newBase < w->baseBlock)){
+        // The log went backwards, so the window now covers different blocks
+        w->erasedMap = 0;
+    }
+    else{
+        // Drop the units the head has moved into or past
+        shift = (newBase - w->baseBlock) / w->unitBlocks;
+        if(shift >= 32){
+            w->erasedMap = 0;
+        }
+        else{
+            w->erasedMap >>= shift;
+        }
+    }
+
+    w->headBlock = block;
+    w->baseBlock = newBase;
+}
+
+unsigned char PREERASE_Service(PREERASE_Window_t* w){
+    unsigned long firstBlock;
+    unsigned long lastBlock;
+    unsigned long idx;
+    unsigned char i;
+
+    // Record the erase issued by a previous call once the card is done with
+    // it. If the head has passed the unit in the meantime, it no longer
+    // matters
+    if(w->erasing){
+        if(SD_IsBusy(w->card)){
+            return 1;
+        }
+        w->erasing = 0;
+        if(w->erasingBlock >= w->baseBlock){
+            idx = (w->erasingBlock - w->baseBlock) / w->unitBlocks;
+            if(idx < w->numUnits){
+                w->erasedMap |= (1UL << idx);
+            }
+        }
+    }
+
+    // Find the first unit in the window that still needs erasing
+    for(i = 0; i < w->numUnits; i++){
+        if(!(w->erasedMap & (1UL << i))){
+            break;
+        }
+    }
+    if(i == w->numUnits){
+        return 0;
+    }
+
+    firstBlock = w->baseBlock + i * w->unitBlocks;
+    if(firstBlock > w->regionLast){
+        return 0;
+    }
+    lastBlock = firstBlock + w->unitBlocks - 1;
+    if(lastBlock > w->regionLast){
+        // A partial unit at the end of the region can only be erased on cards
+        // that erase single blocks
+        if(w->card->eraseGroup > 1){
+            return 0;
+        }
+        lastBlock = w->regionLast;
+    }
+
+    // Leave the card alone if it is busy with something else
+    if(SD_IsBusy(w->card)){
+        return 0;
+    }
+    if(!SD_EraseBlocks(w->card, firstBlock, lastBlock)){
+        return 0;
+    }
+    w->erasing = 1;
+    w->erasingBlock = firstBlock;
+
+    return 1;
+}
+
+unsigned char PREERASE_IsErased(
+    const PREERASE_Window_t* w,
+    unsigned long firstBlock,
+    unsigned long numBlocks
+)
+{
+    unsigned long first;
+    unsigned long last;
+
+    if(numBlocks == 0){
+        return 1;
+    }
+    if(firstBlock < w->baseBlock){
+        return 0;
+    }
+
+    first = (firstBlock - w->baseBlock) / w->unitBlocks;
+    last = (firstBlock + numBlocks - 1 - w->baseBlock) / w->unitBlocks;
+    if(last >= w->numUnits){
+        return 0;
+    }
+    while(first <= last){
+        if(!(w->erasedMap & (1UL << first))){
+            return 0;
+        }
+        first++;
+    }
+
+    return 1;
+}
+
+void PREERASE_MBW_Start(
+    PREERASE_Window_t* w,
+    unsigned long startBlock,
+    unsigned long numBlocks
+)
+{
+    if(PREERASE_IsErased(w, startBlock, numBlocks)){
+        w->card->write.preErase = 0;
+    }
+    SD_MBW_Start(w->card, startBlock, numBlocks);
+    w->card->write.preErase = 1;
+
+    PREERASE_SetHead(w, startBlock + numBlocks);
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Rounds a block number up to the next erase unit boundary
+ * @param w Pointer to the window
+ * @param block Block number
+ * @return The first block of the first unit that starts at or after block
+ */
+static unsigned long PREERASE_AlignUp(
+    const PREERASE_Window_t* w,
+    unsigned long block
+)
+{
+    return ((block + w->unitBlocks - 1) / w->unitBlocks) * w->unitBlocks;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 19, 2026, 10:05 AM
+ *
+ * @defgroup PREERASE
+ * @brief Background pre-erase of the blocks a log is about to write. While
+ *        the bus is idle, the allocation units (AUs) ahead of the log's write
+ *        head are erased one at a time, and a bitmap records which ones are
+ *        known to be erased. Multiple block writes over erased AUs then skip
+ *        the ACMD23 pre-erase, which moves the erase cost out of the write
+ *        path
+ * @{
+ */
+
+#ifndef PREERASE_PIC_H
+#define PREERASE_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Erase unit used when the card does not report its AU size */
+#ifndef PREERASE_DEFAULT_UNIT_BLOCKS
+#define PREERASE_DEFAULT_UNIT_BLOCKS 128UL
+#endif
+
+/** @brief Maximum number of erase units tracked ahead of the write head */
+#define PREERASE_MAX_UNITS 32
+
+/********************************** Types ************************************/
+/** @brief State of the erased window ahead of a log's write head */
+typedef struct{
+    SDCard_t* card;             /**< Card the log is written to        */
+    unsigned long regionLast;   /**< Last block of the log region      */
+    unsigned long unitBlocks;   /**< Erase unit size, in blocks        */
+    unsigned long headBlock;    /**< Next block the log will write     */
+    unsigned long baseBlock;    /**< First block of the unit at bit 0  */
+    unsigned long erasedMap;    /**< Bit i set: unit i is erased       */
+    unsigned long erasingBlock; /**< First block of the unit erasing   */
+    unsigned char numUnits;     /**< Window size, in erase units       */
+    unsigned char erasing;      /**< 1 while a background erase runs   */
+}PREERASE_Window_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Configures the log region and how far ahead of the write head to
+ *        keep erased. The write head starts at firstBlock, and nothing is
+ *        assumed to be erased
+ * @param w Pointer to the window to be configured
+ * @param card Pointer to the card the log is written to
+ * @param firstBlock First block of the log region
+ * @param lastBlock Last block of the log region
+ * @param numAhead Number of blocks ahead of the write head to keep erased.
+ *        Rounded up to whole erase units, and limited to PREERASE_MAX_UNITS
+ *        of them
+ */
+void PREERASE_Init(
+    PREERASE_Window_t* w,
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock,
+    unsigned long numAhead
+);
+
+/**
+ * @brief Tells the service where the log will write next. Erase units that
+ *        the head has moved into or past are no longer considered erased. If
+ *        the head moves backwards (e.g. the log wrapped around), everything
+ *        is considered unerased
+ * @param w Pointer to the window
+ * @param block Block number of the next block the log will write
+ */
+void PREERASE_SetHead(PREERASE_Window_t* w, unsigned long block);
+
+/**
+ * @brief Does one step of background work. If an erase issued by a previous
+ *        call has finished, it is recorded in the bitmap. Otherwise, if the
+ *        card is idle, the erase of the next unerased unit in the window is
+ *        issued. Returns without waiting for the card in either case
+ * @pre The SPI module has been started using sd_start, and no multiple block
+ *      transfer is open
+ * @param w Pointer to the window
+ * @return 1 if a background erase is still in progress, 0 otherwise
+ */
+unsigned char PREERASE_Service(PREERASE_Window_t* w);
+
+/**
+ * @brief Checks whether every block in a range is known to be erased
+ * @param w Pointer to the window
+ * @param firstBlock First block of the range
+ * @param numBlocks Number of blocks in the range
+ * @return 1 if the whole range is known to be erased, 0 otherwise
+ */
+unsigned char PREERASE_IsErased(
+    const PREERASE_Window_t* w,
+    unsigned long firstBlock,
+    unsigned long numBlocks
+);
+
+/**
+ * @brief Starts a multiple block write for the log. The ACMD23 pre-erase is
+ *        skipped if the whole range is known to be erased, and the write
+ *        head is moved to the end of the range
+ * @param w Pointer to the window
+ * @param startBlock Block number in SD card memory to begin the write
+ * @param numBlocks Number of blocks to be written to
+ */
+void PREERASE_MBW_Start(
+    PREERASE_Window_t* w,
+    unsigned long startBlock,
+    unsigned long numBlocks
+);
+
+/**
+ * @}
+ */
+
+#endif	/* PREERASE_PIC_H */
\ No newline at end of file
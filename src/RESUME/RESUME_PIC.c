@@ -0,0 +1,362 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 19, 2026, 3:30 PM
+ *
+ * @ingroup RESUME
+ */
+
+/********************************* Includes **********************************/
+#include "RESUME_PIC.h"
+
+/******************************** Constants **********************************/
+/** @brief Marks a valid descriptor record */
+static const unsigned short RESUME_MAGIC = 0x5E55;
+
+/************************ Private Function Prototypes ************************/
+static unsigned char RESUME_Checkpoint(
+    RESUME_Writer_t* rw,
+    unsigned char open
+);
+static unsigned short RESUME_RecordCRC(const RESUME_Record_t* rec);
+static unsigned char RESUME_Save(RESUME_Writer_t* rw);
+static unsigned char RESUME_Load(
+    RESUME_Writer_t* rw,
+    unsigned char slot,
+    RESUME_Record_t* rec
+);
+static unsigned char RESUME_LoadNewest(RESUME_Writer_t* rw);
+#ifdef RESUME_USE_EEPROM
+static void RESUME_EEPROMWrite(unsigned short addr, unsigned char val);
+static unsigned char RESUME_EEPROMRead(unsigned short addr);
+#endif
+
+/***************************** Public Functions ******************************/
+void RESUME_Init(
+    RESUME_Writer_t* rw,
+    SDCard_t* card,
+    unsigned long descAddr
+)
+{
+    rw->card = card;
+    rw->descAddr = descAddr;
+}
+
+unsigned char RESUME_Start(
+    RESUME_Writer_t* rw,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned long firstSeq
+)
+{
+    // The generation has to carry on from the saved descriptors, or after a
+    // reboot the new descriptor could lose to an older one in the other slot
+    if(!RESUME_LoadNewest(rw)){
+        rw->record.generation = 0;
+    }
+
+    rw->record.session.startBlock = startBlock;
+    rw->record.session.numBlocks = numBlocks;
+    rw->record.session.committed = 0;
+    rw->record.session.producerSeq = firstSeq - 1;
+    rw->record.open = 1;
+    rw->lastSeq = rw->record.session.producerSeq;
+    rw->numSinceCheckpoint = 0;
+
+    // The descriptor has to exist before the first block is written, or a
+    // power failure before the first checkpoint would go unnoticed
+    if(!RESUME_Save(rw)){
+        return 0;
+    }
+
+    SD_MBW_Start(rw->card, startBlock, numBlocks);
+
+    return 1;
+}
+
+unsigned char RESUME_Send(
+    RESUME_Writer_t* rw,
+    unsigned char* arrWrite,
+    unsigned long seq
+)
+{
+    if(!SD_MBW_Send(rw->card, arrWrite)){
+        // The card has ended the write. Checkpointing finds out how many
+        // blocks it committed and reopens the write right after them
+        rw->numSinceCheckpoint = 0;
+        RESUME_Checkpoint(rw, 1);
+        return 0;
+    }
+    rw->lastSeq = seq;
+
+    rw->numSinceCheckpoint++;
+    if(rw->numSinceCheckpoint >= RESUME_CHECKPOINT_BLOCKS){
+        rw->numSinceCheckpoint = 0;
+        return RESUME_Checkpoint(rw, 1);
+    }
+
+    return 1;
+}
+
+unsigned char RESUME_Stop(RESUME_Writer_t* rw){
+    unsigned char success = RESUME_Checkpoint(rw, 0);
+
+    // The write was suspended by the checkpoint and isn't going to be
+    // resumed, so end the session here
+    rw->card->write.MBW_flag_first = 1;
+
+    return success;
+}
+
+unsigned char RESUME_Recover(
+    RESUME_Writer_t* rw,
+    RESUME_Session_t* session
+)
+{
+    if(!RESUME_LoadNewest(rw)){
+        return 0;
+    }
+
+    *session = rw->record.session;
+    rw->lastSeq = rw->record.session.producerSeq;
+    rw->numSinceCheckpoint = 0;
+
+    return rw->record.open;
+}
+
+void RESUME_Continue(RESUME_Writer_t* rw){
+    RESUME_Session_t* session = &rw->record.session;
+    unsigned long remaining = 1;
+
+    if(session->committed < session->numBlocks){
+        remaining = session->numBlocks - session->committed;
+    }
+    SD_MBW_Start(
+        rw->card,
+        session->startBlock + session->committed,
+        remaining
+    );
+}
+
+unsigned long RESUME_NextSeq(const RESUME_Writer_t* rw){
+    return rw->record.session.producerSeq + 1;
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Suspends the write, confirms the number of blocks the card
+ *        committed using SEND_NUM_WR_BLOCKS (ACMD22), and saves the
+ *        descriptor. If the session stays open, the write is then resumed
+ *        right after the last committed block
+ * @param rw Pointer to the writer
+ * @param open 1 to resume the write afterwards, 0 to close the session
+ * @return 1 if every block sent was committed and the descriptor was saved,
+ *         0 otherwise
+ */
+static unsigned char RESUME_Checkpoint(
+    RESUME_Writer_t* rw,
+    unsigned char open
+)
+{
+    SDWriteState_t savedWrite;
+    unsigned long numSent;
+    unsigned long numWritten;
+    unsigned char success;
+
+    SD_MBW_Suspend(rw->card);
+
+    // Blocks sent since the last checkpoint are exactly the blocks sent since
+    // the last WRITE_MULTIPLE_BLOCK command, which is what ACMD22 reports on.
+    // Cards without ACMD22 are taken at their data response tokens
+    numSent = rw->card->write.MBW_numSent;
+    if(!SD_GetNumWrBlocks(rw->card, &numWritten) || (numWritten > numSent)){
+        numWritten = numSent;
+    }
+    success = (numWritten == numSent) ? 1 : 0;
+
+    // Sequence numbers go up by one per block, so those of blocks that
+    // weren't committed can be subtracted off
+    rw->record.session.committed += numWritten;
+    rw->record.session.producerSeq = rw->lastSeq - (numSent - numWritten);
+    rw->lastSeq = rw->record.session.producerSeq;
+    rw->record.open = open;
+
+    // Saving the descriptor uses a single block write, which would otherwise
+    // overwrite the bookkeeping the multiple block write resumes from
+    savedWrite = rw->card->write;
+    if(!RESUME_Save(rw)){
+        success = 0;
+    }
+    rw->card->write = savedWrite;
+
+    if(open){
+        // Continue right after the last committed block
+        if(rw->record.session.committed == 0){
+            rw->card->write.MBW_flag_first = 1;
+        }
+        else{
+            rw->card->write.MBW_flag_first = 0;
+            rw->card->write.lastBlockWritten =
+                rw->record.session.startBlock +
+                rw->record.session.committed - 1;
+        }
+        SD_MBW_Resume(rw->card);
+    }
+
+    return success;
+}
+
+/**
+ * @brief Computes the CRC16 of a descriptor record, excluding its crc field
+ * @param rec Pointer to the record
+ * @return The CRC16
+ */
+static unsigned short RESUME_RecordCRC(const RESUME_Record_t* rec){
+    const unsigned char* bytes = (const unsigned char*)rec;
+    unsigned short crc = 0;
+
+    for(unsigned char i = 0; i < sizeof(RESUME_Record_t) - sizeof(rec->crc); i++){
+        crc = SD_CRC16(crc, bytes[i]);
+    }
+
+    return crc;
+}
+
+/**
+ * @brief Saves the descriptor into the slot after the one last used
+ * @param rw Pointer to the writer
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char RESUME_Save(RESUME_Writer_t* rw){
+    rw->record.magic = RESUME_MAGIC;
+    rw->record.generation++;
+    rw->record.crc = RESUME_RecordCRC(&rw->record);
+
+#ifdef RESUME_USE_EEPROM
+    const unsigned char* bytes = (const unsigned char*)&rw->record;
+    unsigned short addr = (unsigned short)rw->descAddr +
+                          (rw->record.generation & 1) * sizeof(RESUME_Record_t);
+    for(unsigned char i = 0; i < sizeof(RESUME_Record_t); i++){
+        RESUME_EEPROMWrite(addr + i, bytes[i]);
+    }
+    return 1;
+#else
+    // The rest of the block is padded with zeros, so no sector buffer is
+    // needed
+    SD_IOVec_t iov;
+    iov.base = (const unsigned char*)&rw->record;
+    iov.len = sizeof(RESUME_Record_t);
+    return SD_SingleBlockWriteV(
+        rw->card,
+        rw->descAddr + (rw->record.generation & 1),
+        &iov,
+        1
+    );
+#endif
+}
+
+/**
+ * @brief Loads and validates the descriptor in a slot
+ * @param rw Pointer to the writer
+ * @param slot The slot to load (0 or 1)
+ * @param rec Pointer to where the record is to be stored
+ * @return 1 if the slot holds a valid record, 0 otherwise
+ */
+static unsigned char RESUME_Load(
+    RESUME_Writer_t* rw,
+    unsigned char slot,
+    RESUME_Record_t* rec
+)
+{
+#ifdef RESUME_USE_EEPROM
+    unsigned char* bytes = (unsigned char*)rec;
+    unsigned short addr = (unsigned short)rw->descAddr +
+                          slot * sizeof(RESUME_Record_t);
+    for(unsigned char i = 0; i < sizeof(RESUME_Record_t); i++){
+        bytes[i] = RESUME_EEPROMRead(addr + i);
+    }
+#else
+    // Only the record at the start of the block is kept
+    SD_IOVec_t iov;
+    iov.base = (const unsigned char*)rec;
+    iov.len = sizeof(RESUME_Record_t);
+    if(!SD_SingleBlockReadV(rw->card, rw->descAddr + slot, &iov, 1)){
+        return 0;
+    }
+#endif
+
+    return ((rec->magic == RESUME_MAGIC) &&
+            (rec->crc == RESUME_RecordCRC(rec))) ? 1 : 0;
+}
+
+/**
+ * @brief Loads the newest valid descriptor into the writer's record. A torn
+ *        save only ever damages the slot being written, so at least one of
+ *        them is valid once a session has been started
+ * @param rw Pointer to the writer
+ * @return 1 if either slot holds a valid record, 0 otherwise
+ */
+static unsigned char RESUME_LoadNewest(RESUME_Writer_t* rw){
+    RESUME_Record_t other;
+    unsigned char validA;
+    unsigned char validB;
+
+    validA = RESUME_Load(rw, 0, &rw->record);
+    validB = RESUME_Load(rw, 1, &other);
+
+    if(validB &&
+       (!validA || ((long)(other.generation - rw->record.generation) > 0))){
+        rw->record = other;
+    }
+    else if(!validA){
+        return 0;
+    }
+
+    return 1;
+}
+
+#ifdef RESUME_USE_EEPROM
+/**
+ * @brief Writes a byte to the data EEPROM and waits for the write to finish.
+ *        See section 7 in the PIC18F4620 datasheet for the unlock sequence
+ * @param addr EEPROM address
+ * @param val The byte to be written
+ */
+static void RESUME_EEPROMWrite(unsigned short addr, unsigned char val){
+    unsigned char gie = INTCONbits.GIE;
+
+    EEADRH = (unsigned char)(addr >> 8);
+    EEADR = (unsigned char)addr;
+    EEDATA = val;
+    EECON1bits.EEPGD = 0; // Access data EEPROM
+    EECON1bits.CFGS = 0;
+    EECON1bits.WREN = 1;
+
+    // The unlock sequence must not be interrupted
+    INTCONbits.GIE = 0;
+    EECON2 = 0x55;
+    EECON2 = 0xAA;
+    EECON1bits.WR = 1;
+    INTCONbits.GIE = gie;
+
+    while(EECON1bits.WR){
+        continue;
+    }
+    EECON1bits.WREN = 0;
+}
+
+/**
+ * @brief Reads a byte from the data EEPROM
+ * @param addr EEPROM address
+ * @return The byte read
+ */
+static unsigned char RESUME_EEPROMRead(unsigned short addr){
+    EEADRH = (unsigned char)(addr >> 8);
+    EEADR = (unsigned char)addr;
+    EECON1bits.EEPGD = 0; // Access data EEPROM
+    EECON1bits.CFGS = 0;
+    EECON1bits.RD = 1;
+    return EEDATA;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,164 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 19, 2026, 3:30 PM
+ *
+ * @defgroup RESUME
+ * @brief Power-fail resume of multiple block writes. The session descriptor
+ *        (start block, block count, blocks committed and the producer's
+ *        sequence number) is persisted at regular checkpoints. At each
+ *        checkpoint, the write is suspended and SEND_NUM_WR_BLOCKS (ACMD22)
+ *        confirms how many blocks the card committed before the descriptor
+ *        is saved. The card forgets that count when it loses power, so after
+ *        a reboot the saved descriptor is used directly: appending continues
+ *        at the first block after the last checkpoint, and the producer
+ *        resends everything after the saved sequence number. No sectors need
+ *        to be scanned.
+ *
+ *        The descriptor is saved to alternating slots so that a power failure
+ *        while saving it never loses the previous one. By default the slots
+ *        are two reserved blocks on the card. Define RESUME_USE_EEPROM to use
+ *        the data EEPROM instead. Each writer keeps its own state, so
+ *        sessions on several cards can run side by side
+ * @{
+ */
+
+#ifndef RESUME_PIC_H
+#define RESUME_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Number of blocks written between checkpoints */
+#ifndef RESUME_CHECKPOINT_BLOCKS
+#define RESUME_CHECKPOINT_BLOCKS 128
+#endif
+
+/********************************** Types ************************************/
+/** @brief Multiple block write session descriptor */
+typedef struct{
+    unsigned long startBlock;  /**< First block of the session */
+    unsigned long numBlocks;   /**< Blocks announced for the session */
+    unsigned long committed;   /**< Blocks committed as of the last checkpoint */
+    unsigned long producerSeq; /**< Sequence number of the last committed block */
+}RESUME_Session_t;
+
+/** @brief Descriptor as it is saved */
+typedef struct{
+    unsigned short magic;     /**< Marks a valid record */
+    unsigned long generation; /**< Incremented every save; picks the slot */
+    RESUME_Session_t session; /**< The session descriptor */
+    unsigned char open;       /**< 1 while the session is in progress */
+    unsigned short crc;       /**< CRC16 of all of the above */
+}RESUME_Record_t;
+
+/** @brief State of a resumable multiple block write */
+typedef struct{
+    SDCard_t* card;           /**< Card the session writes to */
+    unsigned long descAddr;   /**< First descriptor block, or EEPROM address
+                               *   of the first slot (RESUME_USE_EEPROM) */
+    RESUME_Record_t record;   /**< Descriptor of the current session */
+    unsigned long lastSeq;    /**< Sequence number of the last block sent */
+    unsigned short numSinceCheckpoint; /**< Blocks sent since checkpoint */
+}RESUME_Writer_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Sets the card that sessions are written to and where the descriptor
+ *        is saved
+ * @param rw Pointer to the writer to be set up
+ * @param card Pointer to the card
+ * @param descAddr Block number of the first of the two reserved blocks that
+ *        hold the descriptor. If RESUME_USE_EEPROM is defined, the EEPROM
+ *        address of the first of the two slots instead
+ */
+void RESUME_Init(
+    RESUME_Writer_t* rw,
+    SDCard_t* card,
+    unsigned long descAddr
+);
+
+/**
+ * @brief Saves a new session descriptor and starts a multiple block write.
+ *        The saved descriptors are read first so that the new one supersedes
+ *        them, whether or not RESUME_Recover was called
+ * @pre The SPI module has been started using sd_start
+ * @param rw Pointer to the writer
+ * @param startBlock Block number in SD card memory to begin the write
+ * @param numBlocks Number of blocks to be written to
+ * @param firstSeq Sequence number of the first block the producer will send.
+ *        Sequence numbers must increase by one per block
+ * @return 1 if successful, 0 if the descriptor couldn't be saved
+ */
+unsigned char RESUME_Start(
+    RESUME_Writer_t* rw,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned long firstSeq
+);
+
+/**
+ * @brief Sends a block as part of the session, checkpointing every
+ *        RESUME_CHECKPOINT_BLOCKS blocks
+ * @pre The session was opened using RESUME_Start or RESUME_Continue
+ * @param rw Pointer to the writer
+ * @param arrWrite Pointer to the array of bytes to be written
+ * @param seq The producer's sequence number for this block
+ * @return 1 if successful. 0 if the block was rejected or a checkpoint found
+ *         fewer blocks committed than sent. In that case a checkpoint is
+ *         taken, the write is reopened after the last committed block, and
+ *         the producer must resend from RESUME_NextSeq
+ */
+unsigned char RESUME_Send(
+    RESUME_Writer_t* rw,
+    unsigned char* arrWrite,
+    unsigned long seq
+);
+
+/**
+ * @brief Stops the session and saves the final descriptor, marking the
+ *        session as closed
+ * @pre The session was opened using RESUME_Start or RESUME_Continue
+ * @param rw Pointer to the writer
+ * @return 1 if every block sent was committed and the descriptor was saved,
+ *         0 otherwise
+ */
+unsigned char RESUME_Stop(RESUME_Writer_t* rw);
+
+/**
+ * @brief Loads the newest valid descriptor. Meant to be called after initSD
+ *        when the device boots
+ * @pre The SPI module has been started using sd_start
+ * @param rw Pointer to the writer
+ * @param session Pointer to where the descriptor is to be copied
+ * @return 1 if the descriptor belongs to a session that was still open (i.e.
+ *         it was interrupted), 0 if there is nothing to resume
+ */
+unsigned char RESUME_Recover(
+    RESUME_Writer_t* rw,
+    RESUME_Session_t* session
+);
+
+/**
+ * @brief Reopens the session loaded by RESUME_Recover. The write continues
+ *        at the first block that was not committed, with the pre-erase count
+ *        set to the blocks still outstanding
+ * @pre RESUME_Recover returned 1
+ * @param rw Pointer to the writer
+ */
+void RESUME_Continue(RESUME_Writer_t* rw);
+
+/**
+ * @brief Gets the sequence number of the next block the producer has to send
+ * @param rw Pointer to the writer
+ * @return The sequence number following the last committed block
+ */
+unsigned long RESUME_NextSeq(const RESUME_Writer_t* rw);
+
+/**
+ * @}
+ */
+
+#endif	/* RESUME_PIC_H */
\ No newline at end of file
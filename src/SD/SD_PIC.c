@@ -30,6 +30,7 @@ const unsigned char CMD33 = 33;
 const unsigned char CMD38 = 38;
 const unsigned char CMD55 = 55;
 const unsigned char CMD58 = 58;
+const unsigned char ACMD13 = 13;
 const unsigned char ACMD22 = 22;
 const unsigned char ACMD23 = 23;
 const unsigned char ACMD41 = 41;
@@ -39,9 +40,60 @@ const unsigned char R1_ILLEGAL_COMMAND = 4;
 const unsigned char START_BLOCK = 0xFE;
 const unsigned char START_BLOCK_TOKEN = 0xFC;
 const unsigned char STOP_TRAN = 0xFD;
+const unsigned long ERASE_ARG_ERASE = 0x00000000;
+const unsigned long ERASE_ARG_DISCARD = 0x00000001;
 
-/***************************** Public Variables ******************************/
-SDCard_t SDCard = {0};
+/** @brief CRC16 (polynomial 0x1021) of each nibble value */
+static const unsigned short CRC16_TABLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/** @brief Allocation unit sizes in blocks, indexed by the AU_SIZE field */
+static const unsigned long AU_BLOCKS[16] = {
+    0, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 24576, 32768,
+    49152, 65536, 131072
+};
+
+/************************ Private Function Prototypes ************************/
+static unsigned long SD_BlockToAddress(SDCard_t* card, unsigned long block);
+static void SD_MBW_Open(
+    SDCard_t* card,
+    unsigned long block,
+    unsigned long numBlocks
+);
+static void SD_SingleBlockWriteBegin(SDCard_t* card, unsigned long block);
+static unsigned char SD_SingleBlockWriteEnd(SDCard_t* card, unsigned long block);
+static void SD_MBW_SendBegin(SDCard_t* card);
+static unsigned char SD_MBW_SendEnd(SDCard_t* card);
+static unsigned char SD_SingleBlockReadBegin(SDCard_t* card, unsigned long block);
+static void SD_SingleBlockReadEnd(SDCard_t* card, unsigned long block);
+static unsigned char SD_MBR_ReceiveBegin(SDCard_t* card);
+static void SD_MBR_ReceiveEnd(SDCard_t* card);
+static void SD_WriteFragments(
+    SDCard_t* card,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+);
+static void SD_SendROM(SDCard_t* card, const unsigned char* src, unsigned short len);
+static void SD_SendGenerated(SDCard_t* card, SD_FillGen_t* gen);
+static void SD_SendData(SDCard_t* card, unsigned char byte);
+static unsigned char SD_ReadBackCRC(
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long numBlocks,
+    unsigned short crc
+);
+static unsigned char SD_Erase(
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock,
+    unsigned long arg
+);
+static void SD_ReadFragments(
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+);
 
 /***************************** Public Functions ******************************/
 void SD_SendDummyBytes(unsigned char numBytes){   
@@ -52,8 +104,8 @@ void SD_SendDummyBytes(unsigned char numBytes){
     }
 }
 
-unsigned char SD_Command(unsigned char cmd, unsigned long arg){   
-    CS_SD = 0; // Select the SD card
+unsigned char SD_Command(SDCard_t* card, unsigned char cmd, unsigned long arg){   
+    sd_select(card); // Select the SD card
     
     // Poll card until the it is no longer busy. Sending these clocks also
     // ensures the internal state machine of the flash controller will make any
@@ -89,138 +141,185 @@ unsigned char SD_Command(unsigned char cmd, unsigned long arg){
         n++;
     }while((n < 8) && (response == 0xFF));
     
-    CS_SD = 1; // Deselect SD Card
+    sd_deselect(card); // Deselect SD Card
 
     return response;
 }
 
-unsigned char SD_ACMD(unsigned char cmd, unsigned long arg){    
+unsigned char SD_ACMD(SDCard_t* card, unsigned char cmd, unsigned long arg){    
     // All ACMD are preceeded by CMD55, which is a "heads up" to the SD Card
     // that it is about to receive an ACMD
-    SD_Command(CMD55, 0);
-    return SD_Command(cmd, arg);
+    SD_Command(card, CMD55, 0);
+    return SD_Command(card, cmd, arg);
 }
 
-unsigned char SD_SingleBlockWrite(unsigned long block, unsigned char* arr){   
-    // If the SD card is SDHC/SDXC, then it uses the block addressing format
-    // that was passed into this function. If the card is SDSC, then it uses
-    // byte addressing, thus the address passed into the function has to be
-    // converted to bytes
-    if(SDCard.Type == TYPE_SDSC){
-        // Multiply by 512 to convert a block address to a byte address
-        block <<= 9;
+unsigned short SD_SendStatus(SDCard_t* card){
+    unsigned char r1 = SD_Command(card, CMD13, 0);
+    
+    // Read back the second byte of the R2 response
+    sd_select(card); // Select card
+    unsigned char r2 = spiReceive();
+    sd_deselect(card); // Deselect card
+    
+    return ((unsigned short)r1 << 8) | r2;
+}
+
+unsigned char SD_GetNumWrBlocks(SDCard_t* card, unsigned long* numBlocks){
+    if(SD_ACMD(card, ACMD22, 0) != R1_READY_STATE){
+        return 0;
     }
     
-    // Send CMD24 (WRITE_BLOCK) and wait for card ready response
-    while(SD_Command(CMD24, block) != R1_READY_STATE);
+    // The count is sent as a 4 byte data block, MSB first
+    sd_select(card); // Select card
+    while(spiReceive() != START_BLOCK){    continue;   }
+    *numBlocks = (unsigned long)spiReceive() << 24;
+    *numBlocks |= (unsigned long)spiReceive() << 16;
+    *numBlocks |= (unsigned long)spiReceive() << 8;
+    *numBlocks |= (unsigned long)spiReceive();
+    spiReceive(); // Ignore CRC
+    spiReceive(); // Ignore CRC
+    sd_deselect(card); // Deselect card
     
-    // Send WRITE_BLOCK Start Block token
-    CS_SD = 0; // Select card
-    spiSend(START_BLOCK);
+    return 1;
+}
+
+unsigned short SD_CRC16(unsigned short crc, unsigned char byte){
+    // Process the byte a nibble at a time, which keeps the table small
+    crc = (crc << 4) ^ CRC16_TABLE[(crc >> 12) ^ (byte >> 4)];
+    crc = (crc << 4) ^ CRC16_TABLE[(crc >> 12) ^ (byte & 0x0F)];
+    return crc;
+}
+
+unsigned short SD_Load16(const unsigned char* p){
+    return (unsigned short)p[0] | ((unsigned short)p[1] << 8);
+}
+
+unsigned long SD_Load32(const unsigned char* p){
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+           ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+void SD_Store16(unsigned char* p, unsigned short value){
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+}
+
+void SD_Store32(unsigned char* p, unsigned long value){
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+unsigned char SD_SingleBlockWrite(
+    SDCard_t* card,
+    unsigned long block,
+    unsigned char* arr
+)
+{
+    SD_SingleBlockWriteBegin(card, block);
     
     // Transfer the array
     for(unsigned short i = 0; i < 512; i++){
-        spiTransfer(arr[i]);
+        SD_SendData(card, arr[i]);
     }
     
-    // Stuff bits for data block CRC
-    SD_SendDummyBytes(2);
-    
-    // Check data response token to see if write was valid
-    unsigned char response = (spiReceive() >> 1) & 0x0F;
-    CS_SD = 1; // Deselect card
-    switch(response){
-        case 0b10:
-            // Data accepted. Save the address of the last block written 
-            // just in case this needs to be referred to later in the user
-            // code
-            SDCard.write.lastBlockWritten = block;
-            
-            // Wait until card is done programming
-            while(spiReceive() == 0){  continue;   }
-            return 1;
-        case 0b101:
-            // CRC error
-            return 0;
-        case 0b110:
-            // Write error
-            return 0;
-        default:
-            return 0;
-    }
+    return SD_SingleBlockWriteEnd(card, block);
 }
 
-void SD_MBW_Start(unsigned long startBlock, unsigned long numBlocks){   
-    // If the SD card is SDHC/SDXC, then it uses the block addressing format
-    // that was passed into this function. If the card is SDSC, then it uses
-    // byte addressing, thus the address passed into the function has to be
-    // converted to bytes
-    if(SDCard.Type == TYPE_SDSC){
-        // Multiply by 512 to convert a block address to a byte address
-        startBlock <<= 9;
-    }
-    
-    // Specify the number of blocks to be pre-erased
-    SD_ACMD(ACMD23, numBlocks);
-    
-    // Send CMD25 (WRITE_MULTIPLE_BLOCK) and wait for card ready response
-    while(SD_Command(CMD25, startBlock) != R1_READY_STATE);
+unsigned char SD_SingleBlockWriteV(
+    SDCard_t* card,
+    unsigned long block,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+)
+{
+    SD_SingleBlockWriteBegin(card, block);
+    SD_WriteFragments(card, iov, iovcnt);
+    return SD_SingleBlockWriteEnd(card, block);
+}
+
+unsigned char SD_SingleBlockWriteROM(
+    SDCard_t* card,
+    unsigned long block,
+    const unsigned char* arr
+)
+{
+    SD_SingleBlockWriteBegin(card, block);
+    SD_SendROM(card, arr, 512);
+    return SD_SingleBlockWriteEnd(card, block);
+}
+
+void SD_MBW_Start(
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks
+)
+{
+    card->write.MBW_startBlock = startBlock;
+    card->write.MBW_numBlocks = numBlocks;
+    card->write.MBW_flag_first = 1;
+    card->write.crc = 0;
+    card->write.verifyError = 0;
+    card->write.verifyReadBack = 0;
     
-    SDCard.write.MBW_startBlock = startBlock;
+    SD_MBW_Open(card, startBlock, numBlocks);
 }
 
-unsigned char SD_MBW_Send(unsigned char* arrWrite){    
-    CS_SD = 0; // Select card
-    while(spiReceive() != 0xFF); // Poll the DAT0 line until card is not busy
-        
-    // Send WRITE_MULTIPLE_BLOCK Start Block token
-    spiSend(START_BLOCK_TOKEN);
+unsigned char SD_MBW_Send(SDCard_t* card, unsigned char* arrWrite){    
+    SD_MBW_SendBegin(card);
 
     // Transfer the array
-    unsigned char response = 0; // To hold data response token
     for(unsigned short i = 0; i < 512; i++){
-        response = spiTransfer(arrWrite[i]);
+        SD_SendData(card, arrWrite[i]);
     }
 
-    // Stuff bits for data block CRC
-    SD_SendDummyBytes(2);
+    return SD_MBW_SendEnd(card);
+}
 
-    // Check data response token to see if write was valid
-    do{
-        response = spiReceive() & 0x1F;
-    }while(response == 0x1F);
-    CS_SD = 1; // Deselect card
+unsigned char SD_MBW_SendV(
+    SDCard_t* card,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+)
+{
+    SD_MBW_SendBegin(card);
+    SD_WriteFragments(card, iov, iovcnt);
+    return SD_MBW_SendEnd(card);
+}
+
+unsigned char SD_MBW_SendROM(SDCard_t* card, const unsigned char* arrWrite){
+    SD_MBW_SendBegin(card);
+    SD_SendROM(card, arrWrite, 512);
+    return SD_MBW_SendEnd(card);
+}
+
+unsigned char SD_MBW_Stop(SDCard_t* card){    
+    unsigned char success;
     
-    switch(response){
-        case 0b00101:
-            // Data accepted. Save the address of the last block written 
-            // just in case this needs to be referred to later in the user
-            // code
-            if(SDCard.write.MBW_flag_first){
-                // Special case for first block in the multiple block write
-                SDCard.write.lastBlockWritten = SDCard.write.MBW_startBlock;
-                SDCard.write.MBW_flag_first = 0;
-            }
-            else{
-                SDCard.write.lastBlockWritten++;
-            }
-            
-            return 1; // Success
-        case 0b01011:
-            // CRC error
-            SD_Command(CMD12, 0); // End data transmission using CMD12
-            return 0;
-        case 0b01101:
-            // Write error
-            SD_Command(CMD12, 0); // End data transmission using CMD12
-            return 0;
-        default:
-            return 0; // Unknown
+    SD_MBW_Suspend(card);
+    
+    success = !card->write.verifyError;
+    if(success && !card->write.MBW_flag_first &&
+       ((card->write.verify == SD_VERIFY_READBACK) ||
+        card->write.verifyReadBack)){
+        // The CRC covers every block sent since SD_MBW_Start, including those
+        // sent before any suspensions
+        success = SD_ReadBackCRC(
+            card,
+            card->write.MBW_startBlock,
+            card->write.lastBlockWritten - card->write.MBW_startBlock + 1,
+            card->write.crc
+        );
     }
+    
+    card->write.MBW_flag_first = 1;
+    
+    return success;
 }
 
-void SD_MBW_Stop(void){    
-    CS_SD = 0; // Select card
+void SD_MBW_Suspend(SDCard_t* card){
+    sd_select(card); // Select card
     while(spiReceive() != 0xFF); // Poll the DAT0 line until card is not busy
     
     // Send Stop Tran token once card is not busy
@@ -231,71 +330,121 @@ void SD_MBW_Stop(void){
         continue;
     }
 
-    CS_SD = 1; // Deselect card
+    sd_deselect(card); // Deselect card
     
-    SDCard.write.MBW_flag_first = 1;
+    // ACMD22 only reports on the most recent write command, so the blocks
+    // written since the last CMD25 are checked here rather than in
+    // SD_MBW_Stop, which also covers writes that were suspended and resumed
+    if(card->write.verify == SD_VERIFY_STATUS){
+        unsigned long numWritten;
+        if(!SD_GetNumWrBlocks(card, &numWritten)){
+            card->write.verifyReadBack = 1;
+        }
+        else if(numWritten != card->write.MBW_numSent){
+            card->write.verifyError = 1;
+        }
+    }
 }
 
-unsigned char SD_SingleBlockRead(unsigned long block, unsigned char* buf){   
-    // If the SD card is SDHC/SDXC, then it uses the block addressing format
-    // that was passed into this function. If the card is SDSC, then it uses
-    // byte addressing, thus the address passed into the function has to be
-    // converted to bytes
-    if(SDCard.Type == TYPE_SDSC){
-        // Multiply by 512 to convert a block address to a byte address
-        block <<= 9;
+void SD_MBW_Resume(SDCard_t* card){
+    unsigned long nextBlock;
+    unsigned long numWritten;
+    unsigned long numRemaining;
+    
+    // Continue from the block after the last one the card accepted
+    if(card->write.MBW_flag_first){
+        nextBlock = card->write.MBW_startBlock;
+    }
+    else{
+        nextBlock = card->write.lastBlockWritten + 1;
     }
+    numWritten = nextBlock - card->write.MBW_startBlock;
     
-    // Poll SD card to see when it stops being busy. Note that the SD card pulls
-    // down DAT0 when it's busy, which is why we don't need to assert CS = 0
-    unsigned char response;
-    do{
-        response = SD_Command(CMD17, block);
-        if((response & 0x0F) != 0){
-            // b0 --> General or unknown error
-            // b1 --> Internal card controller (CC) error
-            // b2 --> Card ECC (error-control code) failed
-            // b3 --> Out of range error
-            return 0;
+    // The pre-erase configured by ACMD23 is cleared once the previous write
+    // command ends, so ask for the blocks still outstanding. If the user has
+    // already sent more blocks than announced, pre-erase just the next one
+    if(numWritten < card->write.MBW_numBlocks){
+        numRemaining = card->write.MBW_numBlocks - numWritten;
+    }
+    else{
+        numRemaining = 1;
+    }
+    
+    SD_MBW_Open(card, nextBlock, numRemaining);
+}
+
+unsigned char SD_FillBlocks(
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    SD_FillGen_t* gen
+)
+{
+    unsigned char success = 1;
+    
+    if(numBlocks == 0){
+        return 1;
+    }
+    
+    SD_MBW_Start(card, startBlock, numBlocks);
+    while(numBlocks > 0){
+        SD_MBW_SendBegin(card);
+        SD_SendGenerated(card, gen);
+        if(!SD_MBW_SendEnd(card)){
+            success = 0;
+            break;
         }
-    }while(response != R1_READY_STATE);
+        numBlocks--;
+    }
+    if(!SD_MBW_Stop(card)){
+        success = 0;
+    }
     
-    /// Poll card to wait until it's not busy
-    CS_SD = 0;
-    do{
-        response = spiReceive();
-    }while(response != START_BLOCK);
+    return success;
+}
+
+unsigned char SD_SingleBlockRead(
+    SDCard_t* card,
+    unsigned long block,
+    unsigned char* buf
+)
+{
+    if(!SD_SingleBlockReadBegin(card, block)){
+        return 0;
+    }
 
     for(unsigned short i = 0; i < 512; i++){
         buf[i] = spiReceive();
     }
     
-    // Stuff bits for data block CRC
-    spiSend(0xFF);
-    spiSend(0xFF);
-
-    CS_SD = 1; // Deselect card
-    
-    SDCard.read.lastBlockRead = block;
+    SD_SingleBlockReadEnd(card, block);
     
     return 1; // Success
 }
 
-unsigned char SD_MBR_Start(unsigned long startBlock){   
-    // If the SD card is SDHC/SDXC, then it uses the block addressing format
-    // that was passed into this function. If the card is SDSC, then it uses
-    // byte addressing, thus the address passed into the function has to be
-    // converted to bytes
-    if(SDCard.Type == TYPE_SDSC){
-        // Multiply by 512 to convert a block address to a byte address
-        startBlock <<= 9;
+unsigned char SD_SingleBlockReadV(
+    SDCard_t* card,
+    unsigned long block,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+)
+{
+    if(!SD_SingleBlockReadBegin(card, block)){
+        return 0;
     }
     
+    SD_ReadFragments(iov, iovcnt);
+    SD_SingleBlockReadEnd(card, block);
+    
+    return 1; // Success
+}
+
+unsigned char SD_MBR_Start(SDCard_t* card, unsigned long startBlock){   
     // Send the READ_MULTIPLE_BLOCK command until the SD card indicates it is
     // ready to send data or there is an error
     unsigned char response = 0;
     do{
-        response = SD_Command(CMD18, startBlock);
+        response = SD_Command(card, CMD18, SD_BlockToAddress(card, startBlock));
         if(response & 0x0F){
             // b0 --> General or unknown error
             // b1 --> Internal card controller (CC) error
@@ -305,23 +454,14 @@ unsigned char SD_MBR_Start(unsigned long startBlock){
         }
     }while(response != R1_READY_STATE);
     
-    SDCard.read.MBR_startBlock = startBlock;
+    card->read.MBR_startBlock = startBlock;
     
     return 1; // Success
 }
 
-void SD_MBR_Receive(unsigned char* bufReceive){    
-    // Poll SD card to see when it stops being busy. Note that the SD card pulls
-    // down DAT0 when it's busy, which is why we don't need to assert CS = 0
-    while(spiReceive() == 0x00){
-        continue;
-    }
-    
-    CS_SD = 0; // Select card
-    
-    // Wait for 0xFE, the token signifying the start of a data block
-    while(spiReceive() != START_BLOCK){
-        continue;
+unsigned char SD_MBR_Receive(SDCard_t* card, unsigned char* bufReceive){    
+    if(!SD_MBR_ReceiveBegin(card)){
+        return 0;
     }
     
     // Receive the data block
@@ -329,49 +469,78 @@ void SD_MBR_Receive(unsigned char* bufReceive){
         bufReceive[i] = spiReceive();
     }
 
-    // Stuff bits for data block CRC
-    spiSend(0xFF);
-    spiSend(0xFF);
-
-    CS_SD = 1; // Deselect card
+    SD_MBR_ReceiveEnd(card);
+    return 1;
+}
 
-    if(SDCard.read.MBR_flag_first){
-        SDCard.read.lastBlockRead = SDCard.read.MBR_startBlock;
-        SDCard.read.MBR_flag_first = 0;
-    }
-    else{
-        SDCard.read.lastBlockRead++;
+unsigned char SD_MBR_ReceiveV(
+    SDCard_t* card,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+)
+{
+    if(!SD_MBR_ReceiveBegin(card)){
+        return 0;
     }
+    SD_ReadFragments(iov, iovcnt);
+    SD_MBR_ReceiveEnd(card);
+    return 1;
 }
 
-void SD_MBR_Stop(void){    
+void SD_MBR_Stop(SDCard_t* card){    
     // Send STOP_TRANSMISSION command
-    SD_Command(CMD12, 0);
-    SDCard.read.MBR_flag_first = 1;
+    SD_Command(card, CMD12, 0);
+    card->read.MBR_flag_first = 1;
 }
 
-void SD_EraseBlocks(unsigned long firstBlock, unsigned long lastBlock){   
-    // If the SD card is SDHC/SDXC, then it uses the block addressing format
-    // that was passed into this function. If the card is SDSC, then it uses
-    // byte addressing, thus the address passed into the function has to be
-    // converted to bytes
-    if(SDCard.Type == TYPE_SDSC){
-        // Multiply by 512 to convert a block address to a byte address
-        firstBlock <<= 9;
-        lastBlock <<= 9;
+unsigned char SD_EraseBlocks(
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock
+)
+{
+    return SD_Erase(card, firstBlock, lastBlock, ERASE_ARG_ERASE);
+}
+
+unsigned char SD_DiscardBlocks(
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock
+)
+{
+    // Cards that predate discard only know how to erase
+    if(!card->discard){
+        return SD_Erase(card, firstBlock, lastBlock, ERASE_ARG_ERASE);
     }
+    return SD_Erase(card, firstBlock, lastBlock, ERASE_ARG_DISCARD);
+}
+
+unsigned char SD_IsBusy(SDCard_t* card){
+    // The card holds DAT0 low for as long as it is busy
+    sd_select(card); // Select card
+    unsigned char response = spiReceive();
+    sd_deselect(card); // Deselect card
     
-    // Specify the block address for erasing to begin
-    SD_Command(CMD32, firstBlock); // ERASE_WR_BLOCK_START
-    
-    // Specify the block address for erasing to end
-    SD_Command(CMD33, lastBlock); // ERASE_WR_BLOCK_END
+    return (response != 0xFF) ? 1 : 0;
+}
+
+void SD_SetChipSelect(
+    SDCard_t* card,
+    volatile unsigned char* lat,
+    volatile unsigned char* tris,
+    unsigned char mask
+)
+{
+    card->csLat = lat;
+    card->csTris = tris;
+    card->csMask = mask;
     
-    // Erase the specified contiguous block sequence
-    SD_Command(CMD38, 0); // ERASE
+    // Keep the card deselected until it is addressed
+    *lat |= mask;
+    *tris &= (unsigned char)~mask;
 }
 
-void initSD(void){
+void initSD(SDCard_t* card){
     const unsigned char last_OSCCON = OSCCON; // Save oscillator state
     const unsigned char last_OSCTUNE = OSCTUNE; // Save oscillator state
     unsigned char response;
@@ -395,20 +564,21 @@ void initSD(void){
     __delay_ms(20);
     
     /************************** Initialization ritual *************************/
-    CS_SD = 1; // Deselect the card
-    TRIS_CS_SD = 0; // Set the chip select data direction to output
+    // Deselect the card and set the chip select data direction to output
+    *card->csLat |= card->csMask;
+    *card->csTris &= (unsigned char)~card->csMask;
 
     // Send 80 clock pulses. SD card standard specifies a minimum of 74
     for(unsigned char i = 0; i < 10; i++){
         spiSend(0xFF); // 1 byte --> 8 clock pulses (1 for each bit)
     }
     
-    CS_SD = 0; // Select the card
+    sd_select(card); // Select the card
     
     // Send CMD0 with CRC and arguments = 0. CMD0 is the GO_IDLE_STATE command,
     // which is like a software reset of the card. Continue sending this
     // until the response (1 byte) is received
-    while(SD_Command(CMD0, 0) != R1_IDLE_STATE){
+    while(SD_Command(card, CMD0, 0) != R1_IDLE_STATE){
         continue;
     }
     
@@ -418,27 +588,27 @@ void initSD(void){
     // random check pattern. CMD8 sends back 4 bytes after the regular response,
     // which contain the values in the operation condition register (OCR)
     while(1){
-        response = SD_Command(CMD8, 0x01AA);
+        response = SD_Command(card, CMD8, 0x01AA);
         
         // Read back the next 4 bytes to complete the CMD8 response packet
-        CS_SD = 0; // Select the card
+        sd_select(card); // Select the card
         for(unsigned char i = 0; i < 4; i++){
             arr_response[i] = spiReceive();
         }
-        CS_SD = 1; // Deselect the card
+        sd_deselect(card); // Deselect the card
         
         if((response & R1_ILLEGAL_COMMAND) == R1_ILLEGAL_COMMAND){
             // The card is version 2.x and there is a voltage mismatch, or card 
             // is version 1.x, or card is MMC
-            SDCard.SDversion = 1;
+            card->SDversion = 1;
             
             // Read OCR to check if voltage range is compatible
-            SD_Command(CMD58, 0);
-            CS_SD = 0; // Select card
+            SD_Command(card, CMD58, 0);
+            sd_select(card); // Select card
             for(unsigned char i = 0; i < 4; i++){
                 arr_response[i] = spiReceive();
             }
-            CS_SD = 1; // Deselect card
+            sd_deselect(card); // Deselect card
             
             if(arr_response[2] != 0x01){
                 // Error: Unusable card
@@ -450,7 +620,7 @@ void initSD(void){
             if((arr_response[2] == 0x01) && (arr_response[3] == 0xAA)){
                 // Valid response, compatible voltage range, and check pattern
                 // is correct
-               SDCard.SDversion = 2;
+               card->SDversion = 2;
                break;
             }
             else{
@@ -466,10 +636,10 @@ void initSD(void){
     // SD version 1, the all the bits in the argument should be cleared.
     // Otherwise, the high capacity support (HCS) bit (bit 33) should be set
     // to indicate to the card that the host (PIC) supports SDHC and SDXC cards
-    unsigned long argument = (SDCard.SDversion == 1) ? 0 : 0x40000000;
+    unsigned long argument = (card->SDversion == 1) ? 0 : 0x40000000;
     
     do{
-        response = SD_ACMD(ACMD41, argument);
+        response = SD_ACMD(card, ACMD41, argument);
     }while(
         (response != R1_READY_STATE) &&
         ((response & R1_ILLEGAL_COMMAND) != R1_ILLEGAL_COMMAND)
@@ -478,30 +648,30 @@ void initSD(void){
     // If ACMD41 returns illegal command, then the device is not an SD
     // memory card, or initialization has failed
     if((response & R1_ILLEGAL_COMMAND) == R1_ILLEGAL_COMMAND){
-        if(SDCard.SDversion == 1){
+        if(card->SDversion == 1){
             // Continue initialization as MMC card
-            SDCard.Type = TYPE_MMC;
-            SD_Command(CMD1, 0);
+            card->Type = TYPE_MMC;
+            SD_Command(card, CMD1, 0);
         }
         else{
             // Unusable card (initialization failed)
-            SDCard.init = 0;
+            card->init = 0;
             return;
         }
     }
     
-    if(SDCard.Type != TYPE_MMC){
+    if(card->Type != TYPE_MMC){
         // Read OCR to get card capacity information (CCS) and check if card is
         // SDHC
-        SD_Command(CMD58, 0);
+        SD_Command(card, CMD58, 0);
         
         // Check CCS flag (bit 30) as well as the power up status (bit 31)
-        CS_SD = 0; // Select card
+        sd_select(card); // Select card
         if((spiReceive() & 0xC0) == 0xC0){
-            SDCard.Type = TYPE_SDHC_SDXC;
+            card->Type = TYPE_SDHC_SDXC;
         }
         else{
-            SDCard.Type = TYPE_SDSC;
+            card->Type = TYPE_SDSC;
         }
     
         // Discard remaining OCR bytes, as they simply contain the voltage
@@ -509,25 +679,41 @@ void initSD(void){
         for(unsigned char i = 0; i < 3; i++){
             spiReceive();
         }
-        CS_SD = 1; // Deselect card
+        sd_deselect(card); // Deselect card
     }
     
     // Set block length to 512 bytes. Block read/write commands require this
-    while(SD_Command(CMD16, 512) != R1_READY_STATE){    continue;   }
-    SDCard.blockSize = 512;
+    while(SD_Command(card, CMD16, 512) != R1_READY_STATE){    continue;   }
+    card->blockSize = 512;
     
     // Request the contents of the card-specific data (CSD) register
-    SD_Command(CMD9, 0);
-    CS_SD = 0; // Select card
+    SD_Command(card, CMD9, 0);
+    sd_select(card); // Select card
     while(spiReceive() != START_BLOCK){    continue;   }
     for(unsigned char i = 0; i < 16; i++){
         arr_response[i] = spiReceive();
     }
     spiReceive(); // Ignore CRC
     spiReceive(); // Ignore CRC
-    CS_SD = 1; // Deselect card
+    sd_deselect(card); // Deselect card
+    
+    // Determine the erase granularity. Version 2 CSDs (CSD_STRUCTURE = 1) and
+    // version 1 CSDs with ERASE_BLK_EN set can erase single blocks. Otherwise,
+    // erases are done in groups of SECTOR_SIZE + 1 blocks.
+    //      arr_response[0] >> 6 --> CSD_STRUCTURE
+    //      arr_response[10] & 0x40 --> ERASE_BLK_EN
+    //      arr_response[10] & 0x3F --> SECTOR_SIZE[6:1]
+    //      arr_response[11] >> 7 --> SECTOR_SIZE[0]
+    if(((arr_response[0] >> 6) != 0) || (arr_response[10] & 0x40)){
+        card->eraseGroup = 1;
+    }
+    else{
+        card->eraseGroup = ((unsigned short)(arr_response[10] & 0x3F) << 1) |
+                                (arr_response[11] >> 7);
+        card->eraseGroup++;
+    }
     
-    if(SDCard.SDversion == 2){
+    if(card->SDversion == 2){
         // Uses the version 2 (SDHC) capacity calculation (megabytes).
         //      arr_response[9] --> C_SIZE[7:0]
         //      arr_response[8] --> C_SIZE[15:8]
@@ -535,8 +721,8 @@ void initSD(void){
         unsigned long tempSize = arr_response[9] + 1UL;
         tempSize |= (unsigned long)(arr_response[8] << 8);
         tempSize |= (unsigned long)(arr_response[7] & 0x3F) << 16;
-        SDCard.size = tempSize * 0.524288; // Number of MB now
-        SDCard.numBlocks = (unsigned long)(SDCard.size  * 2048); // Number of sectors/blocks
+        card->size = tempSize * 0.524288; // Number of MB now
+        card->numBlocks = (unsigned long)(card->size  * 2048); // Number of sectors/blocks
      }
      else{
         // Uses the version 1 (SDSC) capacity calculation (bytes).
@@ -552,14 +738,14 @@ void initSD(void){
                         ((arr_response[9] & 0x03) << 1) |
                         (unsigned long)((arr_response[10] & 0x80) >> 7)) + 2);
         tempSize = tempSize << (unsigned long)(arr_response[5] & 0x0F);
-        SDCard.size = (unsigned long)tempSize;
-        SDCard.numBlocks = (unsigned long)(SDCard.size / SDCard.blockSize);
+        card->size = (unsigned long)tempSize;
+        card->numBlocks = (unsigned long)(card->size / card->blockSize);
     }
     
     // Request the contents of the card identification (CID) register
-    SD_Command(CMD10, 0);
+    SD_Command(card, CMD10, 0);
     
-    CS_SD = 0; // Select card
+    sd_select(card); // Select card
     
     // Wait for data start token from card
     do{
@@ -571,34 +757,82 @@ void initSD(void){
     }
     spiReceive(); // Ignore CRC
     spiReceive(); // Ignore CRC
-    CS_SD = 1; // Deselect card
+    sd_deselect(card); // Deselect card
     
-    SDCard.MID = arr_response[0];
-    SDCard.OID = (unsigned short)(arr_response[1] << 8U) | arr_response[2];
-    SDCard.PHMH = arr_response[3];
+    card->MID = arr_response[0];
+    card->OID = (unsigned short)(arr_response[1] << 8U) | arr_response[2];
+    card->PHMH = arr_response[3];
 
     // Explicitly cast for long data type, or else the correct math libraries
     // won't be used and the shifting won't work properly
-    SDCard.PHML = (unsigned long)arr_response[4] << 24U;
-    SDCard.PHML |= (unsigned long)arr_response[5] << 16U;
-    SDCard.PHML |= (unsigned long)arr_response[6] << 8U;
-    SDCard.PHML |= (unsigned long)arr_response[7];
+    card->PHML = (unsigned long)arr_response[4] << 24U;
+    card->PHML |= (unsigned long)arr_response[5] << 16U;
+    card->PHML |= (unsigned long)arr_response[6] << 8U;
+    card->PHML |= (unsigned long)arr_response[7];
     
-    SDCard.PRV = arr_response[8];
+    card->PRV = arr_response[8];
 
     // Explicitly cast for long data type, or else the correct math libraries
     // won't be used and the shifting won't work properly
-    SDCard.PSN = (unsigned long)arr_response[9] << 24U;
-    SDCard.PSN |= (unsigned long)arr_response[10] << 16U;
-    SDCard.PSN |= (unsigned long)arr_response[11] << 8U;
-    SDCard.PSN |= (unsigned long)arr_response[12];
+    card->PSN = (unsigned long)arr_response[9] << 24U;
+    card->PSN |= (unsigned long)arr_response[10] << 16U;
+    card->PSN |= (unsigned long)arr_response[11] << 8U;
+    card->PSN |= (unsigned long)arr_response[12];
 
-    SDCard.MDT = (unsigned short)(((arr_response[13] & 0x0F) << 8U)) |
+    card->MDT = (unsigned short)(((arr_response[13] & 0x0F) << 8U)) |
                                     (arr_response[14]);
-    SDCard.CRC = arr_response[15] & 0xFE;
+    card->CRC = arr_response[15] & 0xFE;
+    
+    // Request the SD status (ACMD13), which holds the allocation unit (AU) size
+    // and the parameters needed to compute erase timeouts. MMC cards don't
+    // have one
+    card->auBlocks = 0;
+    card->eraseSize = 0;
+    card->eraseTimeout = 0;
+    card->eraseOffset = 0;
+    card->discard = 0;
+    if((card->Type != TYPE_MMC) && (SD_ACMD(card, ACMD13, 0) == R1_READY_STATE)){
+        sd_select(card); // Select card
+        spiReceive(); // Second byte of the R2 response
+        while(spiReceive() != START_BLOCK){    continue;   }
+        
+        // The status is 64 bytes long, but only a handful of them are needed.
+        // They are picked out as they arrive instead of being buffered.
+        //      byte 10 >> 4 --> AU_SIZE
+        //      bytes 11-12 --> ERASE_SIZE
+        //      byte 13 >> 2 --> ERASE_TIMEOUT
+        //      byte 13 & 0x03 --> ERASE_OFFSET
+        //      byte 24 & 0x02 --> DISCARD_SUPPORT
+        for(unsigned char i = 0; i < 64; i++){
+            response = spiReceive();
+            switch(i){
+                case 10:
+                    card->auBlocks = AU_BLOCKS[response >> 4];
+                    break;
+                case 11:
+                    card->eraseSize = (unsigned short)response << 8;
+                    break;
+                case 12:
+                    card->eraseSize |= response;
+                    break;
+                case 13:
+                    card->eraseTimeout = response >> 2;
+                    card->eraseOffset = response & 0x03;
+                    break;
+                case 24:
+                    card->discard = (response & 0x02) ? 1 : 0;
+                    break;
+                default:
+                    break;
+            }
+        }
+        spiReceive(); // Ignore CRC
+        spiReceive(); // Ignore CRC
+        sd_deselect(card); // Deselect card
+    }
     
     // Disable SPI, increase SPI frequency, restore previous oscillator state
-    sd_stop();
+    sd_stop(card);
     OSCCON = last_OSCCON;
     OSCTUNE = last_OSCTUNE;
     
@@ -608,14 +842,573 @@ void initSD(void){
     // Restart SPI
     spiInit(16);
     
-    // Initialize fields of SDCard struct for use in software
-    SDCard.write.MBW_flag_first = 1;
-    SDCard.write.MBW_startBlock = 0;
-    SDCard.write.lastBlockWritten = 0;
-    SDCard.read.MBR_flag_first = 1;
-    SDCard.read.MBR_startBlock = 0;
-    SDCard.read.lastBlockRead = 0;
+    // Initialize fields of the card struct for use in software
+    card->write.MBW_flag_first = 1;
+    card->write.MBW_startBlock = 0;
+    card->write.MBW_numBlocks = 0;
+    card->write.preErase = 1;
+    card->write.verify = SD_VERIFY_OFF;
+    card->write.lastBlockWritten = 0;
+    card->read.MBR_flag_first = 1;
+    card->read.MBR_startBlock = 0;
+    card->read.lastBlockRead = 0;
+    card->read.waitBytes = 0;
     
     // Store that the initialization succeeded
-    SDCard.init = 1;
+    card->init = 1;
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Converts a block number into the address format the card expects
+ * @param block Block number in SD card memory
+ * @return The command argument that addresses the block
+ */
+static unsigned long SD_BlockToAddress(SDCard_t* card, unsigned long block){
+    // If the SD card is SDHC/SDXC, then it uses the block addressing format
+    // that was passed into this function. If the card is SDSC, then it uses
+    // byte addressing, thus the address passed into the function has to be
+    // converted to bytes
+    if(card->Type == TYPE_SDSC){
+        // Multiply by 512 to convert a block address to a byte address
+        return block << 9;
+    }
+    return block;
+}
+
+/**
+ * @brief Issues the ERASE_WR_BLOCK_START, ERASE_WR_BLOCK_END and ERASE
+ *        commands. Returns as soon as the card accepts the ERASE command; the
+ *        card holds DAT0 low until the erase is finished
+ * @param firstBlock Address of the first block to be erased
+ * @param lastBlock Address of the last block to be erased
+ * @param arg Argument for the ERASE command (ERASE_ARG_ERASE or
+ *        ERASE_ARG_DISCARD)
+ * @return 1 if the card accepted all three commands, 0 otherwise
+ */
+static unsigned char SD_Erase(
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock,
+    unsigned long arg
+)
+{
+    // Specify the block address for erasing to begin
+    if(SD_Command(card, CMD32, SD_BlockToAddress(card, firstBlock)) != R1_READY_STATE){
+        return 0;
+    }
+    
+    // Specify the block address for erasing to end
+    if(SD_Command(card, CMD33, SD_BlockToAddress(card, lastBlock)) != R1_READY_STATE){
+        return 0;
+    }
+    
+    // Erase the specified contiguous block sequence
+    if(SD_Command(card, CMD38, arg) != R1_READY_STATE){
+        return 0;
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief Issues the pre-erase and WRITE_MULTIPLE_BLOCK commands that open a
+ *        multiple block write
+ * @param block Block number of the first block to be written
+ * @param numBlocks Number of blocks to be pre-erased
+ */
+static void SD_MBW_Open(
+    SDCard_t* card,
+    unsigned long block,
+    unsigned long numBlocks
+)
+{
+    card->write.MBW_numSent = 0;
+    
+    // Specify the number of blocks to be pre-erased. This is skipped if the
+    // user knows that the blocks have already been erased
+    if(card->write.preErase){
+        SD_ACMD(card, ACMD23, numBlocks);
+    }
+    
+    // Send CMD25 (WRITE_MULTIPLE_BLOCK) and wait for card ready response
+    while(SD_Command(card, CMD25, SD_BlockToAddress(card, block)) != R1_READY_STATE);
+}
+
+/**
+ * @brief Issues WRITE_BLOCK and sends the start block token. The caller then
+ *        sends the 512 data bytes and finishes with SD_SingleBlockWriteEnd
+ * @param block Block number in the SD card memory to write to
+ */
+static void SD_SingleBlockWriteBegin(SDCard_t* card, unsigned long block){
+    // Send CMD24 (WRITE_BLOCK) and wait for card ready response
+    while(SD_Command(card, CMD24, SD_BlockToAddress(card, block)) != R1_READY_STATE);
+    
+    // Send WRITE_BLOCK Start Block token
+    sd_select(card); // Select card
+    spiSend(START_BLOCK);
+    
+    card->write.crc = 0;
+}
+
+/**
+ * @brief Finishes a single block write once the data bytes have been sent
+ * @param block Block number in the SD card memory that was written to
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char SD_SingleBlockWriteEnd(SDCard_t* card, unsigned long block){
+    // Stuff bits for data block CRC
+    SD_SendDummyBytes(2);
+    
+    // Check data response token to see if write was valid
+    unsigned char response = (spiReceive() >> 1) & 0x0F;
+    sd_deselect(card); // Deselect card
+    switch(response){
+        case 0b10:
+            // Data accepted. Save the address of the last block written 
+            // just in case this needs to be referred to later in the user
+            // code
+            card->write.lastBlockWritten = block;
+            
+            // Wait until card is done programming
+            while(spiReceive() == 0){  continue;   }
+            
+            if(card->write.verify == SD_VERIFY_STATUS){
+                // The status is only inconclusive if the card doesn't know
+                // the command (e.g. MMC), in which case fall back to reading
+                // the block back
+                unsigned short status = SD_SendStatus(card);
+                if(((status >> 8) & R1_ILLEGAL_COMMAND) == 0){
+                    return (status == 0) ? 1 : 0;
+                }
+            }
+            if(card->write.verify != SD_VERIFY_OFF){
+                return SD_ReadBackCRC(card, block, 1, card->write.crc);
+            }
+            return 1;
+        case 0b101:
+            // CRC error
+            return 0;
+        case 0b110:
+            // Write error
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Waits for the card to finish programming the previous block and
+ *        sends the start block token for the next block of a multiple block
+ *        write. The caller then sends the 512 data bytes and finishes with
+ *        SD_MBW_SendEnd
+ */
+static void SD_MBW_SendBegin(SDCard_t* card){
+    sd_select(card); // Select card
+    while(spiReceive() != 0xFF); // Poll the DAT0 line until card is not busy
+        
+    // Send WRITE_MULTIPLE_BLOCK Start Block token
+    spiSend(START_BLOCK_TOKEN);
+    card->write.blockCRC = card->write.crc;
+}
+
+/**
+ * @brief Finishes sending a block of a multiple block write once the data
+ *        bytes have been sent
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char SD_MBW_SendEnd(SDCard_t* card){
+    unsigned char response; // To hold data response token
+    
+    // Stuff bits for data block CRC
+    SD_SendDummyBytes(2);
+
+    // Check data response token to see if write was valid
+    do{
+        response = spiReceive() & 0x1F;
+    }while(response == 0x1F);
+    sd_deselect(card); // Deselect card
+    
+    switch(response){
+        case 0b00101:
+            // Data accepted. Save the address of the last block written 
+            // just in case this needs to be referred to later in the user
+            // code
+            card->write.MBW_numSent++;
+            if(card->write.MBW_flag_first){
+                // Special case for first block in the multiple block write
+                card->write.lastBlockWritten = card->write.MBW_startBlock;
+                card->write.MBW_flag_first = 0;
+            }
+            else{
+                card->write.lastBlockWritten++;
+            }
+            
+            return 1; // Success
+        case 0b01011:
+            // CRC error
+            SD_Command(card, CMD12, 0); // End data transmission using CMD12
+            break;
+        case 0b01101:
+            // Write error
+            SD_Command(card, CMD12, 0); // End data transmission using CMD12
+            break;
+        default:
+            break; // Unknown
+    }
+    
+    // The block wasn't written, so it mustn't count towards the CRC that the
+    // blocks are read back against. The rejection is reported here instead
+    card->write.crc = card->write.blockCRC;
+    return 0;
+}
+
+/**
+ * @brief Issues READ_SINGLE_BLOCK and waits for the start block token. The
+ *        caller then receives the 512 data bytes and finishes with
+ *        SD_SingleBlockReadEnd
+ * @param block Block number in SD card memory to read
+ * @return 1 if the card is about to send the block, 0 otherwise
+ */
+static unsigned char SD_SingleBlockReadBegin(SDCard_t* card, unsigned long block){
+    // Poll SD card to see when it stops being busy. Note that the SD card pulls
+    // down DAT0 when it's busy, which is why we don't need to assert CS = 0
+    unsigned char response;
+    do{
+        response = SD_Command(card, CMD17, SD_BlockToAddress(card, block));
+        if((response & 0x0F) != 0){
+            // b0 --> General or unknown error
+            // b1 --> Internal card controller (CC) error
+            // b2 --> Card ECC (error-control code) failed
+            // b3 --> Out of range error
+            return 0;
+        }
+    }while(response != R1_READY_STATE);
+    
+    /// Poll card to wait until it's not busy
+    sd_select(card);
+    card->read.waitBytes = 0;
+    do{
+        response = spiReceive();
+        if(card->read.waitBytes != 0xFFFF){
+            card->read.waitBytes++;
+        }
+    }while(response != START_BLOCK);
+    
+    return 1;
+}
+
+/**
+ * @brief Finishes a single block read once the data bytes have been received
+ * @param block Block number in SD card memory that was read
+ */
+static void SD_SingleBlockReadEnd(SDCard_t* card, unsigned long block){
+    // Stuff bits for data block CRC
+    spiSend(0xFF);
+    spiSend(0xFF);
+
+    sd_deselect(card); // Deselect card
+    
+    card->read.lastBlockRead = block;
+}
+
+/**
+ * @brief Sends a data byte of a block being written. When write verification
+ *        is enabled, the byte is also added to the write CRC
+ * @param byte The byte to be sent
+ */
+static void SD_SendData(SDCard_t* card, unsigned char byte){
+    spiSend(byte);
+    if(card->write.verify != SD_VERIFY_OFF){
+        card->write.crc = SD_CRC16(card->write.crc, byte);
+    }
+}
+
+/**
+ * @brief Reads back a range of blocks and compares the CRC of their contents
+ *        with an expected CRC. The data itself is discarded, so no buffer is
+ *        needed. The read bookkeeping is left as it was
+ * @param firstBlock Block number of the first block to read back
+ * @param numBlocks Number of blocks to read back
+ * @param crc The CRC16 of the data that was written
+ * @return 1 if the CRCs match, 0 otherwise
+ */
+static unsigned char SD_ReadBackCRC(
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long numBlocks,
+    unsigned short crc
+)
+{
+    SDReadState_t savedRead = card->read;
+    unsigned short readCRC = 0;
+    
+    if(!SD_MBR_Start(card, firstBlock)){
+        return 0;
+    }
+    while(numBlocks > 0){
+        if(!SD_MBR_ReceiveBegin(card)){
+            SD_MBR_Stop(card);
+            card->read = savedRead;
+            return 0;
+        }
+        for(unsigned short i = 0; i < 512; i++){
+            readCRC = SD_CRC16(readCRC, spiReceive());
+        }
+        SD_MBR_ReceiveEnd(card);
+        numBlocks--;
+    }
+    SD_MBR_Stop(card);
+    
+    card->read = savedRead;
+    
+    return (readCRC == crc) ? 1 : 0;
+}
+
+/**
+ * @brief Waits for the start block token of the next block of a multiple
+ *        block read. The caller then receives the 512 data bytes and finishes
+ *        with SD_MBR_ReceiveEnd
+ * @return 1 if the block is coming, 0 if the card sent a data error token or
+ *         nothing within SD_READ_WAIT_BYTES bytes
+ */
+static unsigned char SD_MBR_ReceiveBegin(SDCard_t* card){
+    unsigned char response;
+
+    // The card has to be selected before polling, since with several cards on
+    // the bus nothing drives MISO otherwise
+    sd_select(card); // Select card
+    
+    // Wait for 0xFE, the token signifying the start of a data block. The card
+    // sends 0x00 while busy and a data error token (0b0000xxxx) if it can't
+    // read the block
+    card->read.waitBytes = 0;
+    while((response = spiReceive()) != START_BLOCK){
+        if(((response != 0x00) && ((response & 0xF0) == 0x00)) ||
+           (card->read.waitBytes == SD_READ_WAIT_BYTES)){
+            sd_deselect(card); // Deselect card
+            return 0;
+        }
+        card->read.waitBytes++;
+    }
+    return 1;
+}
+
+/**
+ * @brief Finishes receiving a block of a multiple block read once the data
+ *        bytes have been received
+ */
+static void SD_MBR_ReceiveEnd(SDCard_t* card){
+    // Stuff bits for data block CRC
+    spiSend(0xFF);
+    spiSend(0xFF);
+
+    sd_deselect(card); // Deselect card
+
+    if(card->read.MBR_flag_first){
+        card->read.lastBlockRead = card->read.MBR_startBlock;
+        card->read.MBR_flag_first = 0;
+    }
+    else{
+        card->read.lastBlockRead++;
+    }
+}
+
+/**
+ * @brief Sends the 512 data bytes of a block from a list of fragments.
+ *        Fragments with a NULL base, and any bytes left over once the list
+ *        runs out, are sent as 0x00. Bytes past the end of the block are
+ *        ignored
+ * @param iov Pointer to the first fragment
+ * @param iovcnt Number of fragments
+ */
+static void SD_WriteFragments(
+    SDCard_t* card,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+)
+{
+    unsigned short remaining = 512;
+    unsigned short len;
+    const unsigned char* src;
+    
+    while((iovcnt > 0) && (remaining > 0)){
+        len = (iov->len < remaining) ? iov->len : remaining;
+        remaining -= len;
+        src = iov->base;
+        if(src == NULL){
+            while(len > 0){
+                SD_SendData(card, 0x00);
+                len--;
+            }
+        }
+        else{
+            // The pointer may refer to program memory, in which case the
+            // compiler reads each byte using a table read
+            while(len > 0){
+                SD_SendData(card, *src);
+                src++;
+                len--;
+            }
+        }
+        iov++;
+        iovcnt--;
+    }
+    
+    // Pad the rest of the block
+    while(remaining > 0){
+        SD_SendData(card, 0x00);
+        remaining--;
+    }
+}
+
+/**
+ * @brief Sends bytes from program memory. The table pointer is loaded once
+ *        and then post-incremented by each table read, which avoids the
+ *        per-byte overhead of dereferencing a generic const pointer
+ * @param src Pointer to the data in program memory
+ * @param len Number of bytes to send
+ */
+static void SD_SendROM(SDCard_t* card, const unsigned char* src, unsigned short len){
+    unsigned char byte;
+    unsigned char ptrH;
+    unsigned char ptrL;
+    
+    // Program memory on the PIC18F4620 is 64 KB, so the upper byte of the
+    // table pointer is always 0
+    TBLPTRU = 0;
+    TBLPTRH = (unsigned char)((unsigned short)src >> 8);
+    TBLPTRL = (unsigned char)((unsigned short)src);
+    
+    while(len > 0){
+        asm("TBLRD*+"); // TABLAT = *TBLPTR++
+        byte = TABLAT;
+        spiSend(byte);
+        if(card->write.verify != SD_VERIFY_OFF){
+            // The CRC table is in program memory as well, so looking it up
+            // moves the table pointer
+            ptrH = TBLPTRH;
+            ptrL = TBLPTRL;
+            card->write.crc = SD_CRC16(card->write.crc, byte);
+            TBLPTRU = 0;
+            TBLPTRH = ptrH;
+            TBLPTRL = ptrL;
+        }
+        len--;
+    }
+}
+
+/**
+ * @brief Receives the 512 data bytes of a block into a list of fragments.
+ *        Fragments with a NULL base, and any bytes left over once the list
+ *        runs out, are discarded
+ * @param iov Pointer to the first fragment. Non-NULL bases must be in RAM
+ * @param iovcnt Number of fragments
+ */
+static void SD_ReadFragments(
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+)
+{
+    unsigned short remaining = 512;
+    unsigned short len;
+    unsigned char* dst;
+    
+    while((iovcnt > 0) && (remaining > 0)){
+        len = (iov->len < remaining) ? iov->len : remaining;
+        remaining -= len;
+        dst = (unsigned char*)iov->base;
+        if(dst == NULL){
+            while(len > 0){
+                spiReceive();
+                len--;
+            }
+        }
+        else{
+            while(len > 0){
+                *dst = spiReceive();
+                dst++;
+                len--;
+            }
+        }
+        iov++;
+        iovcnt--;
+    }
+    
+    // Discard the rest of the block
+    while(remaining > 0){
+        spiReceive();
+        remaining--;
+    }
+}
+
+/**
+ * @brief Sends the 512 data bytes of a block from a data generator. Each
+ *        generator type has its own loop so that the type is only checked
+ *        once per block
+ * @param gen Pointer to the data generator
+ */
+static void SD_SendGenerated(SDCard_t* card, SD_FillGen_t* gen){
+    unsigned short i;
+    unsigned short pos;
+    unsigned short lfsr;
+    unsigned char value;
+    unsigned char bit;
+    
+    switch(gen->type){
+        case SD_FILL_CONSTANT:
+            value = gen->value;
+            for(i = 0; i < 512; i++){
+                SD_SendData(card, value);
+            }
+            break;
+        case SD_FILL_PATTERN:
+            pos = gen->patternPos;
+            for(i = 0; i < 512; i++){
+                SD_SendData(card, gen->pattern[pos]);
+                pos++;
+                if(pos >= gen->patternLen){
+                    pos = 0;
+                }
+            }
+            gen->patternPos = pos;
+            break;
+        case SD_FILL_COUNTER:
+            value = gen->value;
+            for(i = 0; i < 512; i++){
+                SD_SendData(card, value);
+                value++;
+            }
+            gen->value = value;
+            break;
+        case SD_FILL_LFSR:
+            // Galois LFSR with taps 16, 14, 13, 11 (maximal length). Clocked 8
+            // times per byte so that consecutive bytes don't share bits
+            lfsr = gen->lfsr;
+            for(i = 0; i < 512; i++){
+                for(bit = 0; bit < 8; bit++){
+                    if(lfsr & 1){
+                        lfsr = (lfsr >> 1) ^ 0xB400;
+                    }
+                    else{
+                        lfsr >>= 1;
+                    }
+                }
+                SD_SendData(card, (unsigned char)lfsr);
+            }
+            gen->lfsr = lfsr;
+            break;
+        case SD_FILL_CALLBACK:
+            for(i = 0; i < 512; i++){
+                SD_SendData(card, gen->next(gen->ctx));
+            }
+            break;
+        default:
+            // Unknown generator. Still complete the block so that the card
+            // doesn't wait forever for the rest of the data
+            for(i = 0; i < 512; i++){
+                SD_SendData(card, 0x00);
+            }
+            break;
+    }
 }
\ No newline at end of file
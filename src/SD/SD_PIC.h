@@ -14,31 +14,51 @@
 
 /********************************* Includes **********************************/
 #include <xc.h>
+#include <stddef.h>
 #include "../SPI/SPI_PIC.h"
 
 /********************************** Macros ***********************************/
-#define CS_SD      LATEbits.LATE2   /**< SD card chip select                 */
-#define TRIS_CS_SD TRISEbits.TRISE2 /**< TRIS for the chip select pin        */
 #define PORT_DAT0  PORTCbits.RC4    /**< Pin used for receiving SD card data */
 
+/** @brief Selects a card by driving its chip select pin low */
+#define sd_select(card) *((card)->csLat) &= (unsigned char)~((card)->csMask)
+
+/**
+ * @brief Deselects a card by driving its chip select pin high. A card only
+ *        releases MISO on the first clock edge after it is deselected, so a
+ *        dummy byte is sent to free the bus for the other cards
+ */
+#define sd_deselect(card){\
+    *((card)->csLat) |= (card)->csMask;\
+    spiSend(0xFF);\
+}
+
 /**
  * @brief Equivalent to a software reset of the SD card. In this state, only
  *        CMD8, ACMD41, CMD58 and CMD59 are valid
  */
-#define sd_go_idle_state() while(SD_Command(CMD0, 0) != R1_READY_STATE);
+#define sd_go_idle_state(card) while(SD_Command(card, CMD0, 0) != R1_READY_STATE);
 
 /** @brief Smoothly starts SD card usage, post-initialization */
-#define sd_start(){\
+#define sd_start(card){\
     mssp_enable();\
-    CS_SD = 0;\
+    sd_select(card);\
 }
 
 /** @brief Smoothly stops SD card usage */
-#define sd_stop(){\
-    CS_SD = 1;\
+#define sd_stop(card){\
+    sd_deselect(card);\
     mssp_disable();\
 }
 
+/**
+ * @brief Bytes polled for the start token of a block in a multiple block read
+ *        before the read is given up on. At most 0xFFFF
+ */
+#ifndef SD_READ_WAIT_BYTES
+#define SD_READ_WAIT_BYTES 0xFFFFU
+#endif
+
 /******************************** Constants **********************************/
 extern const unsigned char CMD0;               /**< GO_IDLE_STATE */
 extern const unsigned char CMD0CRC;            /**< CRC for CMD0 -- needed during initialization */
@@ -59,6 +79,7 @@ extern const unsigned char CMD33;              /**< ERASE_WR_BLOCK_END_ADDR (arg
 extern const unsigned char CMD38;              /**< ERASE (arg: stuff bits) */
 extern const unsigned char CMD55;              /**< APP_CMD */
 extern const unsigned char CMD58;              /**< READ_OCR */
+extern const unsigned char ACMD13;             /**< SD_STATUS */
 extern const unsigned char ACMD22;             /**< SEND_NUM_WR_BLOCKS */
 extern const unsigned char ACMD23;             /**< SET_WR_BLK_ERASE_COUNT (arg[22:0] # blks) */
 extern const unsigned char ACMD41;             /**< SD_SEND_OP_COND */
@@ -68,6 +89,8 @@ extern const unsigned char R1_ILLEGAL_COMMAND; /**< R1 response "illegal command
 extern const unsigned char START_BLOCK;        /**< Used for WRITE_BLOCK, READ_SINGLE_BLOCK, READ_MULTIPLE_BLOCK */
 extern const unsigned char START_BLOCK_TOKEN;  /**< Used for WRITE_MULTIPLE_BLOCK */
 extern const unsigned char STOP_TRAN;          /**< Used to end multiple block writes ("stop transfer") */
+extern const unsigned long ERASE_ARG_ERASE;    /**< ERASE argument for a regular erase */
+extern const unsigned long ERASE_ARG_DISCARD;  /**< ERASE argument for a discard */
 
 /********************************** Types ************************************/
 /**
@@ -80,8 +103,84 @@ typedef enum{
     TYPE_MMC = 2        /**< MultiMediaCard    */
 }sd_card_types_e;
 
-/** @brief SD card object */
+/** @brief Write verification modes */
+typedef enum{
+    SD_VERIFY_OFF = 0,     /**< Trust the data response token              */
+    SD_VERIFY_STATUS = 1,  /**< Check CMD13 after single block writes and
+                            *   ACMD22 after multiple block writes, falling
+                            *   back to a read-back if the card can't answer */
+    SD_VERIFY_READBACK = 2 /**< Always read the data back and compare CRCs  */
+}sd_verify_e;
+
+/** @brief State information used by write functions */
+typedef struct{
+    unsigned long lastBlockWritten; /**< Block number, updated in all write functions */
+    unsigned long MBW_startBlock;   /**< Block number, for multiple block writes */
+    unsigned long MBW_numBlocks;    /**< Blocks announced in SD_MBW_Start */
+    unsigned char MBW_flag_first;   /**< For multiple block writes */
+    unsigned char preErase;         /**< 1 to pre-erase (ACMD23) multiple block writes */
+    sd_verify_e verify;             /**< Write verification mode */
+    unsigned short crc;             /**< CRC16 of the data written, when verifying */
+    unsigned short blockCRC;        /**< crc before the block being sent, restored
+                                     *   if the card rejects the block */
+    unsigned long MBW_numSent;      /**< Blocks accepted since the last CMD25 */
+    unsigned char verifyError;      /**< Set when verification fails mid-write */
+    unsigned char verifyReadBack;   /**< Set when the card can't report its count */
+}SDWriteState_t;
+
+/** @brief State information used by read functions */
+typedef struct{
+    unsigned long lastBlockRead;  /**< Block number, updated in all read functions */
+    unsigned long MBR_startBlock; /**< Block number, for multiple block reads */
+    unsigned char MBR_flag_first; /**< For multiple block reads */
+    unsigned short waitBytes;     /**< Bytes polled before the last block's
+                                   *   start token, i.e. its access time */
+}SDReadState_t;
+
+/**
+ * @brief One fragment of a vectored (scatter/gather) transfer. A list of
+ *        fragments describes the 512 bytes of one block in order
+ */
+typedef struct{
+    const unsigned char* base; /**< Fragment data in RAM or program memory.
+                                *   Must be in RAM for reads. NULL sends 0x00
+                                *   for writes and discards bytes for reads */
+    unsigned short len;        /**< Fragment length, in bytes */
+}SD_IOVec_t;
+
+/** @brief Ways in which SD_FillBlocks can generate the data it writes */
+typedef enum{
+    SD_FILL_CONSTANT = 0, /**< Every byte is value                          */
+    SD_FILL_PATTERN = 1,  /**< pattern[0] to pattern[patternLen-1], repeated */
+    SD_FILL_COUNTER = 2,  /**< value, value + 1, ..., wrapping after 0xFF    */
+    SD_FILL_LFSR = 3,     /**< Pseudo-random bytes from a 16-bit LFSR        */
+    SD_FILL_CALLBACK = 4  /**< Each byte is returned by next(ctx)            */
+}sd_fill_type_e;
+
+/**
+ * @brief Data generator for SD_FillBlocks. The generator state is updated as
+ *        bytes are produced, so a later fill continues the same sequence
+ */
+typedef struct{
+    sd_fill_type_e type;          /**< How the data is generated */
+    unsigned char value;          /**< Constant, or next counter value */
+    const unsigned char* pattern; /**< Pattern in RAM or program memory */
+    unsigned short patternLen;    /**< Pattern length, in bytes */
+    unsigned short patternPos;    /**< Index of the next pattern byte */
+    unsigned short lfsr;          /**< LFSR state. Seed with a non-zero value */
+    unsigned char (*next)(void* ctx); /**< Callback producing the next byte */
+    void* ctx;                    /**< Argument passed to next */
+}SD_FillGen_t;
+
+/**
+ * @brief SD card object. Every function of the driver takes a pointer to the
+ *        card it is to operate on, so any number of cards can share the SPI
+ *        bus as long as each has its own chip select pin
+ */
 typedef struct{
+    volatile unsigned char* csLat;  /**< LAT register of the chip select pin */
+    volatile unsigned char* csTris; /**< TRIS register of the chip select pin */
+    unsigned char csMask;           /**< Chip select pin's bit in csLat/csTris */
     unsigned char SDversion;  /**< Version of the SD specification the card complies to */
     sd_card_types_e Type;     /**< Type of card: SDSC, SDHC/SDXC, MMC */
     unsigned char MID;        /**< Manufacturer ID */
@@ -95,26 +194,17 @@ typedef struct{
     unsigned short blockSize; /**< Size of an addressable data block, in bytes */
     unsigned long numBlocks;  /**< Number of block addresses in card */
     double size;              /**< Card capacity in MB */
+    unsigned short eraseGroup; /**< Erase granularity, in blocks */
+    unsigned long auBlocks;    /**< Allocation unit size in blocks (0 if unknown) */
+    unsigned short eraseSize;  /**< ERASE_SIZE: AUs erased per ERASE_TIMEOUT (0 if unknown) */
+    unsigned char eraseTimeout; /**< ERASE_TIMEOUT, in seconds */
+    unsigned char eraseOffset; /**< ERASE_OFFSET, in seconds */
+    unsigned char discard;     /**< 1 if the card supports discard, 0 otherwise */
     unsigned char init; /**< 1 if initialization succeeded, 0 otherwise */
-    
-    /** @brief State information used by write functions */
-    struct{
-        unsigned long lastBlockWritten; /**< Updated in all write functions */
-        unsigned long MBW_startBlock;   /**< For multiple block writes */
-        unsigned char MBW_flag_first;   /**< For multiple block writes */
-    }write;
-    
-    /** @brief State information used by read functions */
-    struct{
-        unsigned long lastBlockRead;  /**< Updated in all read functions */
-        unsigned long MBR_startBlock; /**< For multiple block reads */
-        unsigned char MBR_flag_first; /**< For multiple block reads */
-    }read;
+    SDWriteState_t write; /**< State information used by write functions */
+    SDReadState_t read;   /**< State information used by read functions */
 }SDCard_t;
 
-/***************************** Public Variables ******************************/
-extern SDCard_t SDCard;
-
 /************************ Public Function Prototypes *************************/
 /**
  * @brief Sends dummy bytes of 0xFF to the SD card. Used to update the flash
@@ -125,36 +215,135 @@ void SD_SendDummyBytes(unsigned char numBytes);
 
 /**
  * @brief Sends a command to the SD card
+ * @param card Pointer to the card
  * @param cmd The command code to issue
  * @param arg The command argument (32-bit)
  * @return The SD card's response code
  */
-unsigned char SD_Command(unsigned char cmd, unsigned long arg);
+unsigned char SD_Command(SDCard_t* card, unsigned char cmd, unsigned long arg);
 
 /**
  * @brief Sends an application specific command (ACMD) to the SD card
+ * @param card Pointer to the card
  * @param cmd The command code to issue
  * @param args The command argument (32-bit)
  * @return The SD card's response code
  */
-unsigned char SD_ACMD(unsigned char cmd, unsigned long args);
+unsigned char SD_ACMD(SDCard_t* card, unsigned char cmd, unsigned long args);
+
+/**
+ * @brief Sends SEND_STATUS (CMD13) to the card
+ * @param card Pointer to the card
+ * @return The R2 response. The upper byte is the R1 response and the lower
+ *         byte holds the remaining status bits. 0 means no errors
+ */
+unsigned short SD_SendStatus(SDCard_t* card);
+
+/**
+ * @brief Sends SEND_NUM_WR_BLOCKS (ACMD22) to the card, which reports the
+ *        number of blocks written without errors by the last write command
+ * @param card Pointer to the card
+ * @param numBlocks Pointer to where the number of blocks is to be stored
+ * @return 1 if successful, 0 if the card rejected the command
+ */
+unsigned char SD_GetNumWrBlocks(SDCard_t* card, unsigned long* numBlocks);
+
+/**
+ * @brief Updates a CRC16 (CRC-CCITT, polynomial 0x1021) with a byte. This is
+ *        the CRC the SD card uses for data blocks when started from 0
+ * @param crc The CRC so far
+ * @param byte The byte to be added
+ * @return The updated CRC
+ */
+unsigned short SD_CRC16(unsigned short crc, unsigned char byte);
+
+/**
+ * @brief Reads a little-endian 16-bit value, the byte order used on the card
+ * @param p Pointer to the value
+ * @return The value
+ */
+unsigned short SD_Load16(const unsigned char* p);
+
+/**
+ * @brief Reads a little-endian 32-bit value
+ * @param p Pointer to the value
+ * @return The value
+ */
+unsigned long SD_Load32(const unsigned char* p);
+
+/**
+ * @brief Writes a little-endian 16-bit value
+ * @param p Pointer to where the value is to be written
+ * @param value The value
+ */
+void SD_Store16(unsigned char* p, unsigned short value);
+
+/**
+ * @brief Writes a little-endian 32-bit value
+ * @param p Pointer to where the value is to be written
+ * @param value The value
+ */
+void SD_Store32(unsigned char* p, unsigned long value);
 
 /**
  * @brief Initiates a 512 byte write into the specified block, starting with
- *        arr[0] and ending with arr[511]
+ *        arr[0] and ending with arr[511]. If write verification is enabled,
+ *        the card status is checked using SEND_STATUS (CMD13) once the block
+ *        is programmed. If the card can't answer, or SD_VERIFY_READBACK is
+ *        set, the block is read back and its CRC is compared with the CRC of
+ *        the data that was sent
+ * @param card Pointer to the card
  * @param block Block number in the SD card memory to write to
  * @param arr Pointer to the array of bytes to be written
  * @return 1 if successful, 0 otherwise
  */
-unsigned char SD_SingleBlockWrite(unsigned long block, unsigned char* arr);
+unsigned char SD_SingleBlockWrite(
+    SDCard_t* card,
+    unsigned long block,
+    unsigned char* arr
+);
+
+/**
+ * @brief Same as SD_SingleBlockWrite, except that the 512 bytes are gathered
+ *        from a list of fragments instead of a single array. If the fragments
+ *        add up to less than 512 bytes, the rest of the block is written as
+ *        0x00
+ * @param card Pointer to the card
+ * @param block Block number in the SD card memory to write to
+ * @param iov Pointer to the first fragment
+ * @param iovcnt Number of fragments
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char SD_SingleBlockWriteV(
+    SDCard_t* card,
+    unsigned long block,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+);
+
+/**
+ * @brief Same as SD_SingleBlockWrite, except that the 512 bytes are streamed
+ *        straight out of program memory using table reads, so constant tables
+ *        and templates can be written without being copied into RAM
+ * @param card Pointer to the card
+ * @param block Block number in the SD card memory to write to
+ * @param arr Pointer to a 512 byte const array in program memory
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char SD_SingleBlockWriteROM(
+    SDCard_t* card,
+    unsigned long block,
+    const unsigned char* arr
+);
 
 /**
  * @brief Initiates a multiple block write beginning at the block startBlock,
  *        and ending at the block numBlocks later
+ * @param card Pointer to the card
  * @param startBlock Block number in SD card memory to begin the write
  * @param numBlocks Number of blocks to be written to
  */
-void SD_MBW_Start(unsigned long startBlock, unsigned long numBlocks);
+void SD_MBW_Start(SDCard_t* card, unsigned long startBlock, unsigned long numBlocks);
 
 /**
  * @brief Sends data as part of a multiple block read
@@ -163,65 +352,232 @@ void SD_MBW_Start(unsigned long startBlock, unsigned long numBlocks);
  *      between the time that SD_MBW_Start and this function are called, no
  *      other SD card functions should be called. Otherwise, the pre-erase 
  *      configured in SD_MBW_Start may be cleared
+ * @param card Pointer to the card
  * @param arrWrite Pointer to the array of bytes to be written
  * @return 1 if successful, 0 otherwise
  */
-unsigned char SD_MBW_Send(unsigned char* arrWrite);
+unsigned char SD_MBW_Send(SDCard_t* card, unsigned char* arrWrite);
 
 /**
- * @brief Stops a multiple block write
+ * @brief Same as SD_MBW_Send, except that the 512 bytes are gathered from a
+ *        list of fragments instead of a single array. If the fragments add up
+ *        to less than 512 bytes, the rest of the block is written as 0x00
+ * @pre Same as SD_MBW_Send
+ * @param card Pointer to the card
+ * @param iov Pointer to the first fragment
+ * @param iovcnt Number of fragments
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char SD_MBW_SendV(
+    SDCard_t* card,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+);
+
+/**
+ * @brief Same as SD_MBW_Send, except that the 512 bytes are streamed straight
+ *        out of program memory using table reads
+ * @pre Same as SD_MBW_Send
+ * @param card Pointer to the card
+ * @param arrWrite Pointer to a 512 byte const array in program memory
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char SD_MBW_SendROM(SDCard_t* card, const unsigned char* arrWrite);
+
+/**
+ * @brief Stops a multiple block write. If write verification is enabled, the
+ *        number of blocks the card committed is checked against the number of
+ *        blocks it accepted using SEND_NUM_WR_BLOCKS (ACMD22). If the card
+ *        can't answer, or SD_VERIFY_READBACK is set, the blocks are read back
+ *        and their CRC is compared with the CRC of the data that was sent
  * @pre The precondition is that SD_MBW_Send called properly at least once
+ * @param card Pointer to the card
+ * @return 1 if successful (or verification is off), 0 if verification failed
+ */
+unsigned char SD_MBW_Stop(SDCard_t* card);
+
+/**
+ * @brief Suspends a multiple block write at a block boundary so that other
+ *        commands can be issued. The session state is kept, so the write can
+ *        be continued later using SD_MBW_Resume
+ * @pre The precondition is that a multiple block write has been started using
+ *      SD_MBW_Start and is not already suspended
+ * @param card Pointer to the card
  */
-void SD_MBW_Stop(void);
+void SD_MBW_Suspend(SDCard_t* card);
+
+/**
+ * @brief Resumes a suspended multiple block write with a fresh
+ *        WRITE_MULTIPLE_BLOCK command at the block after the last block
+ *        written. The pre-erase count is recalculated from the number of
+ *        blocks announced in SD_MBW_Start that have not been written yet
+ * @pre The precondition is that the multiple block write was suspended using
+ *      SD_MBW_Suspend
+ * @param card Pointer to the card
+ */
+void SD_MBW_Resume(SDCard_t* card);
+
+/**
+ * @brief Writes generated data over a range of blocks using a single multiple
+ *        block write with the whole range pre-erased. No sector buffer is
+ *        needed since the data is produced as it is sent
+ * @param card Pointer to the card
+ * @param startBlock Block number in SD card memory of the first block to fill
+ * @param numBlocks Number of blocks to fill
+ * @param gen Pointer to the data generator
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char SD_FillBlocks(
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    SD_FillGen_t* gen
+);
 
 /**
  * @brief Initiates a 512 byte read from the specified block, block, into the
  *        array of bytes, buf
+ * @param card Pointer to the card
  * @param block Block number in SD card memory to begin the read
  * @param buf Pointer to the array of bytes that data read from the card is to
  *        be stored
  * @return 1 if successful, 0 otherwise
  */
-unsigned char SD_SingleBlockRead(unsigned long block, unsigned char* buf);
+unsigned char SD_SingleBlockRead(
+    SDCard_t* card,
+    unsigned long block,
+    unsigned char* buf
+);
+
+/**
+ * @brief Same as SD_SingleBlockRead, except that the 512 bytes are scattered
+ *        into a list of fragments instead of a single array. Bytes not
+ *        covered by a fragment are discarded, so this can also be used to
+ *        pick a few bytes out of a block without a 512 byte buffer
+ * @param card Pointer to the card
+ * @param block Block number in SD card memory to read
+ * @param iov Pointer to the first fragment
+ * @param iovcnt Number of fragments
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char SD_SingleBlockReadV(
+    SDCard_t* card,
+    unsigned long block,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+);
 
 /**
  * @brief Initiates a read of the SD card, starting with the sector at address
  *        startBlock
+ * @param card Pointer to the card
  * @param startBlock Block number in SD card memory to begin the read
  * @return 1 if successful, 0 otherwise
  */
-unsigned char SD_MBR_Start(unsigned long startBlock);
+unsigned char SD_MBR_Start(SDCard_t* card, unsigned long startBlock);
 
 /**
  * @brief Receives data as part of a multiple block read
  * @pre The precondition is that a multiple block read must have been properly
  *      initialized by calling SD_MBR_Start before this function
+ * @param card Pointer to the card
  * @param bufReceive Pointer to the array that will store the data
+ * @return 1 if successful, 0 if the card sent a data error token or no block
+ *         within SD_READ_WAIT_BYTES bytes. The read must then be stopped
  */
-void SD_MBR_Receive(unsigned char* bufReceive);
+unsigned char SD_MBR_Receive(SDCard_t* card, unsigned char* bufReceive);
+
+/**
+ * @brief Same as SD_MBR_Receive, except that the 512 bytes are scattered into
+ *        a list of fragments instead of a single array. Bytes not covered by
+ *        a fragment are discarded
+ * @pre Same as SD_MBR_Receive
+ * @param card Pointer to the card
+ * @param iov Pointer to the first fragment
+ * @param iovcnt Number of fragments
+ * @return Same as SD_MBR_Receive
+ */
+unsigned char SD_MBR_ReceiveV(
+    SDCard_t* card,
+    const SD_IOVec_t* iov,
+    unsigned char iovcnt
+);
 
 /**
  * @brief Stops a multiple block read
  * @pre The precondition is that SD_MBR_Receive must have been called properly
  *      at least once
+ * @param card Pointer to the card
  */
-void SD_MBR_Stop(void);
+void SD_MBR_Stop(SDCard_t* card);
 
 /**
  * @brief Erases all the blocks between firstBlock and lastBlock, inclusive.
  *        This may take some time, during which DAT0 will be held low. Thus,
- *        users may choose to poll the SD card's response before attempting
- *        other SD card operations
+ *        users may choose to poll SD_IsBusy before attempting other SD card
+ *        operations. Large ranges are better handled by the ERASE module,
+ *        which splits them into chunks with bounded erase times
+ * @param card Pointer to the card
  * @param firstBlock Address of the first block to be erased
  * @param lastBlock Address of the last block to be erased
+ * @return 1 if the card accepted the erase, 0 otherwise
+ */
+unsigned char SD_EraseBlocks(
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock
+);
+
+/**
+ * @brief Same as SD_EraseBlocks, except that the card is told that the
+ *        contents of the blocks are no longer needed rather than that they
+ *        must be erased. The card then erases them whenever it suits it, and
+ *        their contents are undefined until they are written. Cards that do
+ *        not support discard perform a regular erase
+ * @param card Pointer to the card
+ * @param firstBlock Address of the first block to be discarded
+ * @param lastBlock Address of the last block to be discarded
+ * @return 1 if the card accepted the discard, 0 otherwise
+ */
+unsigned char SD_DiscardBlocks(
+    SDCard_t* card,
+    unsigned long firstBlock,
+    unsigned long lastBlock
+);
+
+/**
+ * @brief Checks whether the card is busy (e.g. erasing or programming)
+ *        without waiting for it
+ * @param card Pointer to the card
+ * @return 1 if the card is holding DAT0 low, 0 otherwise
+ */
+unsigned char SD_IsBusy(SDCard_t* card);
+
+/**
+ * @brief Assigns a chip select pin to a card, then drives the pin high and
+ *        makes it an output so that the card stays off the bus until it is
+ *        used. For example, SD_SetChipSelect(&card, &LATE, &TRISE, 0x04)
+ *        assigns RE2
+ * @param card Pointer to the card
+ * @param lat LAT register of the pin's port
+ * @param tris TRIS register of the pin's port
+ * @param mask Bit mask of the pin within its port
  */
-void SD_EraseBlocks(unsigned long firstBlock, unsigned long lastBlock);
+void SD_SetChipSelect(
+    SDCard_t* card,
+    volatile unsigned char* lat,
+    volatile unsigned char* tris,
+    unsigned char mask
+);
 
 /**
  * @brief This function performs the length SD card initialization command
  *        sequence
+ * @pre SD_SetChipSelect has been called for this card and for every other
+ *      card on the bus, so that none of the others respond to the commands
+ * @param card Pointer to the card
  */
-void initSD(void);
+void initSD(SDCard_t* card);
 
 /**
  * @}
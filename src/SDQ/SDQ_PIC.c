@@ -0,0 +1,303 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 18, 2026, 9:40 AM
+ *
+ * @ingroup SDQ
+ */
+
+/********************************* Includes **********************************/
+#include "SDQ_PIC.h"
+
+/********************************** Macros ***********************************/
+/**
+ * @brief Enters a section of code that must not be interrupted, saving the
+ *        global interrupt enable bit into saved
+ */
+#define sdq_lock(saved){\
+    saved = INTCONbits.GIE;\
+    INTCONbits.GIE = 0;\
+}
+
+/** @brief Leaves a section of code entered with sdq_lock */
+#define sdq_unlock(saved) INTCONbits.GIE = saved
+
+/************************ Private Function Prototypes ************************/
+static unsigned short SDQ_Take(
+    SDQ_Request_t** list,
+    unsigned long* head,
+    SDQ_Request_t** run
+);
+static void SDQ_Complete(SDQ_Request_t* req, sdq_status_e status);
+static void SDQ_Dispatch(
+    SDCard_t* card,
+    SDQ_Request_t* run,
+    unsigned short n
+);
+
+/***************************** Public Functions ******************************/
+void SDQ_Init(SDQ_Queue_t* q, SDCard_t* card){
+    q->card = card;
+    q->queue = NULL;
+    q->urgentQueue = NULL;
+    q->headBlock = 0;
+    q->mbwActive = 0;
+}
+
+unsigned char SDQ_Submit(SDQ_Queue_t* q, SDQ_Request_t* req){
+    unsigned char gie;
+    SDQ_Request_t** link;
+
+    sdq_lock(gie);
+    if(req->status == SDQ_STATUS_PENDING){
+        sdq_unlock(gie);
+        return 0;
+    }
+
+    // Insert after every request for the same or a lower block so that
+    // requests for the same block are serviced in the order they arrived
+    link = (req->prio == SDQ_PRIO_URGENT) ? &q->urgentQueue : &q->queue;
+    while((*link != NULL) && ((*link)->block <= req->block)){
+        link = &((*link)->next);
+    }
+    req->status = SDQ_STATUS_PENDING;
+    req->next = *link;
+    *link = req;
+    sdq_unlock(gie);
+
+    return 1;
+}
+
+unsigned short SDQ_Service(SDQ_Queue_t* q){
+    SDQ_Request_t* run;
+    unsigned short n;
+
+    // Urgent requests jump ahead of the sweep. Normal requests have to wait
+    // for the open multiple block write to finish
+    n = SDQ_ServiceUrgent(q);
+    if((n != 0) || q->mbwActive){
+        return n;
+    }
+
+    n = SDQ_Take(&q->queue, &q->headBlock, &run);
+    if(n != 0){
+        SDQ_Dispatch(q->card, run, n);
+    }
+
+    return n;
+}
+
+unsigned short SDQ_ServiceUrgent(SDQ_Queue_t* q){
+    SDQ_Request_t* run;
+    SDWriteState_t savedWrite;
+    unsigned long head = 0;
+    unsigned short n;
+    unsigned short total = 0;
+
+    if(q->urgentQueue == NULL){
+        return 0;
+    }
+
+    // The urgent requests are free to use the card once the open write has
+    // been stopped at the current block boundary. The write bookkeeping is
+    // restored afterwards because urgent writes overwrite it
+    if(q->mbwActive){
+        SD_MBW_Suspend(q->card);
+    }
+    savedWrite = q->card->write;
+
+    n = SDQ_Take(&q->urgentQueue, &head, &run);
+    while(n != 0){
+        SDQ_Dispatch(q->card, run, n);
+        total += n;
+        n = SDQ_Take(&q->urgentQueue, &head, &run);
+    }
+
+    q->card->write = savedWrite;
+    if(q->mbwActive){
+        SD_MBW_Resume(q->card);
+    }
+
+    return total;
+}
+
+void SDQ_MBW_Start(
+    SDQ_Queue_t* q,
+    unsigned long startBlock,
+    unsigned long numBlocks
+)
+{
+    SD_MBW_Start(q->card, startBlock, numBlocks);
+    q->mbwActive = 1;
+}
+
+unsigned char SDQ_MBW_Send(SDQ_Queue_t* q, unsigned char* arrWrite){
+    // Block boundary: give urgent requests the card before the next block
+    SDQ_ServiceUrgent(q);
+    return SD_MBW_Send(q->card, arrWrite);
+}
+
+unsigned char SDQ_MBW_Stop(SDQ_Queue_t* q){
+    q->mbwActive = 0;
+    return SD_MBW_Stop(q->card);
+}
+
+void SDQ_Flush(SDQ_Queue_t* q){
+    while(SDQ_Service(q) != 0){
+        continue;
+    }
+}
+
+unsigned char SDQ_IsEmpty(SDQ_Queue_t* q){
+    return ((q->queue == NULL) && (q->urgentQueue == NULL)) ? 1 : 0;
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Removes the next run of requests from a queue. The run begins with
+ *        the first request at or above head, or with the lowest request if
+ *        there is none, and grows for as long as the next request is for the
+ *        next block and needs the same operation
+ * @param list The queue to take the run from
+ * @param head The block the sweep continues from. Updated to the block
+ *        following the run
+ * @param run Set to the first request of the run, which is NULL-terminated
+ * @return The number of requests in the run, or 0 if the queue is empty
+ */
+static unsigned short SDQ_Take(
+    SDQ_Request_t** list,
+    unsigned long* head,
+    SDQ_Request_t** run
+)
+{
+    unsigned char gie;
+    SDQ_Request_t* prev = NULL;
+    SDQ_Request_t* first;
+    SDQ_Request_t* last;
+    unsigned short n = 1;
+
+    sdq_lock(gie);
+    if(*list == NULL){
+        sdq_unlock(gie);
+        return 0;
+    }
+
+    // Continue the sweep from where the previous run left off. Once there is
+    // nothing left above the head, start the next sweep from the lowest block
+    first = *list;
+    while((first != NULL) && (first->block < *head)){
+        prev = first;
+        first = first->next;
+    }
+    if(first == NULL){
+        prev = NULL;
+        first = *list;
+    }
+
+    last = first;
+    while((last->next != NULL) &&
+          (last->next->op == first->op) &&
+          (last->next->block == last->block + 1)){
+        last = last->next;
+        n++;
+    }
+
+    // Unlink the run so that new requests can be submitted while it is being
+    // transferred
+    if(prev == NULL){
+        *list = last->next;
+    }
+    else{
+        prev->next = last->next;
+    }
+    last->next = NULL;
+    sdq_unlock(gie);
+
+    *head = last->block + 1;
+    *run = first;
+
+    return n;
+}
+
+/**
+ * @brief Sets the status of every request from req to the end of its run
+ * @param req The first request to be completed
+ * @param status The status to complete the requests with
+ */
+static void SDQ_Complete(SDQ_Request_t* req, sdq_status_e status){
+    SDQ_Request_t* next;
+    while(req != NULL){
+        // Fetch the link first. The owner is free to resubmit the request as
+        // soon as its status changes
+        next = req->next;
+        req->status = status;
+        req = next;
+    }
+}
+
+/**
+ * @brief Transfers a run of requests for consecutive blocks
+ * @param card Pointer to the card
+ * @param run The first request in the run
+ * @param n The number of requests in the run
+ */
+static void SDQ_Dispatch(
+    SDCard_t* card,
+    SDQ_Request_t* run,
+    unsigned short n
+)
+{
+    SDQ_Request_t* req = run;
+    SDQ_Request_t* next;
+    unsigned char success;
+
+    // A lone block is cheaper as a single block command, since there is no
+    // pre-erase or stop transmission overhead
+    if(n == 1){
+        if(req->op == SDQ_OP_READ){
+            success = SD_SingleBlockRead(card, req->block, req->buf);
+        }
+        else{
+            success = SD_SingleBlockWrite(card, req->block, req->buf);
+        }
+        req->status = success ? SDQ_STATUS_DONE : SDQ_STATUS_ERROR;
+        return;
+    }
+
+    if(run->op == SDQ_OP_READ){
+        if(!SD_MBR_Start(card, run->block)){
+            SDQ_Complete(run, SDQ_STATUS_ERROR);
+            return;
+        }
+        while(req != NULL){
+            next = req->next;
+            SD_MBR_Receive(card, req->buf);
+            req->status = SDQ_STATUS_DONE;
+            req = next;
+        }
+        SD_MBR_Stop(card);
+    }
+    else{
+        // The run length is known up front, so the card can pre-erase exactly
+        // the blocks that are about to be written
+        SD_MBW_Start(card, run->block, n);
+        while(req != NULL){
+            if(!SD_MBW_Send(card, req->buf)){
+                break;
+            }
+            req = req->next;
+        }
+
+        // Verification happens when the write is stopped and covers the
+        // whole run, so none of the requests are done until then. Those from
+        // req on were never accepted by the card
+        success = SD_MBW_Stop(card);
+        while(run != req){
+            next = run->next;
+            run->status = success ? SDQ_STATUS_DONE : SDQ_STATUS_ERROR;
+            run = next;
+        }
+        SDQ_Complete(req, SDQ_STATUS_ERROR);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 18, 2026, 9:40 AM
+ *
+ * @defgroup SDQ
+ * @brief Elevator-style I/O request queue that sits in front of the SD block
+ *        API. Requests are kept sorted by block address, and requests for
+ *        consecutive blocks are merged into multiple block reads (CMD18) and
+ *        multiple block writes (CMD25). Urgent requests are able to preempt
+ *        long multiple block writes started through this module
+ * @{
+ */
+
+#ifndef SDQ_PIC_H
+#define SDQ_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Types ************************************/
+/** @brief Operations that can be queued */
+typedef enum{
+    SDQ_OP_READ = 0, /**< Read one block from the card into buf */
+    SDQ_OP_WRITE = 1 /**< Write one block from buf to the card  */
+}sdq_op_e;
+
+/** @brief Request status, doubling as the request's completion flag */
+typedef enum{
+    SDQ_STATUS_IDLE = 0,    /**< Never submitted                          */
+    SDQ_STATUS_PENDING = 1, /**< Waiting in the queue                     */
+    SDQ_STATUS_DONE = 2,    /**< Completed successfully                   */
+    SDQ_STATUS_ERROR = 3    /**< The card reported an error for the block */
+}sdq_status_e;
+
+/** @brief Request priorities */
+typedef enum{
+    SDQ_PRIO_NORMAL = 0, /**< Serviced in elevator order                    */
+    SDQ_PRIO_URGENT = 1  /**< Serviced first, suspending SDQ_MBW_* sessions */
+}sdq_prio_e;
+
+/**
+ * @brief A single-block I/O request. Requests are owned by the caller and
+ *        linked into the queue in place, so they must stay in scope until
+ *        their status leaves SDQ_STATUS_PENDING. Zero-initialize requests
+ *        before their first use
+ */
+typedef struct SDQ_Request{
+    unsigned long block;          /**< Block number to read or write */
+    unsigned char* buf;           /**< 512 byte source/destination buffer */
+    sdq_op_e op;                  /**< Read or write */
+    sdq_prio_e prio;              /**< Normal or urgent */
+    volatile sdq_status_e status; /**< Completion flag, set by the scheduler */
+    struct SDQ_Request* next;     /**< Queue linkage, used internally */
+}SDQ_Request_t;
+
+/**
+ * @brief A request queue. Each card on the bus has its own queue, since the
+ *        elevator order only makes sense within a single card
+ */
+typedef struct{
+    SDCard_t* card;              /**< The card the requests are for */
+    SDQ_Request_t* queue;        /**< Normal requests, sorted by block */
+    SDQ_Request_t* urgentQueue;  /**< Urgent requests, sorted by block */
+    unsigned long headBlock;     /**< Block following the last run */
+    unsigned char mbwActive;     /**< 1 while an SDQ_MBW_* session is open */
+}SDQ_Queue_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Prepares an empty queue for a card
+ * @param q Pointer to the queue
+ * @param card Pointer to the card the requests are for
+ */
+void SDQ_Init(SDQ_Queue_t* q, SDCard_t* card);
+
+/**
+ * @brief Adds a request to the queue, keeping the queue sorted by block
+ *        address. Requests for the same block keep their submission order.
+ *        Safe to call from an interrupt service routine
+ * @param q Pointer to the queue
+ * @param req Pointer to the request to be queued. Its block, buf and op
+ *        fields must be filled in by the caller
+ * @return 1 if the request was queued, 0 if it is already pending
+ */
+unsigned char SDQ_Submit(SDQ_Queue_t* q, SDQ_Request_t* req);
+
+/**
+ * @brief Dispatches the next run of requests. Starting from the block after
+ *        the previous run (wrapping to the lowest queued block once the end
+ *        of the queue is reached), the longest run of requests with the same
+ *        operation and consecutive block addresses is removed from the queue
+ *        and transferred using a single multiple block read or write. Urgent
+ *        requests are always dispatched before normal ones. While a session
+ *        started by SDQ_MBW_Start is open, only urgent requests are serviced
+ * @pre The SPI module has been started using sd_start
+ * @param q Pointer to the queue
+ * @return The number of requests completed (successfully or not)
+ */
+unsigned short SDQ_Service(SDQ_Queue_t* q);
+
+/**
+ * @brief Services every urgent request in the queue. If a multiple block
+ *        write started by SDQ_MBW_Start is open, it is suspended at the
+ *        current block boundary and resumed afterwards
+ * @pre The SPI module has been started using sd_start
+ * @param q Pointer to the queue
+ * @return The number of requests completed (successfully or not)
+ */
+unsigned short SDQ_ServiceUrgent(SDQ_Queue_t* q);
+
+/**
+ * @brief Starts a multiple block write that can be preempted by urgent
+ *        requests. Same as SD_MBW_Start otherwise
+ * @param q Pointer to the queue
+ * @param startBlock Block number in SD card memory to begin the write
+ * @param numBlocks Number of blocks to be written to
+ */
+void SDQ_MBW_Start(
+    SDQ_Queue_t* q,
+    unsigned long startBlock,
+    unsigned long numBlocks
+);
+
+/**
+ * @brief Services any urgent requests, then sends a block as part of a
+ *        multiple block write. The worst-case latency of an urgent request is
+ *        therefore the time taken to program one block
+ * @pre The multiple block write was started using SDQ_MBW_Start
+ * @param q Pointer to the queue
+ * @param arrWrite Pointer to the array of bytes to be written
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char SDQ_MBW_Send(SDQ_Queue_t* q, unsigned char* arrWrite);
+
+/**
+ * @brief Stops a multiple block write started using SDQ_MBW_Start
+ * @param q Pointer to the queue
+ * @return 1 if successful (or verification is off), 0 if verification failed
+ */
+unsigned char SDQ_MBW_Stop(SDQ_Queue_t* q);
+
+/**
+ * @brief Services the queue until it is empty
+ * @pre The SPI module has been started using sd_start
+ * @param q Pointer to the queue
+ */
+void SDQ_Flush(SDQ_Queue_t* q);
+
+/**
+ * @brief Checks whether any requests are waiting to be serviced
+ * @param q Pointer to the queue
+ * @return 1 if the queue is empty, 0 otherwise
+ */
+unsigned char SDQ_IsEmpty(SDQ_Queue_t* q);
+
+/**
+ * @}
+ */
+
+#endif	/* SDQ_PIC_H */
\ No newline at end of file
@@ -0,0 +1,249 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 20, 2026, 9:15 AM
+ *
+ * @ingroup STRIPE
+ */
+
+/********************************* Includes **********************************/
+#include "STRIPE_PIC.h"
+
+/************************ Private Function Prototypes ************************/
+static unsigned long STRIPE_CardShare(
+    const STRIPE_Array_t* array,
+    unsigned char card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned long* firstBlock
+);
+
+/***************************** Public Functions ******************************/
+unsigned char STRIPE_Init(
+    STRIPE_Array_t* array,
+    SDCard_t* const* cards,
+    unsigned char numCards
+)
+{
+    unsigned long minBlocks;
+
+    if((numCards == 0) || (numCards > STRIPE_MAX_CARDS)){
+        return 0;
+    }
+
+    minBlocks = cards[0]->numBlocks;
+    for(unsigned char i = 0; i < numCards; i++){
+        array->cards[i] = cards[i];
+        if(cards[i]->numBlocks < minBlocks){
+            minBlocks = cards[i]->numBlocks;
+        }
+    }
+    array->numCards = numCards;
+    array->numBlocks = minBlocks * numCards;
+    array->nextBlock = 0;
+    array->active = 0;
+    array->failed = 0;
+
+    return 1;
+}
+
+unsigned char STRIPE_SingleBlockWrite(
+    STRIPE_Array_t* array,
+    unsigned long block,
+    unsigned char* arr
+)
+{
+    if(block >= array->numBlocks){
+        return 0;
+    }
+    return SD_SingleBlockWrite(
+        array->cards[block % array->numCards],
+        block / array->numCards,
+        arr
+    );
+}
+
+unsigned char STRIPE_SingleBlockRead(
+    STRIPE_Array_t* array,
+    unsigned long block,
+    unsigned char* buf
+)
+{
+    if(block >= array->numBlocks){
+        return 0;
+    }
+    return SD_SingleBlockRead(
+        array->cards[block % array->numCards],
+        block / array->numCards,
+        buf
+    );
+}
+
+unsigned char STRIPE_MBW_Start(
+    STRIPE_Array_t* array,
+    unsigned long startBlock,
+    unsigned long numBlocks
+)
+{
+    unsigned long first;
+    unsigned long n;
+
+    if((startBlock >= array->numBlocks) ||
+       (numBlocks > array->numBlocks - startBlock)){
+        return 0;
+    }
+
+    // Open a write on every card that gets part of the range, so that each
+    // card can pre-erase exactly its own share
+    array->active = 0;
+    array->failed = 0;
+    for(unsigned char i = 0; i < array->numCards; i++){
+        n = STRIPE_CardShare(array, i, startBlock, numBlocks, &first);
+        if(n != 0){
+            SD_MBW_Start(array->cards[i], first, n);
+            array->active |= (1U << i);
+        }
+    }
+    array->nextBlock = startBlock;
+
+    return 1;
+}
+
+unsigned char STRIPE_MBW_Send(STRIPE_Array_t* array, unsigned char* arrWrite){
+    unsigned char i = (unsigned char)(array->nextBlock % array->numCards);
+    SDCard_t* card = array->cards[i];
+
+    if(array->nextBlock >= array->numBlocks){
+        return 0;
+    }
+
+    // A card that rejected a block has ended its write, and would never
+    // answer another one
+    if(array->failed & (1U << i)){
+        array->nextBlock++;
+        return 0;
+    }
+
+    // A card that got no part of the announced range (i.e. more blocks are
+    // sent than were announced) has its write opened on demand
+    if(!(array->active & (1U << i))){
+        SD_MBW_Start(card, array->nextBlock / array->numCards, 1);
+        array->active |= (1U << i);
+    }
+    array->nextBlock++;
+
+    // SD_MBW_Send waits for this card alone to finish programming its
+    // previous block. The other cards carry on programming in the meantime
+    if(!SD_MBW_Send(card, arrWrite)){
+        array->failed |= (1U << i);
+        return 0;
+    }
+
+    return 1;
+}
+
+unsigned char STRIPE_MBW_Stop(STRIPE_Array_t* array){
+    unsigned char success = (array->failed == 0) ? 1 : 0;
+
+    for(unsigned char i = 0; i < array->numCards; i++){
+        if((array->active & ~array->failed) & (1U << i)){
+            if(!SD_MBW_Stop(array->cards[i])){
+                success = 0;
+            }
+        }
+    }
+    array->active = 0;
+    array->failed = 0;
+
+    return success;
+}
+
+unsigned char STRIPE_MBR_Start(STRIPE_Array_t* array, unsigned long startBlock){
+    unsigned long first;
+    unsigned long n;
+
+    if(startBlock >= array->numBlocks){
+        return 0;
+    }
+
+    // Any range long enough to reach every card will do here, since a
+    // multiple block read has no length. Near the end of the array, the cards
+    // that the rest of it doesn't reach are left out
+    n = array->numBlocks - startBlock;
+    if(n > array->numCards){
+        n = array->numCards;
+    }
+
+    array->active = 0;
+    for(unsigned char i = 0; i < array->numCards; i++){
+        if(STRIPE_CardShare(array, i, startBlock, n, &first) == 0){
+            continue;
+        }
+        if(!SD_MBR_Start(array->cards[i], first)){
+            STRIPE_MBR_Stop(array);
+            return 0;
+        }
+        array->active |= (1U << i);
+    }
+    array->nextBlock = startBlock;
+
+    return 1;
+}
+
+unsigned char STRIPE_MBR_Receive(
+    STRIPE_Array_t* array,
+    unsigned char* bufReceive
+)
+{
+    unsigned char i = (unsigned char)(array->nextBlock % array->numCards);
+
+    if(array->nextBlock >= array->numBlocks){
+        return 0;
+    }
+    array->nextBlock++;
+
+    return SD_MBR_Receive(array->cards[i], bufReceive);
+}
+
+void STRIPE_MBR_Stop(STRIPE_Array_t* array){
+    for(unsigned char i = 0; i < array->numCards; i++){
+        if(array->active & (1U << i)){
+            SD_MBR_Stop(array->cards[i]);
+        }
+    }
+    array->active = 0;
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Works out which part of a range of logical blocks is stored on a
+ *        card
+ * @param array Pointer to the array
+ * @param card Index of the card in the array
+ * @param startBlock First logical block of the range
+ * @param numBlocks Number of logical blocks in the range
+ * @param firstBlock Set to the card's block number of the first logical block
+ *        in the range that is stored on the card
+ * @return The number of blocks in the range that are stored on the card
+ */
+static unsigned long STRIPE_CardShare(
+    const STRIPE_Array_t* array,
+    unsigned char card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned long* firstBlock
+)
+{
+    unsigned char n = array->numCards;
+    unsigned char offset;
+
+    // Distance from the start of the range to the card's first block in it
+    offset = (unsigned char)((card + n - (startBlock % n)) % n);
+    *firstBlock = (startBlock + offset) / n;
+    if(offset >= numBlocks){
+        return 0;
+    }
+
+    return (numBlocks - offset - 1) / n + 1;
+}
\ No newline at end of file
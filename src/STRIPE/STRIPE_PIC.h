@@ -0,0 +1,159 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 20, 2026, 9:15 AM
+ *
+ * @defgroup STRIPE
+ * @brief Striped (RAID-0 style) block device over two to four cards sharing
+ *        the SPI bus. Logical block n is stored on card n % numCards, at
+ *        block n / numCards. Multiple block transfers are opened on every card
+ *        at once and consecutive logical blocks are sent to the cards in turn,
+ *        so each card programs a block while the next ones are being streamed
+ *        to the others. As long as streaming a block takes less time than
+ *        programming one, the busy windows overlap and the write throughput
+ *        scales with the number of cards
+ * @{
+ */
+
+#ifndef STRIPE_PIC_H
+#define STRIPE_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Maximum number of cards in an array */
+#define STRIPE_MAX_CARDS 4
+
+/********************************** Types ************************************/
+/** @brief Striped array of cards */
+typedef struct{
+    SDCard_t* cards[STRIPE_MAX_CARDS]; /**< Member cards, in stripe order */
+    unsigned char numCards;  /**< Number of member cards */
+    unsigned long numBlocks; /**< Number of logical blocks in the array */
+    unsigned long nextBlock; /**< Logical block of the next block transferred */
+    unsigned char active;    /**< Bit i set: card i has a transfer open */
+    unsigned char failed;    /**< Bit i set: card i rejected a block of the
+                              *   multiple block write, which ended it */
+}STRIPE_Array_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Sets up a striped array. The capacity is limited by the smallest
+ *        card
+ * @pre Every card has been initialized using initSD
+ * @param array Pointer to the array
+ * @param cards Array of pointers to the member cards, in stripe order
+ * @param numCards Number of member cards (1 to STRIPE_MAX_CARDS)
+ * @return 1 if successful, 0 if the number of cards is invalid
+ */
+unsigned char STRIPE_Init(
+    STRIPE_Array_t* array,
+    SDCard_t* const* cards,
+    unsigned char numCards
+);
+
+/**
+ * @brief Writes a single logical block
+ * @param array Pointer to the array
+ * @param block Logical block number to write to
+ * @param arr Pointer to the array of bytes to be written
+ * @return 1 if successful, 0 if the block is past the end of the array or the
+ *         write failed
+ */
+unsigned char STRIPE_SingleBlockWrite(
+    STRIPE_Array_t* array,
+    unsigned long block,
+    unsigned char* arr
+);
+
+/**
+ * @brief Reads a single logical block
+ * @param array Pointer to the array
+ * @param block Logical block number to read
+ * @param buf Pointer to the array of bytes that data read is to be stored
+ * @return 1 if successful, 0 if the block is past the end of the array or the
+ *         read failed
+ */
+unsigned char STRIPE_SingleBlockRead(
+    STRIPE_Array_t* array,
+    unsigned long block,
+    unsigned char* buf
+);
+
+/**
+ * @brief Starts a multiple block write over a range of logical blocks. A
+ *        multiple block write covering its share of the range is opened on
+ *        each card, with its own pre-erase count
+ * @param array Pointer to the array
+ * @param startBlock Logical block number to begin the write
+ * @param numBlocks Number of logical blocks to be written to
+ * @return 1 if successful, 0 if the range runs past the end of the array, in
+ *         which case no write is started
+ */
+unsigned char STRIPE_MBW_Start(
+    STRIPE_Array_t* array,
+    unsigned long startBlock,
+    unsigned long numBlocks
+);
+
+/**
+ * @brief Sends the next logical block of a multiple block write. The block
+ *        goes to the card after the one the previous block went to, which has
+ *        had numCards - 1 block transfers' worth of time to finish programming
+ * @pre The multiple block write was started using STRIPE_MBW_Start
+ * @param array Pointer to the array
+ * @param arrWrite Pointer to the array of bytes to be written
+ * @return 1 if successful, 0 otherwise. Once a card has rejected a block,
+ *         every later block for that card fails without being sent, and so
+ *         does every block past the end of the array
+ */
+unsigned char STRIPE_MBW_Send(STRIPE_Array_t* array, unsigned char* arrWrite);
+
+/**
+ * @brief Stops the multiple block write on every card that hasn't rejected a
+ *        block
+ * @pre The multiple block write was started using STRIPE_MBW_Start
+ * @param array Pointer to the array
+ * @return 1 if every card succeeded (see SD_MBW_Stop), 0 if any card failed
+ *         verification or rejected a block
+ */
+unsigned char STRIPE_MBW_Stop(STRIPE_Array_t* array);
+
+/**
+ * @brief Starts a multiple block read at a logical block. A multiple block
+ *        read is opened on each card, starting at its first block at or after
+ *        startBlock
+ * @param array Pointer to the array
+ * @param startBlock Logical block number to begin the read
+ * @return 1 if successful, 0 if startBlock is past the end of the array or a
+ *         card couldn't start the read
+ */
+unsigned char STRIPE_MBR_Start(STRIPE_Array_t* array, unsigned long startBlock);
+
+/**
+ * @brief Receives the next logical block of a multiple block read
+ * @pre The multiple block read was started using STRIPE_MBR_Start
+ * @param array Pointer to the array
+ * @param bufReceive Pointer to the array that will store the data
+ * @return 1 if successful, 0 if the read has reached the end of the array or
+ *         the card failed to send the block (see SD_MBR_Receive)
+ */
+unsigned char STRIPE_MBR_Receive(
+    STRIPE_Array_t* array,
+    unsigned char* bufReceive
+);
+
+/**
+ * @brief Stops the multiple block read on every card
+ * @pre The multiple block read was started using STRIPE_MBR_Start
+ * @param array Pointer to the array
+ */
+void STRIPE_MBR_Stop(STRIPE_Array_t* array);
+
+/**
+ * @}
+ */
+
+#endif	/* STRIPE_PIC_H */
\ No newline at end of file
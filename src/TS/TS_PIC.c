@@ -0,0 +1,666 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 24, 2026, 9:15 AM
+ *
+ * @ingroup TS
+ */
+
+/********************************* Includes **********************************/
+#include <string.h>
+#include "TS_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Bytes at the start of each sector taken by the sector header */
+#define TS_HEADER 10
+
+/** @brief Blocks in each group, including its footer */
+#define TS_GROUP_BLOCKS (TS_GROUP_SECTORS + 1)
+
+/*
+ * Layout of the sector header, little-endian:
+ *   0 epoch
+ *   2 sequence number of the sector (its block number in the region)
+ *   6 records in the sector (0 for footers)
+ *   7 bytes of data per record
+ *   8 CRC16 of bytes 0 to 7
+ * Data sectors then hold records of a 4 byte timestamp followed by the data.
+ * The last block of each group is its footer, which holds the first
+ * timestamp of each of the group's data sectors. A data sector without any
+ * records takes the timestamp of the one before it
+ */
+
+/************************ Private Function Prototypes ************************/
+static void TS_SetHeader(
+    const TS_Log_t* log,
+    unsigned char* hdr,
+    unsigned long block,
+    unsigned char count
+);
+static unsigned char TS_Valid(
+    const TS_Log_t* log,
+    const unsigned char* hdr,
+    unsigned long block
+);
+static unsigned char TS_Peek(
+    TS_Log_t* log,
+    unsigned long block,
+    unsigned char* hdr,
+    unsigned short len
+);
+static unsigned char TS_Start(TS_Log_t* log);
+static void TS_Pause(TS_Log_t* log);
+static unsigned char TS_Send(TS_Log_t* log);
+static unsigned char TS_SendFooter(TS_Log_t* log);
+static void TS_AddSummary(TS_Log_t* log, unsigned long group, unsigned long t);
+static unsigned char TS_Below(
+    const unsigned long* keys,
+    unsigned char n,
+    unsigned long t
+);
+static unsigned char TS_Locate(
+    TS_Log_t* log,
+    unsigned long from,
+    unsigned long* block
+);
+
+/***************************** Public Functions ******************************/
+unsigned char TS_Format(
+    TS_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char recSize,
+    unsigned char* buf
+)
+{
+    numBlocks -= numBlocks % TS_GROUP_BLOCKS;
+    if((numBlocks == 0) || (recSize == 0) || (recSize > 200)){
+        return 0;
+    }
+
+    log->card = card;
+    log->startBlock = startBlock;
+    log->numBlocks = numBlocks;
+    log->buf = buf;
+    log->streaming = 0;
+    log->reading = 0;
+    log->recSize = recSize;
+    log->perSector = (512 - TS_HEADER) / (4 + recSize);
+
+    // The new epoch must differ from that of every sector left in the region
+    if(!TS_Peek(log, 0, buf, TS_HEADER)){
+        return 0;
+    }
+    log->epoch = 1;
+    if(TS_Valid(log, buf, 0)){
+        log->epoch = SD_Load16(&buf[0]) + 1;
+    }
+
+    log->head = 0;
+    log->lastTime = 0;
+    log->stride = 1;
+    log->summaryCount = 0;
+    log->groupFill = 0;
+    log->count = 0;
+    TS_QueryStop(log);
+
+    // An empty sector 0 discards the old data even if nothing is appended
+    return TS_Send(log) && TS_Flush(log);
+}
+
+unsigned char TS_Open(
+    TS_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char* buf
+)
+{
+    unsigned char hdr[TS_HEADER + 4];
+    unsigned long lo = 1;
+    unsigned long hi;
+    unsigned long mid;
+    unsigned long groups;
+    unsigned long block;
+    unsigned char count;
+
+    log->card = card;
+    log->startBlock = startBlock;
+    log->numBlocks = numBlocks - numBlocks % TS_GROUP_BLOCKS;
+    log->buf = buf;
+    log->streaming = 0;
+    log->reading = 0;
+    TS_QueryStop(log);
+
+    if(!TS_Peek(log, 0, hdr, TS_HEADER) || !TS_Valid(log, hdr, 0) ||
+       (hdr[7] == 0) || (hdr[7] > 200)){
+        return 0;
+    }
+    log->epoch = SD_Load16(&hdr[0]);
+    log->recSize = hdr[7];
+    log->perSector = (512 - TS_HEADER) / (4 + log->recSize);
+
+    // Written sectors form a prefix of the region
+    hi = log->numBlocks;
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(!TS_Peek(log, mid, hdr, TS_HEADER)){
+            return 0;
+        }
+        if(TS_Valid(log, hdr, mid)){
+            lo = mid + 1;
+        }
+        else{
+            hi = mid;
+        }
+    }
+    log->head = lo;
+
+    // Rebuild the summary from the footers of the complete groups
+    groups = lo / TS_GROUP_BLOCKS;
+    log->stride = 1;
+    while(groups > TS_SUMMARY_ENTRIES * log->stride){
+        log->stride *= 2;
+    }
+    log->summaryCount = 0;
+    for(unsigned long g = 0; g < groups; g += log->stride){
+        block = g * TS_GROUP_BLOCKS + TS_GROUP_SECTORS;
+        if(!TS_Peek(log, block, hdr, TS_HEADER + 4)){
+            return 0;
+        }
+        log->summary[log->summaryCount++] = SD_Load32(&hdr[TS_HEADER]);
+    }
+
+    // Rebuild the index of the current group from its data sectors
+    log->groupFill = lo % TS_GROUP_BLOCKS;
+    log->lastTime = 0;
+    block = groups * TS_GROUP_BLOCKS;
+    for(unsigned char i = 0; i < log->groupFill; i++){
+        if(!TS_Peek(log, block + i, hdr, TS_HEADER + 4)){
+            return 0;
+        }
+        log->firsts[i] = (hdr[6] != 0) ? SD_Load32(&hdr[TS_HEADER]) :
+                         log->lastTime;
+        log->lastTime = log->firsts[i];
+    }
+
+    // The last record's timestamp is the earliest one that can be appended
+    block = lo - 1;
+    if((block % TS_GROUP_BLOCKS) == TS_GROUP_SECTORS){
+        block--;
+    }
+    if(!SD_SingleBlockRead(card, startBlock + block, buf)){
+        return 0;
+    }
+    count = buf[6];
+    if(count != 0){
+        log->lastTime = SD_Load32(
+            &buf[TS_HEADER + (count - 1) * (4 + log->recSize)]
+        );
+    }
+    log->count = 0;
+
+    // Power was lost between the group's last data sector and its footer
+    if(log->groupFill == TS_GROUP_SECTORS){
+        return TS_SendFooter(log) && TS_Flush(log);
+    }
+    return 1;
+}
+
+unsigned char TS_Append(
+    TS_Log_t* log,
+    unsigned long time,
+    const unsigned char* data
+)
+{
+    unsigned char* p;
+
+    if((time < log->lastTime) || (log->head >= log->numBlocks)){
+        return 0;
+    }
+
+    // A footer the card rejected has to be sent before the next group starts
+    if((log->groupFill == TS_GROUP_SECTORS) && !TS_SendFooter(log)){
+        return 0;
+    }
+
+    p = &log->buf[TS_HEADER + log->count * (4 + log->recSize)];
+    SD_Store32(p, time);
+    memcpy(&p[4], data, log->recSize);
+    if(log->count == 0){
+        log->firsts[log->groupFill] = time;
+    }
+    log->count++;
+    log->lastTime = time;
+
+    if(log->count == log->perSector){
+        return TS_Send(log);
+    }
+    return 1;
+}
+
+unsigned char TS_Flush(TS_Log_t* log){
+    if((log->groupFill == TS_GROUP_SECTORS) && !TS_SendFooter(log)){
+        return 0;
+    }
+    if((log->count != 0) && !TS_Send(log)){
+        return 0;
+    }
+    if(log->streaming){
+        log->streaming = 0;
+        return SD_MBW_Stop(log->card);
+    }
+    return 1;
+}
+
+unsigned char TS_QueryStart(
+    TS_Log_t* log,
+    unsigned long from,
+    unsigned long to,
+    unsigned char* buf
+)
+{
+    unsigned long block;
+
+    TS_QueryStop(log);
+    log->qBuf = buf;
+    if(!TS_Locate(log, from, &block)){
+        return 0;
+    }
+
+    log->qFrom = from;
+    log->qTo = to;
+    log->qBlock = block;
+    return 1;
+}
+
+unsigned char TS_QueryNext(
+    TS_Log_t* log,
+    unsigned long* time,
+    unsigned char* data
+)
+{
+    unsigned char* buf = log->qBuf;
+    unsigned char* p;
+    unsigned long t;
+
+    while(1){
+        if(log->qRec == log->qCount){
+            if(log->qBlock >= log->head){
+                TS_QueryStop(log);
+                return 0;
+            }
+            if(!log->reading){
+                TS_Pause(log);
+                if(!SD_MBR_Start(log->card, log->startBlock + log->qBlock)){
+                    return 0;
+                }
+                log->reading = 1;
+            }
+
+            // Footers are skipped over without being stored
+            if((log->qBlock % TS_GROUP_BLOCKS) == TS_GROUP_SECTORS){
+                SD_MBR_ReceiveV(log->card, NULL, 0);
+                log->qBlock++;
+                continue;
+            }
+            SD_MBR_Receive(log->card, buf);
+            if(!TS_Valid(log, buf, log->qBlock)){
+                TS_QueryStop(log);
+                return 0;
+            }
+            log->qBlock++;
+            log->qCount = buf[6];
+            log->qRec = 0;
+            continue;
+        }
+
+        p = &buf[TS_HEADER + log->qRec * (4 + log->recSize)];
+        log->qRec++;
+        t = SD_Load32(p);
+        if(t < log->qFrom){
+            continue;
+        }
+        if(t > log->qTo){
+            TS_QueryStop(log);
+            return 0;
+        }
+
+        *time = t;
+        memcpy(data, &p[4], log->recSize);
+        return 1;
+    }
+}
+
+void TS_QueryStop(TS_Log_t* log){
+    if(log->reading){
+        SD_MBR_Stop(log->card);
+        log->reading = 0;
+    }
+    log->qBlock = log->numBlocks;
+    log->qRec = 0;
+    log->qCount = 0;
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Fills in a sector header
+ * @param log Pointer to the storage
+ * @param hdr Pointer to the TS_HEADER byte header
+ * @param block Block number of the sector in the region
+ * @param count Records in the sector
+ */
+static void TS_SetHeader(
+    const TS_Log_t* log,
+    unsigned char* hdr,
+    unsigned long block,
+    unsigned char count
+)
+{
+    unsigned short crc = 0;
+
+    SD_Store16(&hdr[0], log->epoch);
+    SD_Store32(&hdr[2], block);
+    hdr[6] = count;
+    hdr[7] = log->recSize;
+    for(unsigned char i = 0; i < 8; i++){
+        crc = SD_CRC16(crc, hdr[i]);
+    }
+    SD_Store16(&hdr[8], crc);
+}
+
+/**
+ * @brief Checks whether a sector belongs to the storage
+ * @param log Pointer to the storage. Its epoch isn't checked for block 0,
+ *        which is where the epoch is learned from
+ * @param hdr Pointer to the sector's header
+ * @param block Block number of the sector in the region
+ * @return 1 if the sector is valid, 0 otherwise
+ */
+static unsigned char TS_Valid(
+    const TS_Log_t* log,
+    const unsigned char* hdr,
+    unsigned long block
+)
+{
+    unsigned short crc = 0;
+
+    for(unsigned char i = 0; i < 8; i++){
+        crc = SD_CRC16(crc, hdr[i]);
+    }
+    if(SD_Load16(&hdr[8]) != crc){
+        return 0;
+    }
+    if(SD_Load32(&hdr[2]) != block){
+        return 0;
+    }
+    if(block == 0){
+        return 1;
+    }
+    return (SD_Load16(&hdr[0]) == log->epoch) && (hdr[7] == log->recSize);
+}
+
+/**
+ * @brief Reads the first bytes of a sector, discarding the rest of it
+ * @param log Pointer to the storage
+ * @param block Block number of the sector in the region
+ * @param hdr Pointer to the array that will store the bytes
+ * @param len Number of bytes to read
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char TS_Peek(
+    TS_Log_t* log,
+    unsigned long block,
+    unsigned char* hdr,
+    unsigned short len
+)
+{
+    SD_IOVec_t iov;
+
+    TS_Pause(log);
+    iov.base = hdr;
+    iov.len = len;
+    return SD_SingleBlockReadV(log->card, log->startBlock + block, &iov, 1);
+}
+
+/**
+ * @brief Opens a multiple block write from the head to the end of the region,
+ *        unless one is already open
+ * @param log Pointer to the storage
+ * @return 1 if successful, 0 if the region is full
+ */
+static unsigned char TS_Start(TS_Log_t* log){
+    if(log->head >= log->numBlocks){
+        return 0;
+    }
+    if(!log->streaming){
+        if(log->reading){
+            SD_MBR_Stop(log->card);
+            log->reading = 0;
+        }
+        SD_MBW_Start(
+            log->card,
+            log->startBlock + log->head,
+            log->numBlocks - log->head
+        );
+        log->streaming = 1;
+    }
+    return 1;
+}
+
+/**
+ * @brief Stops the multiple block write, if one is open, so that the card can
+ *        be read. Writing resumes with a new one
+ * @param log Pointer to the storage
+ */
+static void TS_Pause(TS_Log_t* log){
+    if(log->streaming){
+        SD_MBW_Stop(log->card);
+        log->streaming = 0;
+    }
+}
+
+/**
+ * @brief Sends the buffered data sector, followed by the group's footer if
+ *        the group is then complete
+ * @param log Pointer to the storage
+ * @return 1 if successful, 0 otherwise, in which case a rejected data sector
+ *         is dropped and a rejected footer is still pending
+ */
+static unsigned char TS_Send(TS_Log_t* log){
+    unsigned char* buf = log->buf;
+    unsigned short used = TS_HEADER + log->count * (4 + log->recSize);
+
+    if(!TS_Start(log)){
+        return 0;
+    }
+
+    if(log->count == 0){
+        log->firsts[log->groupFill] = log->lastTime;
+    }
+    TS_SetHeader(log, buf, log->head, log->count);
+    memset(&buf[used], 0, 512 - used);
+    if(!SD_MBW_Send(log->card, buf)){
+        // The card ended the multiple block write, which TS_Start reopens at
+        // the same block. The sector's records are dropped, so the buffer
+        // can't overflow on the next append
+        log->streaming = 0;
+        log->count = 0;
+        return 0;
+    }
+    log->head++;
+    log->count = 0;
+    log->groupFill++;
+
+    if(log->groupFill == TS_GROUP_SECTORS){
+        return TS_SendFooter(log);
+    }
+    return 1;
+}
+
+/**
+ * @brief Sends the footer of the current group, which is complete, and adds
+ *        the group to the summary. The sector buffer is used to build it
+ * @param log Pointer to the storage
+ * @return 1 if successful, 0 otherwise
+ */
+static unsigned char TS_SendFooter(TS_Log_t* log){
+    unsigned char* buf = log->buf;
+
+    if(!TS_Start(log)){
+        return 0;
+    }
+
+    TS_SetHeader(log, buf, log->head, 0);
+    for(unsigned char i = 0; i < TS_GROUP_SECTORS; i++){
+        SD_Store32(&buf[TS_HEADER + 4 * i], log->firsts[i]);
+    }
+    memset(
+        &buf[TS_HEADER + 4 * TS_GROUP_SECTORS],
+        0,
+        512 - TS_HEADER - 4 * TS_GROUP_SECTORS
+    );
+    if(!SD_MBW_Send(log->card, buf)){
+        // Sent again, through a new multiple block write, before any more
+        // data
+        log->streaming = 0;
+        return 0;
+    }
+    log->head++;
+    log->groupFill = 0;
+
+    TS_AddSummary(log, log->head / TS_GROUP_BLOCKS - 1, log->firsts[0]);
+    return 1;
+}
+
+/**
+ * @brief Adds a complete group to the summary if it starts a summary entry.
+ *        When the summary is full, every other entry is dropped first
+ * @param log Pointer to the storage
+ * @param group Index of the group
+ * @param t First timestamp of the group
+ */
+static void TS_AddSummary(TS_Log_t* log, unsigned long group, unsigned long t){
+    if(group != log->summaryCount * log->stride){
+        return;
+    }
+    if(log->summaryCount == TS_SUMMARY_ENTRIES){
+        for(unsigned char i = 0; i < TS_SUMMARY_ENTRIES / 2; i++){
+            log->summary[i] = log->summary[2 * i];
+        }
+        log->summaryCount = TS_SUMMARY_ENTRIES / 2;
+        log->stride *= 2;
+        if(group != log->summaryCount * log->stride){
+            return;
+        }
+    }
+    log->summary[log->summaryCount++] = t;
+}
+
+/**
+ * @brief Counts the keys that are earlier than a timestamp
+ * @param keys Pointer to the keys, in nondecreasing order
+ * @param n Number of keys
+ * @param t Timestamp
+ * @return The number of keys less than t
+ */
+static unsigned char TS_Below(
+    const unsigned long* keys,
+    unsigned char n,
+    unsigned long t
+)
+{
+    unsigned char lo = 0;
+    unsigned char hi = n;
+    unsigned char mid;
+
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(keys[mid] < t){
+            lo = mid + 1;
+        }
+        else{
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Finds the block a query starts at: the last data sector whose first
+ *        timestamp is earlier than "from", since records at "from" can only
+ *        be in that sector or later ones. The summary gives a range of
+ *        groups, whose footers are binary searched
+ * @param log Pointer to the storage
+ * @param from Earliest timestamp of the query
+ * @param block Set to the block number in the region
+ * @return 1 if successful, 0 if a footer couldn't be read
+ */
+static unsigned char TS_Locate(
+    TS_Log_t* log,
+    unsigned long from,
+    unsigned long* block
+)
+{
+    unsigned char hdr[TS_HEADER + 4];
+    unsigned long groups = log->head / TS_GROUP_BLOCKS;
+    unsigned long lo;
+    unsigned long hi;
+    unsigned long mid;
+    unsigned char k;
+
+    // The current group's index is in RAM
+    k = TS_Below(log->firsts, log->groupFill, from);
+    if(k != 0){
+        *block = groups * TS_GROUP_BLOCKS + k - 1;
+        return 1;
+    }
+
+    k = TS_Below(log->summary, log->summaryCount, from);
+    if(k == 0){
+        *block = 0;
+        return 1;
+    }
+
+    // The last group starting before "from" is between the summary's entries
+    lo = (k - 1) * log->stride;
+    hi = k * log->stride;
+    if(hi > groups){
+        hi = groups;
+    }
+    hi--;
+    while(lo < hi){
+        mid = hi - (hi - lo) / 2;
+        if(!TS_Peek(log, mid * TS_GROUP_BLOCKS + TS_GROUP_SECTORS, hdr,
+                    TS_HEADER + 4)){
+            return 0;
+        }
+        if(SD_Load32(&hdr[TS_HEADER]) < from){
+            lo = mid;
+        }
+        else{
+            hi = mid - 1;
+        }
+    }
+
+    // Then the last of its data sectors that starts before "from"
+    TS_Pause(log);
+    if(!SD_SingleBlockRead(
+            log->card,
+            log->startBlock + lo * TS_GROUP_BLOCKS + TS_GROUP_SECTORS,
+            log->qBuf
+        )
+    )
+    {
+        return 0;
+    }
+    k = 1;
+    while((k < TS_GROUP_SECTORS) &&
+          (SD_Load32(&log->qBuf[TS_HEADER + 4 * k]) < from)){
+        k++;
+    }
+    *block = lo * TS_GROUP_BLOCKS + k - 1;
+    return 1;
+}
\ No newline at end of file
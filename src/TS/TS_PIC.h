@@ -0,0 +1,198 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 24, 2026, 9:15 AM
+ *
+ * @defgroup TS
+ * @brief Time-series storage over a raw region of the card. Fixed-size
+ *        records are stored with a timestamp, which must never decrease, and
+ *        are written through a multiple block write. Every TS_GROUP_SECTORS
+ *        data sectors are followed by a footer sector listing the first
+ *        timestamp of each of them, and the first timestamp of every few
+ *        groups is kept in RAM. A time-range query narrows the range down in
+ *        RAM, binary searches the footers, and then streams the matching
+ *        sectors with a single multiple block read (CMD18), instead of
+ *        scanning the whole region.
+ *
+ *        Like the LOG module, each sector has a header with the log's epoch
+ *        and its sequence number, so the end of the data is found on boot by
+ *        binary search, and formatting bumps the epoch
+ * @{
+ */
+
+#ifndef TS_PIC_H
+#define TS_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/**
+ * @brief Data sectors indexed by each footer sector. The region is used in
+ *        groups of TS_GROUP_SECTORS + 1 blocks, which should divide the AU
+ */
+#ifndef TS_GROUP_SECTORS
+#define TS_GROUP_SECTORS 31
+#endif
+
+/**
+ * @brief Entries of the summary kept in RAM. Once the groups outnumber them,
+ *        every other entry is dropped and the summary covers twice as many
+ *        groups per entry
+ */
+#ifndef TS_SUMMARY_ENTRIES
+#define TS_SUMMARY_ENTRIES 16
+#endif
+
+/********************************** Types ************************************/
+/** @brief Time-series storage */
+typedef struct{
+    SDCard_t* card;            /**< Card holding the data */
+    unsigned long startBlock;  /**< First block of the region */
+    unsigned long numBlocks;   /**< Blocks in the region, a whole number of
+                                *   groups */
+    unsigned char* buf;        /**< 512 byte buffer for the sector being
+                                *   filled */
+    unsigned long head;        /**< Blocks written */
+    unsigned long lastTime;    /**< Timestamp of the last record */
+    unsigned long firsts[TS_GROUP_SECTORS]; /**< First timestamp of each data
+                                             *   sector of the current group */
+    unsigned long summary[TS_SUMMARY_ENTRIES]; /**< First timestamp of groups
+                                                *   0, stride, 2 * stride... */
+    unsigned long stride;      /**< Groups per summary entry */
+    unsigned char summaryCount; /**< Summary entries in use */
+    unsigned char groupFill;   /**< Data sectors written in the current
+                                *   group */
+    unsigned char count;       /**< Records in the buffered sector */
+    unsigned char perSector;   /**< Records that fit in a sector */
+    unsigned char recSize;     /**< Bytes of data per record */
+    unsigned short epoch;      /**< Epoch of the storage */
+    unsigned char streaming;   /**< 1 while a multiple block write is open */
+
+    /* Query in progress */
+    unsigned char* qBuf;       /**< 512 byte buffer for the sector being
+                                *   read */
+    unsigned long qFrom;       /**< Earliest timestamp to return */
+    unsigned long qTo;         /**< Latest timestamp to return */
+    unsigned long qBlock;      /**< Next block to read */
+    unsigned char qRec;        /**< Next record in qBuf */
+    unsigned char qCount;      /**< Records in qBuf */
+    unsigned char reading;     /**< 1 while a multiple block read is open */
+}TS_Log_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Starts new, empty storage in a region, discarding whatever was
+ *        there. An empty sector carrying the new epoch is written first
+ * @pre The card has been initialized using initSD
+ * @param log Pointer to the storage
+ * @param card Pointer to the card
+ * @param startBlock First block of the region
+ * @param numBlocks Blocks in the region. Rounded down to a whole number of
+ *        groups
+ * @param recSize Bytes of data per record, excluding the timestamp (1 to 200)
+ * @param buf Pointer to a 512 byte buffer, owned by the storage
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char TS_Format(
+    TS_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char recSize,
+    unsigned char* buf
+);
+
+/**
+ * @brief Opens the storage in a region. The end of the data is found by
+ *        binary search, the current group's index and the RAM summary are
+ *        rebuilt, and a footer that was missed because of a power failure is
+ *        written. Records are appended to a fresh sector
+ * @pre The card has been initialized using initSD
+ * @param log Pointer to the storage
+ * @param card Pointer to the card
+ * @param startBlock First block of the region
+ * @param numBlocks Blocks in the region
+ * @param buf Pointer to a 512 byte buffer, owned by the storage
+ * @return 1 if successful, 0 if the region wasn't formatted using TS_Format
+ *         or the card couldn't be read
+ */
+unsigned char TS_Open(
+    TS_Log_t* log,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char* buf
+);
+
+/**
+ * @brief Appends a record. Full sectors are sent through a multiple block
+ *        write, which is started when needed and left open
+ * @param log Pointer to the storage
+ * @param time Timestamp of the record, in any unit. No earlier than the
+ *        timestamp of the last record
+ * @param data Pointer to the recSize bytes of data
+ * @return 1 if successful, 0 if the timestamp went backwards, the region is
+ *         full or the card rejected a sector. The records of a rejected data
+ *         sector are lost, and the next append writes to the same block
+ *         through a new multiple block write
+ */
+unsigned char TS_Append(
+    TS_Log_t* log,
+    unsigned long time,
+    const unsigned char* data
+);
+
+/**
+ * @brief Sends the partly filled sector, if any, and stops the multiple block
+ *        write so that the card commits it. The rest of the sector is left
+ *        unused
+ * @param log Pointer to the storage
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char TS_Flush(TS_Log_t* log);
+
+/**
+ * @brief Starts a query for the records with timestamps from "from" to "to",
+ *        inclusive. Records still in the buffer are not included (see
+ *        TS_Flush)
+ * @param log Pointer to the storage
+ * @param from Earliest timestamp
+ * @param to Latest timestamp
+ * @param buf Pointer to a 512 byte buffer, owned by the query
+ * @return 1 if successful, 0 if the index couldn't be read
+ */
+unsigned char TS_QueryStart(
+    TS_Log_t* log,
+    unsigned long from,
+    unsigned long to,
+    unsigned char* buf
+);
+
+/**
+ * @brief Returns the next record of a query. The sectors are read with a
+ *        single multiple block read, which is opened on the first call.
+ *        Appending stops the read; the next call picks up where it left off
+ * @param log Pointer to the storage
+ * @param time Set to the timestamp of the record
+ * @param data Pointer to the array that will store the recSize bytes of data
+ * @return 1 if a record was returned, 0 once the query is done
+ */
+unsigned char TS_QueryNext(
+    TS_Log_t* log,
+    unsigned long* time,
+    unsigned char* data
+);
+
+/**
+ * @brief Ends a query, stopping its multiple block read
+ * @param log Pointer to the storage
+ */
+void TS_QueryStop(TS_Log_t* log);
+
+/**
+ * @}
+ */
+
+#endif	/* TS_PIC_H */
\ No newline at end of file
@@ -0,0 +1,325 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 25, 2026, 11:00 AM
+ *
+ * @ingroup TXN
+ */
+
+/********************************* Includes **********************************/
+#include <string.h>
+#include "TXN_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Bytes at the start of a root, before the map */
+#define TXN_HEADER 10
+
+/*
+ * Layout of a root, little-endian:
+ *   0 'T', 'X'
+ *   2 sequence number. The root with sequence number n is in slot n % 2
+ *   6 sectors in the structure
+ *   8 shadow block to look for free ones from
+ *   10 shadow block of each sector, 2 bytes each, or TXN_UNMAPPED
+ *   then CRC16 of everything before it
+ */
+
+/************************ Private Function Prototypes ************************/
+static unsigned char TXN_IsUsed(const TXN_Store_t* store, unsigned short b);
+static void TXN_MarkUsed(TXN_Store_t* store, unsigned short b);
+static void TXN_Rebuild(TXN_Store_t* store);
+static unsigned char TXN_StartRun(TXN_Store_t* store);
+
+/***************************** Public Functions ******************************/
+unsigned char TXN_Mount(
+    TXN_Store_t* store,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char numSectors
+)
+{
+    unsigned char hdr[TXN_HEADER];
+    unsigned char map[2 * TXN_MAX_SECTORS];
+    unsigned char crc[2];
+    unsigned short mapBytes = 2 * numSectors;
+    unsigned short c;
+    unsigned long seq;
+    unsigned char found = 0;
+    SD_IOVec_t iov[3];
+
+    if((numSectors == 0) || (numSectors > TXN_MAX_SECTORS) ||
+       (numBlocks < 2 + 2UL * numSectors)){
+        return 0;
+    }
+
+    store->card = card;
+    store->startBlock = startBlock;
+    store->numBlocks = (numBlocks - 2 > TXN_MAX_BLOCKS) ?
+                       TXN_MAX_BLOCKS : (unsigned short)(numBlocks - 2);
+    store->numSectors = numSectors;
+    store->active = 0;
+    store->streaming = 0;
+    store->seq = 0;
+    store->cursor = 0;
+    memset(store->map, 0xFF, sizeof(store->map));
+
+    // Take the valid root with the higher sequence number
+    iov[0].base = hdr;
+    iov[0].len = TXN_HEADER;
+    iov[1].base = map;
+    iov[1].len = mapBytes;
+    iov[2].base = crc;
+    iov[2].len = 2;
+    for(unsigned char slot = 0; slot < 2; slot++){
+        if(!SD_SingleBlockReadV(card, startBlock + slot, iov, 3)){
+            return 0;
+        }
+        if((hdr[0] != 'T') || (hdr[1] != 'X')){
+            continue;
+        }
+        c = 0;
+        for(unsigned char i = 0; i < TXN_HEADER; i++){
+            c = SD_CRC16(c, hdr[i]);
+        }
+        for(unsigned short i = 0; i < mapBytes; i++){
+            c = SD_CRC16(c, map[i]);
+        }
+        if(c != SD_Load16(crc)){
+            continue;
+        }
+        seq = (unsigned long)SD_Load16(&hdr[2]) |
+              ((unsigned long)SD_Load16(&hdr[4]) << 16);
+        if((seq % 2) != slot){
+            continue;
+        }
+        if(found && (seq < store->seq)){
+            continue;
+        }
+        if(SD_Load16(&hdr[6]) != numSectors){
+            return 0;
+        }
+        store->seq = seq;
+        store->cursor = SD_Load16(&hdr[8]);
+        memcpy(store->map, map, mapBytes);
+        found = 1;
+    }
+
+    if(store->cursor >= store->numBlocks){
+        store->cursor = 0;
+    }
+    TXN_Rebuild(store);
+    return 1;
+}
+
+unsigned char TXN_Read(
+    TXN_Store_t* store,
+    unsigned char sector,
+    unsigned char* buf
+)
+{
+    unsigned short b;
+
+    if(sector >= store->numSectors){
+        return 0;
+    }
+    b = SD_Load16(&store->map[2 * sector]);
+    if(b == TXN_UNMAPPED){
+        memset(buf, 0, 512);
+        return 1;
+    }
+    return SD_SingleBlockRead(store->card, store->startBlock + 2 + b, buf);
+}
+
+void TXN_Begin(TXN_Store_t* store, unsigned char count){
+    if(store->active){
+        TXN_Abort(store);
+    }
+    memcpy(store->pending, store->map, sizeof(store->pending));
+    store->remaining = count;
+    store->next = store->numBlocks;
+    store->active = 1;
+}
+
+unsigned char TXN_Stage(
+    TXN_Store_t* store,
+    unsigned char sector,
+    unsigned char* data
+)
+{
+    if(!store->active || (sector >= store->numSectors)){
+        return 0;
+    }
+
+    // Carry on with the open multiple block write if the next block is free,
+    // otherwise start a new one at the next free block
+    if(!store->streaming || (store->next >= store->numBlocks) ||
+       TXN_IsUsed(store, store->next)){
+        if(store->streaming){
+            store->streaming = 0;
+            if(!SD_MBW_Stop(store->card)){
+                return 0;
+            }
+        }
+        if(!TXN_StartRun(store)){
+            return 0;
+        }
+    }
+
+    if(!SD_MBW_Send(store->card, data)){
+        // The card ended the multiple block write when it rejected the
+        // block, so the next sector staged starts a new one
+        store->streaming = 0;
+        SD_MBW_Stop(store->card);
+        return 0;
+    }
+
+    // A sector staged twice leaves its first shadow block marked as used
+    // until the transaction ends
+    TXN_MarkUsed(store, store->next);
+    SD_Store16(&store->pending[2 * sector], store->next);
+    store->next++;
+    store->cursor = (store->next < store->numBlocks) ? store->next : 0;
+    if(store->remaining != 0){
+        store->remaining--;
+    }
+    return 1;
+}
+
+unsigned char TXN_Commit(TXN_Store_t* store){
+    unsigned char hdr[TXN_HEADER];
+    unsigned char crc[2];
+    unsigned short mapBytes = 2 * store->numSectors;
+    unsigned long seq = store->seq + 1;
+    unsigned short c = 0;
+    SD_IOVec_t iov[3];
+
+    if(!store->active){
+        return 0;
+    }
+
+    // The staged blocks must be on the card before the root points to them
+    if(store->streaming){
+        store->streaming = 0;
+        if(!SD_MBW_Stop(store->card)){
+            TXN_Abort(store);
+            return 0;
+        }
+    }
+
+    hdr[0] = 'T';
+    hdr[1] = 'X';
+    SD_Store16(&hdr[2], (unsigned short)seq);
+    SD_Store16(&hdr[4], (unsigned short)(seq >> 16));
+    SD_Store16(&hdr[6], store->numSectors);
+    SD_Store16(&hdr[8], store->cursor);
+    for(unsigned char i = 0; i < TXN_HEADER; i++){
+        c = SD_CRC16(c, hdr[i]);
+    }
+    for(unsigned short i = 0; i < mapBytes; i++){
+        c = SD_CRC16(c, store->pending[i]);
+    }
+    SD_Store16(crc, c);
+
+    // Overwrite the older root. The current one stays valid until this
+    // sector is written in full
+    iov[0].base = hdr;
+    iov[0].len = TXN_HEADER;
+    iov[1].base = store->pending;
+    iov[1].len = mapBytes;
+    iov[2].base = crc;
+    iov[2].len = 2;
+    if(!SD_SingleBlockWriteV(
+            store->card,
+            store->startBlock + (seq % 2),
+            iov,
+            3
+        )
+    )
+    {
+        TXN_Abort(store);
+        return 0;
+    }
+
+    store->seq = seq;
+    memcpy(store->map, store->pending, sizeof(store->map));
+    store->active = 0;
+    TXN_Rebuild(store);
+    return 1;
+}
+
+void TXN_Abort(TXN_Store_t* store){
+    if(store->streaming){
+        SD_MBW_Stop(store->card);
+        store->streaming = 0;
+    }
+    store->active = 0;
+    TXN_Rebuild(store);
+}
+
+/***************************** Private Functions *****************************/
+/**
+ * @brief Checks whether a shadow block is mapped or staged
+ * @param store Pointer to the structure
+ * @param b Shadow block
+ * @return 1 if it is, 0 if it is free
+ */
+static unsigned char TXN_IsUsed(const TXN_Store_t* store, unsigned short b){
+    return (store->used[b / 8] >> (b % 8)) & 1;
+}
+
+/**
+ * @brief Marks a shadow block as used
+ * @param store Pointer to the structure
+ * @param b Shadow block
+ */
+static void TXN_MarkUsed(TXN_Store_t* store, unsigned short b){
+    store->used[b / 8] |= (unsigned char)(1 << (b % 8));
+}
+
+/**
+ * @brief Rebuilds the used blocks from the committed map
+ * @param store Pointer to the structure
+ */
+static void TXN_Rebuild(TXN_Store_t* store){
+    unsigned short b;
+
+    memset(store->used, 0, sizeof(store->used));
+    for(unsigned char i = 0; i < store->numSectors; i++){
+        b = SD_Load16(&store->map[2 * i]);
+        if(b < store->numBlocks){
+            TXN_MarkUsed(store, b);
+        }
+    }
+}
+
+/**
+ * @brief Starts a multiple block write at the first free shadow block from
+ *        the cursor on, announcing the sectors still to be staged that fit
+ *        in the free run there. Since the shadow area has at least twice as
+ *        many blocks as the structure has sectors, there is always one
+ * @param store Pointer to the structure
+ * @return 1 if successful, 0 if no block is free
+ */
+static unsigned char TXN_StartRun(TXN_Store_t* store){
+    unsigned short b = store->cursor;
+    unsigned short run = 1;
+
+    for(unsigned short n = 0; TXN_IsUsed(store, b); n++){
+        if(n == store->numBlocks){
+            return 0;
+        }
+        b = (b + 1 < store->numBlocks) ? b + 1 : 0;
+    }
+
+    while((run < store->remaining) && (b + run < store->numBlocks) &&
+          !TXN_IsUsed(store, b + run)){
+        run++;
+    }
+
+    SD_MBW_Start(store->card, store->startBlock + 2 + b, run);
+    store->streaming = 1;
+    store->next = b;
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 25, 2026, 11:00 AM
+ *
+ * @defgroup TXN
+ * @brief Power-fail-atomic updates of a structure spanning several sectors,
+ *        using shadow paging. The structure's sectors are mapped to blocks of
+ *        a shadow area by a root sector. A transaction writes the sectors it
+ *        changes to free shadow blocks with a multiple block write, then
+ *        commits by writing a new root, with a higher sequence number and a
+ *        CRC, to whichever of the two root slots holds the older root. Until
+ *        that single sector is written the old root, and every block it maps,
+ *        is untouched, so after a power failure the structure is either
+ *        entirely old or entirely new. Each sector is written once, unlike
+ *        with a journal, and mounting only reads the two root slots
+ * @{
+ */
+
+#ifndef TXN_PIC_H
+#define TXN_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Most sectors a structure can have */
+#ifndef TXN_MAX_SECTORS
+#define TXN_MAX_SECTORS 32
+#endif
+
+/** @brief Most shadow blocks that are used. A multiple of 8 */
+#ifndef TXN_MAX_BLOCKS
+#define TXN_MAX_BLOCKS 128
+#endif
+
+/** @brief Shadow block of sectors that have never been written */
+#define TXN_UNMAPPED 0xFFFF
+
+/********************************** Types ************************************/
+/** @brief A structure updated through transactions */
+typedef struct{
+    SDCard_t* card;            /**< Card holding the structure */
+    unsigned long startBlock;  /**< Block of root slot 0. Root slot 1 follows,
+                                *   then the shadow area */
+    unsigned long seq;         /**< Sequence number of the current root */
+    unsigned short numBlocks;  /**< Blocks in the shadow area */
+    unsigned short cursor;     /**< Shadow block to look for free ones from */
+    unsigned short next;       /**< Shadow block after the last one staged */
+    unsigned char numSectors;  /**< Sectors in the structure */
+    unsigned char remaining;   /**< Sectors announced in TXN_Begin that have
+                                *   not been staged yet */
+    unsigned char active;      /**< 1 while a transaction is open */
+    unsigned char streaming;   /**< 1 while a multiple block write is open */
+    unsigned char map[2 * TXN_MAX_SECTORS];     /**< Shadow block of each
+                                                 *   sector, as committed */
+    unsigned char pending[2 * TXN_MAX_SECTORS]; /**< Shadow block of each
+                                                 *   sector, as staged */
+    unsigned char used[TXN_MAX_BLOCKS / 8];     /**< Shadow blocks that are
+                                                 *   mapped or staged */
+}TXN_Store_t;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Mounts a structure by reading the two root slots and taking the
+ *        valid one with the higher sequence number. A region without a valid
+ *        root holds a structure whose sectors read as zeros
+ * @pre The card has been initialized using initSD
+ * @param store Pointer to the structure
+ * @param card Pointer to the card
+ * @param startBlock First block of the region
+ * @param numBlocks Blocks in the region: 2 for the roots, then at least
+ *        2 * numSectors for the shadow area. Blocks beyond TXN_MAX_BLOCKS
+ *        shadow blocks are unused
+ * @param numSectors Sectors in the structure, up to TXN_MAX_SECTORS
+ * @return 1 if successful, 0 if the region is too small, the card couldn't be
+ *         read, or the root is for a structure of another size
+ */
+unsigned char TXN_Mount(
+    TXN_Store_t* store,
+    SDCard_t* card,
+    unsigned long startBlock,
+    unsigned long numBlocks,
+    unsigned char numSectors
+);
+
+/**
+ * @brief Reads a sector of the structure, as last committed
+ * @pre No transaction is open
+ * @param store Pointer to the structure
+ * @param sector Sector of the structure
+ * @param buf Pointer to the array that will store the 512 bytes
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char TXN_Read(
+    TXN_Store_t* store,
+    unsigned char sector,
+    unsigned char* buf
+);
+
+/**
+ * @brief Opens a transaction
+ * @param store Pointer to the structure
+ * @param count Number of sectors that will be staged, used to pre-erase the
+ *        shadow blocks
+ */
+void TXN_Begin(TXN_Store_t* store, unsigned char count);
+
+/**
+ * @brief Stages the new contents of a sector by writing it to a free shadow
+ *        block. Consecutive sectors are sent through the same multiple block
+ *        write for as long as the free blocks are contiguous
+ * @pre A transaction was opened using TXN_Begin
+ * @param store Pointer to the structure
+ * @param sector Sector of the structure
+ * @param data Pointer to the 512 bytes
+ * @return 1 if successful, 0 otherwise, in which case the sector can be
+ *         staged again or the transaction aborted
+ */
+unsigned char TXN_Stage(
+    TXN_Store_t* store,
+    unsigned char sector,
+    unsigned char* data
+);
+
+/**
+ * @brief Commits a transaction by stopping its multiple block write and
+ *        writing the new root. If this fails, the transaction is aborted
+ * @param store Pointer to the structure
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char TXN_Commit(TXN_Store_t* store);
+
+/**
+ * @brief Aborts a transaction. The staged shadow blocks become free again
+ * @param store Pointer to the structure
+ */
+void TXN_Abort(TXN_Store_t* store);
+
+/**
+ * @}
+ */
+
+#endif	/* TXN_PIC_H */
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 26, 2026, 9:30 AM
+ *
+ * @ingroup WINDOW
+ */
+
+/********************************* Includes **********************************/
+#include <string.h>
+#include "WINDOW_PIC.h"
+
+/***************************** Public Variables ******************************/
+WINDOW_t window = {{0}, NULL, NULL, WINDOW_NO_SECTOR, 0, 1, 0};
+
+/***************************** Public Functions ******************************/
+unsigned char WINDOW_Flush(void){
+    if(!window.dirty){
+        return 1;
+    }
+
+    for(unsigned char i = 0; i < window.numCopies; i++){
+        if(!SD_SingleBlockWrite(
+                window.card,
+                window.sector + i * window.stride,
+                window.data
+            )
+        )
+        {
+            return 0;
+        }
+    }
+    window.dirty = 0;
+
+    return 1;
+}
+
+unsigned char WINDOW_Load(
+    const void* owner,
+    SDCard_t* card,
+    unsigned long sector
+)
+{
+    if((window.owner == owner) && (window.sector == sector)){
+        return 1;
+    }
+    if(!WINDOW_Flush()){
+        return 0;
+    }
+
+    window.owner = owner;
+    window.card = card;
+    window.numCopies = 1;
+    if(!SD_SingleBlockRead(card, sector, window.data)){
+        window.sector = WINDOW_NO_SECTOR;
+        return 0;
+    }
+    window.sector = sector;
+
+    return 1;
+}
+
+void WINDOW_Claim(const void* owner, SDCard_t* card, unsigned long sector){
+    memset(window.data, 0, sizeof(window.data));
+    window.owner = owner;
+    window.card = card;
+    window.sector = sector;
+    window.numCopies = 1;
+}
+
+unsigned char WINDOW_Holds(
+    const void* owner,
+    unsigned long sector,
+    unsigned long numSectors
+)
+{
+    return (window.owner == owner) && (window.sector >= sector) &&
+           (window.sector - sector < numSectors);
+}
+
+void WINDOW_Drop(
+    const void* owner,
+    unsigned long sector,
+    unsigned long numSectors
+)
+{
+    if(WINDOW_Holds(owner, sector, numSectors)){
+        window.sector = WINDOW_NO_SECTOR;
+        window.dirty = 0;
+    }
+}
+
+void WINDOW_Reset(void){
+    window.owner = NULL;
+    window.sector = WINDOW_NO_SECTOR;
+    window.dirty = 0;
+}
\ No newline at end of file
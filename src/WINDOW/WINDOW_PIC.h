@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @author Tyler Gamvrelis
+ *
+ * Created on October 26, 2026, 9:30 AM
+ *
+ * @defgroup WINDOW
+ * @brief The 512 byte sector window that the file systems keep their metadata
+ *        in. There is one window in total, shared by every FAT and exFAT
+ *        volume, and it holds a single sector together with the volume it
+ *        belongs to. A modified sector is written back when another one is
+ *        loaded or when the window is flushed
+ * @{
+ */
+
+#ifndef WINDOW_PIC_H
+#define WINDOW_PIC_H
+
+/********************************* Includes **********************************/
+#include "../SD/SD_PIC.h"
+
+/********************************** Macros ***********************************/
+/** @brief Marks the sector window as empty */
+#define WINDOW_NO_SECTOR 0xFFFFFFFFUL
+
+/********************************** Types ************************************/
+/** @brief A sector held in RAM */
+typedef struct{
+    unsigned char data[512]; /**< Contents of the sector */
+    const void* owner;       /**< Volume the sector belongs to, or NULL */
+    SDCard_t* card;          /**< Card the sector belongs to */
+    unsigned long sector;    /**< Sector held, or WINDOW_NO_SECTOR */
+    unsigned long stride;    /**< Sectors between the copies of the sector */
+    unsigned char numCopies; /**< Copies written back, including the sector
+                              *   itself. Loading a sector sets this to 1 */
+    unsigned char dirty;     /**< 1 if data has been modified since the sector
+                              *   was loaded */
+}WINDOW_t;
+
+/***************************** Public Variables ******************************/
+/** @brief The sector window */
+extern WINDOW_t window;
+
+/************************ Public Function Prototypes *************************/
+/**
+ * @brief Writes the window back to the card if it was modified. If the
+ *        owner set numCopies, each copy is written as well
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char WINDOW_Flush(void);
+
+/**
+ * @brief Loads a sector into the window, flushing the previous one first.
+ *        Nothing is read if the window already holds the sector
+ * @param owner Volume the sector belongs to
+ * @param card Pointer to the card holding the volume
+ * @param sector Sector to load
+ * @return 1 if successful, 0 otherwise
+ */
+unsigned char WINDOW_Load(
+    const void* owner,
+    SDCard_t* card,
+    unsigned long sector
+);
+
+/**
+ * @brief Points the window at a sector whose contents are about to be
+ *        overwritten, without reading it. The window is zeroed
+ * @pre The window has been flushed
+ * @param owner Volume the sector belongs to
+ * @param card Pointer to the card holding the volume
+ * @param sector Sector the window is to hold
+ */
+void WINDOW_Claim(const void* owner, SDCard_t* card, unsigned long sector);
+
+/**
+ * @brief Checks whether the window holds one of a range of sectors
+ * @param owner Volume the range belongs to
+ * @param sector First sector of the range
+ * @param numSectors Number of sectors in the range
+ * @return 1 if it does, 0 otherwise
+ */
+unsigned char WINDOW_Holds(
+    const void* owner,
+    unsigned long sector,
+    unsigned long numSectors
+);
+
+/**
+ * @brief Discards the window if it holds one of a range of sectors that is
+ *        about to be overwritten directly on the card
+ * @param owner Volume the range belongs to
+ * @param sector First sector of the range
+ * @param numSectors Number of sectors in the range
+ */
+void WINDOW_Drop(
+    const void* owner,
+    unsigned long sector,
+    unsigned long numSectors
+);
+
+/**
+ * @brief Empties the window without writing it back, e.g. before a volume
+ *        object is mounted again
+ */
+void WINDOW_Reset(void);
+
+/**
+ * @}
+ */
+
+#endif	/* WINDOW_PIC_H */
\ No newline at end of file